@@ -75,6 +75,7 @@ bool timestamped = false;
 bool export_mdns = false;
 const char* mdns_name = "openmrn_hub";
 bool printpackets = false;
+int num_threads = 0;
 
 void usage(const char *e)
 {
@@ -84,7 +85,7 @@ void usage(const char *e)
 #if defined(__linux__)
         "[-s socketcan_interface] "
 #endif
-        "[-t] [-l]\n\n",
+        "[-t] [-l] [-e num_threads]\n\n",
         e);
     fprintf(stderr,
         "GridConnect CAN HUB.\nListens to a specific TCP port, "
@@ -109,6 +110,11 @@ void usage(const char *e)
             "\t-t prints timestamps for each packet.\n");
     fprintf(stderr,
             "\t-l print all packets.\n");
+    fprintf(stderr,
+            "\t-e num_threads   runs the TCP client connections on this many "
+            "additional threads. Only the routing of the binary packets "
+            "remains on the main hub thread. Default is 0, which runs "
+            "everything on a single thread.\n");
 #ifdef HAVE_AVAHI_CLIENT
     fprintf(stderr,
             "\t-m exports the current service on mDNS.\n");
@@ -121,7 +127,7 @@ void usage(const char *e)
 void parse_args(int argc, char *argv[])
 {
     int opt;
-    while ((opt = getopt(argc, argv, "hp:d:s:u:q:tlmn:")) >= 0)
+    while ((opt = getopt(argc, argv, "hp:d:s:u:q:tlmn:e:")) >= 0)
     {
         switch (opt)
         {
@@ -158,6 +164,9 @@ void parse_args(int argc, char *argv[])
             case 'l':
                 printpackets = true;
                 break;
+            case 'e':
+                num_threads = atoi(optarg);
+                break;
             default:
                 fprintf(stderr, "Unknown option %c\n", opt);
                 usage(argv[0]);
@@ -180,7 +189,26 @@ int appl_main(int argc, char *argv[])
         can_hub0.set_port_promiscuous(packet_printer->get_port(), true);
     }
     fprintf(stderr,"packet_printer points to %p\n",packet_printer);
-    GcTcpHub hub(&can_hub0, port);
+    std::unique_ptr<GcTcpHub> hub;
+    vector<std::unique_ptr<ExecutorBase>> port_executors;
+    vector<std::unique_ptr<Service>> port_services;
+    if (num_threads > 0)
+    {
+        vector<Service *> services;
+        for (int i = 0; i < num_threads; ++i)
+        {
+            port_executors.emplace_back(
+                new Executor<1>("port_executor", 0, 1024));
+            port_services.emplace_back(
+                new Service(port_executors.back().get()));
+            services.push_back(port_services.back().get());
+        }
+        hub.reset(new GcTcpHub(&can_hub0, port, std::move(services)));
+    }
+    else
+    {
+        hub.reset(new GcTcpHub(&can_hub0, port));
+    }
     vector<std::unique_ptr<ConnectionClient>> connections;
 
 #ifdef HAVE_AVAHI_CLIENT
@@ -0,0 +1,5 @@
+include $(OPENMRNPATH)/etc/test.mk
+
+# Same as the host tests, but the executors use the epoll based select loop
+# instead of pselect.
+CSHAREDFLAGS += -DOPENMRN_USE_EPOLL
@@ -136,12 +136,29 @@ DECLARE_CONST(directhub_port_max_incoming_packets);
 /// will allocate at least this many bytes dedicated for each input port.
 DECLARE_CONST(directhub_port_incoming_buffer_size);
 
+/// Number of bytes a single source may send to a DirectHub before it has to
+/// give way to other sources that are waiting.
+DECLARE_CONST(directhub_admission_quantum);
+
+/// Number of traffic sources for which a DirectHub keeps separate admission
+/// state. Further sources share one slot while all slots have callers waiting.
+DECLARE_CONST(directhub_admission_max_sources);
+
+/// Number of waiting callers a DirectHub can queue per traffic source without
+/// linking them into an overflow list.
+DECLARE_CONST(directhub_admission_source_backlog);
+
 /** Number of entries in the remote alias cache */
 DECLARE_CONST(remote_alias_cache_size);
 
 /** Number of entries in the local alias cache */
 DECLARE_CONST(local_alias_cache_size);
 
+/** Alias caches with at least this many entries use hash tables instead of
+ * sorted vectors for looking up aliases and Node IDs (see
+ * AliasCache::IndexType). 0 means always use the sorted vectors. */
+DECLARE_CONST(alias_cache_hash_min_entries);
+
 /** Keep this many allocated but unused aliases around. (Currently supported
  * values are 0 or 1.) */
 DECLARE_CONST(reserve_unused_alias_count);
@@ -174,6 +191,22 @@ DECLARE_CONST(enable_all_memory_space);
  * standard. */
 DECLARE_CONST(node_init_identify);
 
+/** Set to CONSTANT_TRUE to keep the configuration file in RAM (see {@ref
+ * ConfigCache}). Config reads are then served from memory, writes during a
+ * factory reset are written back in batches, and configuration updates only
+ * call the listeners whose part of the file changed. */
+DECLARE_CONST(enable_config_cache);
+
+/** Set to CONSTANT_TRUE to use the flat array-based event registry ({@ref
+ * FlatEventHandlers}) instead of the tree-based one in the EventService. */
+DECLARE_CONST(flat_event_registry);
+
+/** Set to a positive number to call the event handlers for the global and
+ * addressed identify events messages in batches of this size in a single
+ * executor turn, instead of sending each call through the EventCallerFlow. 0
+ * disables batching. */
+DECLARE_CONST(event_handler_batch_size);
+
 /** How many CAN frames should the bulk alias allocator be sending at the same
  * time. */
 DECLARE_CONST(bulk_alias_num_can_frames);
@@ -182,6 +215,20 @@ DECLARE_CONST(bulk_alias_num_can_frames);
  * StreamReceiver }. */
 DECLARE_CONST(stream_receiver_default_window_size);
 
+/** Size in bytes of the read-ahead buffer that a {@ref FileMemorySpace}
+ * allocates when a sequential (stream) read starts. 0 disables read-ahead. */
+DECLARE_CONST(file_memory_space_read_ahead);
+
+/** Set to a positive number to return the free buffers of the mainBufferPool
+ * to the heap when a bucket already has this many free entries (see
+ * DynamicPool::set_trim_watermark). 0 keeps every buffer. */
+DECLARE_CONST(main_buffer_pool_trim_watermark);
+
+/** Set to a positive number to give each thread using the mainBufferPool a
+ * cache of this many free buffers per bucket (see
+ * DynamicPool::enable_thread_cache). 0 disables the caches. */
+DECLARE_CONST(main_buffer_pool_thread_cache);
+
 /** Stack size for @ref SocketListener threads. */
 DECLARE_CONST(socket_listener_stack_size);
 
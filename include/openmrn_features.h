@@ -91,6 +91,16 @@
 #define OPENMRN_FEATURE_EXECUTOR_SELECT 1
 #endif
 
+#if defined(__linux__) && defined(OPENMRN_HAVE_PSELECT) &&                     \
+    defined(OPENMRN_USE_EPOLL)
+/// Uses ::epoll_wait in the Executor instead of ::pselect, and an eventfd
+/// instead of a signal for waking up. Selectables are then registered in O(1)
+/// and are not limited by FD_SETSIZE. Off by default; define
+/// OPENMRN_USE_EPOLL in the build (e.g. -DOPENMRN_USE_EPOLL in CXXFLAGS) to
+/// turn it on.
+#define OPENMRN_FEATURE_EXECUTOR_EPOLL 1
+#endif
+
 #if (defined(ARDUINO) && !defined(ESP_PLATFORM)) || defined(ESP_NONOS) ||      \
     defined(__EMSCRIPTEN__)
 /// A loop() function is calling the executor in the single-threaded OS context.
@@ -137,6 +147,12 @@
 #endif
 #endif
 
+#if OPENMRN_FEATURE_THREAD_PTHREAD
+/// Compile the thread-local buffer caches of DynamicPool (uses C++11
+/// thread_local).
+#define OPENMRN_FEATURE_BUFFER_THREAD_CACHE 1
+#endif
+
 #if defined(__linux__) || defined(__MACH__) || defined(__FreeRTOS__) ||        \
     defined(ESP_PLATFORM)
 /// Compiles support for BSD sockets API.
@@ -171,11 +187,36 @@
 
 #endif
 
+#if defined(__linux__) || defined(__MACH__)
+/// Compiles support for positional file I/O (pread/pwrite) in
+/// FileMemorySpace. Elsewhere lseek + read/write is used.
+#define OPENMRN_FEATURE_PREAD_PWRITE 1
+#endif
+
+#if defined(__linux__)
+/// Compiles support for memory-mapping files and passing access pattern hints
+/// to the kernel (mmap, madvise, posix_fadvise) in FileMemorySpace.
+#define OPENMRN_FEATURE_FILE_MMAP 1
+#endif
+
 #if !defined(__MACH__)
 /// Compiles support for calling reboot() in ConfigUpdateFlow.hxx and
 /// MemoryConfig.cxx.
 #define OPENMRN_FEATURE_REBOOT 1
 #endif
 
+#ifndef OPENMRN_PAYLOAD_INLINE_SIZE
+#if defined(__FreeRTOS__) || defined(ESP_PLATFORM) || defined(ARDUINO) ||      \
+    defined(ESP_NONOS)
+/// Number of bytes an openlcb::Payload stores without a heap allocation. This
+/// is part of every GenMessage, so on MCUs it is off and all payloads go to
+/// the heap. May be overridden on the command line.
+#define OPENMRN_PAYLOAD_INLINE_SIZE 0
+#else
+/// Number of bytes an openlcb::Payload stores without a heap allocation. On
+/// hosts this fits the longest datagram.
+#define OPENMRN_PAYLOAD_INLINE_SIZE 72
+#endif
+#endif
 
 #endif // _INCLUDE_OPENMRN_FEATURES_
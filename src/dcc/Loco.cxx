@@ -80,15 +80,6 @@ unsigned DccPayloadBase::get_fn_update_code(unsigned address)
 template <class Payload>
 void DccTrain<Payload>::get_next_packet(unsigned code, Packet *packet)
 {
-    packet->start_dcc_packet();
-    if (this->p.isShortAddress_)
-    {
-        packet->add_dcc_address(DccShortAddress(this->p.address_));
-    }
-    else
-    {
-        packet->add_dcc_address(DccLongAddress(this->p.address_));
-    }
     if (code == REFRESH)
     {
         code = MIN_REFRESH + this->p.nextRefresh_++;
@@ -96,11 +87,27 @@ void DccTrain<Payload>::get_next_packet(unsigned code, Packet *packet)
         {
             this->p.nextRefresh_ = 0;
         }
+        encode_packet(code, packet);
     }
     else
     {
+        encode_packet(code, packet);
         // User action. Up repeat count.
-        packet->packet_header.rept_count = 2;
+        packet->packet_header.rept_count = code == ESTOP ? 3 : 2;
+    }
+}
+
+template <class Payload>
+void DccTrain<Payload>::encode_packet(unsigned code, Packet *packet)
+{
+    packet->start_dcc_packet();
+    if (this->p.isShortAddress_)
+    {
+        packet->add_dcc_address(DccShortAddress(this->p.address_));
+    }
+    else
+    {
+        packet->add_dcc_address(DccLongAddress(this->p.address_));
     }
     switch (code)
     {
@@ -143,7 +150,6 @@ void DccTrain<Payload>::get_next_packet(unsigned code, Packet *packet)
         case ESTOP:
         {
             this->p.add_dcc_estop_to_packet(packet);
-            packet->packet_header.rept_count = 3;
             return;
         }
         default:
@@ -163,6 +169,28 @@ void DccTrain<Payload>::get_next_packet(unsigned code, Packet *packet)
     }
 }
 
+template <class Payload>
+void CachingDccTrain<Payload>::encode_packet(unsigned code, Packet *packet)
+{
+    unsigned slot = code - MIN_REFRESH;
+    if (slot >= NUM_CACHED)
+    {
+        DccTrain<Payload>::encode_packet(code, packet);
+        return;
+    }
+    if (this->p.cacheValid_ & (1u << slot))
+    {
+        // The direction change flag needs no clearing here: set_speed also
+        // invalidates the cache, so the first speed packet after it is always
+        // encoded.
+        cache_[slot].load(packet);
+        return;
+    }
+    DccTrain<Payload>::encode_packet(code, packet);
+    cache_[slot].store(*packet);
+    this->p.cacheValid_ |= (1u << slot);
+}
+
 MMOldTrain::MMOldTrain(MMAddress a)
 {
     p.address_ = a.value;
@@ -276,6 +304,8 @@ void MMNewTrain::get_next_packet(unsigned code, Packet *packet)
 void createtrains() {
     Dcc28Train train1(DccShortAddress(1));
     Dcc128Train train2(DccShortAddress(1));
+    CachingDcc28Train train5(DccShortAddress(1));
+    CachingDcc128Train train6(DccShortAddress(1));
     MMNewTrain train3(MMAddress(1));
     MMOldTrain train4(MMAddress(1));
 }
@@ -123,6 +123,7 @@ public:
         }
         p.lastSetSpeed_ = new_speed;
         p.isEstop_ = false;
+        p.invalidate_packet_cache();
         unsigned previous_light = get_effective_f0();
         if (speed.direction() != p.direction_)
         {
@@ -180,6 +181,7 @@ public:
     /// Sets the train to ESTOP state, generating an emergency stop packet.
     void set_emergencystop() OVERRIDE
     {
+        p.invalidate_packet_cache();
         p.speed_ = 0;
         p.isEstop_ = true;
         SpeedType dir0;
@@ -201,6 +203,7 @@ public:
     void set_fn(uint32_t address, uint16_t value) OVERRIDE
     {
         const uint32_t virtf0 = config_dcc_virtual_f0_offset();
+        p.invalidate_packet_cache();
         if (address == 0 && p.f0SetDirectional_)
         {
             if (p.direction_ == 0)
@@ -392,6 +395,16 @@ struct DccPayloadBase
     /// f29-f68 state.
     uint8_t fhi_[5];
 
+    /// Bit N is set if the encoded refresh packet for code MIN_REFRESH + N
+    /// is valid in the packet cache of a CachingDccTrain.
+    uint8_t cacheValid_ : 4;
+
+    /// Marks all cached packets as stale. Called on every state change.
+    void invalidate_packet_cache()
+    {
+        cacheValid_ = 0;
+    }
+
     /// @return the largest function number supported by this train
     /// (inclusive).
     static unsigned get_max_fn()
@@ -514,6 +527,12 @@ public:
     /// requested by the previous cycle or the on-update notification). @param
     /// packet needs to be filled in for the output.
     void get_next_packet(unsigned code, Packet *packet) OVERRIDE;
+
+protected:
+    /// Encodes the packet for a given update code from the current train
+    /// state, with no repeats. @param code is the packet code, not REFRESH.
+    /// @param packet will be filled in.
+    virtual void encode_packet(unsigned code, Packet *packet);
 };
 
 /// TrainImpl class for a 28-speed-step DCC locomotive.
@@ -551,6 +570,80 @@ struct Dcc128Payload : public DccPayloadBase
 /// TrainImpl class for a 128-speed-step DCC locomotive.
 typedef DccTrain<Dcc128Payload> Dcc128Train;
 
+/// Stores the wire bytes of one encoded DCC packet.
+struct EncodedDccPacket
+{
+    /// Longest packet that can be stored: long address, 128-step speed and
+    /// the EC byte.
+    static constexpr unsigned MAX_LEN = 5;
+
+    /// Saves the encoded bytes. @param pkt is a DCC packet with the checksum
+    /// already added.
+    void store(const Packet &pkt)
+    {
+        HASSERT(pkt.dlc <= MAX_LEN);
+        header_ = pkt.header_raw_data;
+        dlc_ = pkt.dlc;
+        memcpy(payload_, pkt.payload, MAX_LEN);
+    }
+
+    /// Restores the saved packet. @param pkt will be filled in.
+    void load(Packet *pkt) const
+    {
+        pkt->header_raw_data = header_;
+        pkt->dlc = dlc_;
+        memcpy(pkt->payload, payload_, MAX_LEN);
+    }
+
+    /// Packet header byte.
+    uint8_t header_;
+    /// Number of payload bytes.
+    uint8_t dlc_;
+    /// Payload bytes, including EC.
+    uint8_t payload_[MAX_LEN];
+};
+
+/// DCC locomotive that keeps the encoded form of its background refresh
+/// packets (speed, F0-F4, F5-F8, F9-F12), so that refreshing an unchanged
+/// state is a copy instead of re-encoding the packet and its checksum. The
+/// cache is invalidated by every set_speed, set_fn and set_emergencystop
+/// call. Costs 28 bytes of RAM per train (plus alignment) on top of
+/// DccTrain.
+template <class Payload> class CachingDccTrain : public DccTrain<Payload>
+{
+public:
+    /// Constructor. @param a is the address.
+    CachingDccTrain(DccShortAddress a)
+        : DccTrain<Payload>(a)
+    {
+    }
+
+    /// Constructor. @param a is the address.
+    CachingDccTrain(DccLongAddress a)
+        : DccTrain<Payload>(a)
+    {
+    }
+
+protected:
+    /// Encodes the packet for a given update code, or fetches it from the
+    /// cache. @param code is the packet code, not REFRESH. @param packet will
+    /// be filled in.
+    void encode_packet(unsigned code, Packet *packet) override;
+
+private:
+    /// Number of update codes that are cached.
+    static constexpr unsigned NUM_CACHED = MAX_REFRESH - MIN_REFRESH + 1;
+    static_assert(NUM_CACHED <= 4, "cacheValid_ bits too narrow");
+
+    /// Encoded packets, indexed by update code - MIN_REFRESH.
+    EncodedDccPacket cache_[NUM_CACHED];
+};
+
+/// 28-speed-step DCC locomotive with a refresh packet cache.
+typedef CachingDccTrain<Dcc28Payload> CachingDcc28Train;
+/// 128-speed-step DCC locomotive with a refresh packet cache.
+typedef CachingDccTrain<Dcc128Payload> CachingDcc128Train;
+
 /// Structure defining the volatile state for a Marklin-Motorola v1 protocol
 /// locomotive (with 14 speed steps, one function and relative direction only).
 struct MMOldPayload
@@ -620,6 +713,12 @@ struct MMOldPayload
         return (fn_ & (1u << idx)) != 0;
     }
     
+    /// Packets are not cached for MM trains, since their generation is
+    /// stateful.
+    void invalidate_packet_cache()
+    {
+    }
+
     /** @return the update code to send to the packet handler for a given
      * function value change. @param address is ignored */
     unsigned get_fn_update_code(unsigned address)
@@ -721,6 +820,12 @@ struct MMNewPayload
         return (fn_ & (1u << idx)) != 0;
     }
 
+    /// Packets are not cached for MM trains, since their generation is
+    /// stateful.
+    void invalidate_packet_cache()
+    {
+    }
+
     /** @return the update code to send to the packet handler for a given
      * function value change. @param address is the function number (0..4) */
     unsigned get_fn_update_code(unsigned address)
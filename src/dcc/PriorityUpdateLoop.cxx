@@ -0,0 +1,575 @@
+/** \copyright
+ * Copyright (c) 2026, OpenMRN contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file PriorityUpdateLoop.cxx
+ *
+ * Command station update loop that sends user-action packets ahead of the
+ * background refresh.
+ *
+ * @author OpenMRN contributors
+ * @date 17 Oct 2026
+ */
+
+#include "dcc/PriorityUpdateLoop.hxx"
+
+#include <algorithm>
+
+#include "dcc/PacketSource.hxx"
+
+namespace dcc
+{
+
+/// Duration of a DCC '1' bit.
+static constexpr long long DCC_ONE_NSEC = USEC_TO_NSEC(116);
+/// Duration of a DCC '0' bit.
+static constexpr long long DCC_ZERO_NSEC = USEC_TO_NSEC(200);
+/// Number of preamble bits of a regular DCC packet.
+static constexpr unsigned DCC_PREAMBLE_BITS = 16;
+/// Number of preamble bits of a service mode packet.
+static constexpr unsigned DCC_LONG_PREAMBLE_BITS = 22;
+/// Time of the RailCom cutout after a DCC packet.
+static constexpr long long RAILCOM_CUTOUT_NSEC = USEC_TO_NSEC(464);
+/// Duration of a Marklin-Motorola bit.
+static constexpr long long MM_BIT_NSEC = USEC_TO_NSEC(208);
+/// Pause after each Marklin-Motorola packet pair.
+static constexpr long long MM_PAUSE_NSEC = USEC_TO_NSEC(6000);
+/// Upper bound on the accumulated urgent budget. Determines how long a burst
+/// of user-action packets can take over the track.
+static constexpr long long MAX_URGENT_BUDGET_NSEC = MSEC_TO_NSEC(100);
+
+constexpr long long PriorityUpdateLoop::MIN_GAP_NSEC;
+
+PriorityUpdateLoop::PriorityUpdateLoop(Service *service, TrackIf *track_send)
+    : StateFlow(service)
+    , trackSend_(track_send)
+    , inbox_(config_dcc_update_loop_urgent_queue_size())
+    , incoming_(config_dcc_update_loop_urgent_queue_size())
+    , repeats_(config_dcc_update_loop_repeat_slots())
+    , urgentBudget_(MAX_URGENT_BUDGET_NSEC)
+{
+    urgent_.reserve(config_dcc_update_loop_urgent_queue_size());
+    for (auto &r : repeats_)
+    {
+        r.source_ = nullptr;
+    }
+}
+
+PriorityUpdateLoop::~PriorityUpdateLoop()
+{
+    while (changes_)
+    {
+        SourceChange *c = changes_;
+        changes_ = c->next_;
+        delete c;
+    }
+    while (exclusive_)
+    {
+        ExclusiveSource *e = exclusive_;
+        exclusive_ = e->next_;
+        delete e;
+    }
+}
+
+long long PriorityUpdateLoop::packet_duration(const Packet &pkt)
+{
+    long long d;
+    if (pkt.packet_header.is_marklin)
+    {
+        // Marklin packets are sent twice, followed by a pause.
+        d = 2 * pkt.dlc * 8 * MM_BIT_NSEC + MM_PAUSE_NSEC;
+    }
+    else
+    {
+        unsigned bytes = pkt.dlc;
+        unsigned data_ones = 0;
+        uint8_t ec = 0;
+        for (unsigned i = 0; i < pkt.dlc; ++i)
+        {
+            data_ones += __builtin_popcount(pkt.payload[i]);
+            ec ^= pkt.payload[i];
+        }
+        if (!pkt.packet_header.skip_ec)
+        {
+            ++bytes;
+            data_ones += __builtin_popcount(ec);
+        }
+        unsigned preamble = pkt.packet_header.send_long_preamble
+            ? DCC_LONG_PREAMBLE_BITS
+            : DCC_PREAMBLE_BITS;
+        // Preamble, data ones and the packet end bit.
+        unsigned ones = preamble + data_ones + 1;
+        // Data zeros and the start bit before each byte.
+        unsigned zeros = bytes * 8 - data_ones + bytes;
+        d = ones * DCC_ONE_NSEC + zeros * DCC_ZERO_NSEC + RAILCOM_CUTOUT_NSEC;
+    }
+    return d * (1 + pkt.packet_header.rept_count);
+}
+
+PriorityUpdateLoop::SourceInfo *PriorityUpdateLoop::find_source(
+    PacketSource *source)
+{
+    for (auto &s : sources_)
+    {
+        if (s.source_ == source)
+        {
+            return &s;
+        }
+    }
+    return nullptr;
+}
+
+bool PriorityUpdateLoop::add_refresh_source(
+    dcc::PacketSource *source, unsigned priority)
+{
+    // Allocations happen before taking the lock.
+    SourceChange *c = new SourceChange;
+    c->source_ = source;
+    c->priority_ = priority;
+    c->add_ = true;
+    ExclusiveSource *e = nullptr;
+    if (priority >= EXCLUSIVE_MIN_PRIORITY)
+    {
+        e = new ExclusiveSource;
+        e->source_ = source;
+        e->priority_ = priority;
+    }
+    AtomicHolder h(this);
+    c->next_ = changes_;
+    changes_ = c;
+    if (e)
+    {
+        e->next_ = exclusive_;
+        exclusive_ = e;
+    }
+    for (ExclusiveSource *x = exclusive_; x; x = x->next_)
+    {
+        if (x->priority_ > priority)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void PriorityUpdateLoop::remove_refresh_source(dcc::PacketSource *source)
+{
+    SourceChange *c = new SourceChange;
+    c->source_ = source;
+    c->priority_ = 0;
+    c->add_ = false;
+    ExclusiveSource *removed = nullptr;
+    bool busy;
+    {
+        AtomicHolder h(this);
+        c->next_ = changes_;
+        changes_ = c;
+        for (ExclusiveSource **pp = &exclusive_; *pp;)
+        {
+            ExclusiveSource *e = *pp;
+            if (e->source_ == source)
+            {
+                *pp = e->next_;
+                e->next_ = removed;
+                removed = e;
+            }
+            else
+            {
+                pp = &e->next_;
+            }
+        }
+        busy = busySource_ == source;
+    }
+    while (removed)
+    {
+        ExclusiveSource *e = removed;
+        removed = e->next_;
+        delete e;
+    }
+    if (busy)
+    {
+        // The flow is calling this source right now. The caller may delete
+        // the source after we return, so we wait for the call to finish.
+        OSSem sem;
+        {
+            AtomicHolder h(this);
+            if (busySource_ != source)
+            {
+                return;
+            }
+            HASSERT(!busyWaiter_);
+            busyWaiter_ = &sem;
+        }
+        sem.wait();
+    }
+}
+
+void PriorityUpdateLoop::notify_update(PacketSource *source, unsigned code)
+{
+    AtomicHolder h(this);
+    for (unsigned i = 0; i < inboxCount_; ++i)
+    {
+        const Urgent &u = inbox_[(inboxHead_ + i) % inbox_.size()];
+        if (u.source_ == source && u.code_ == code)
+        {
+            // Already pending; the packet will be generated from the current
+            // state anyway.
+            return;
+        }
+    }
+    if (inboxCount_ >= inbox_.size())
+    {
+        // The background refresh will get to it.
+        return;
+    }
+    Urgent &u = inbox_[(inboxHead_ + inboxCount_) % inbox_.size()];
+    u.source_ = source;
+    u.code_ = code;
+    ++inboxCount_;
+}
+
+void PriorityUpdateLoop::apply_pending()
+{
+    SourceChange *changes;
+    unsigned num_incoming;
+    {
+        AtomicHolder h(this);
+        changes = changes_;
+        changes_ = nullptr;
+        num_incoming = inboxCount_;
+        for (unsigned i = 0; i < num_incoming; ++i)
+        {
+            incoming_[i] = inbox_[(inboxHead_ + i) % inbox_.size()];
+        }
+        inboxHead_ = (inboxHead_ + num_incoming) % inbox_.size();
+        inboxCount_ = 0;
+    }
+    // The list is newest first; reverses it to apply the changes in order.
+    SourceChange *ordered = nullptr;
+    while (changes)
+    {
+        SourceChange *c = changes;
+        changes = c->next_;
+        c->next_ = ordered;
+        ordered = c;
+    }
+    while (ordered)
+    {
+        SourceChange *c = ordered;
+        ordered = c->next_;
+        if (c->add_)
+        {
+            SourceInfo info;
+            info.source_ = c->source_;
+            info.priority_ = c->priority_;
+            // New sources are the most overdue ones.
+            info.lastEnd_ = trackTime_ - MIN_GAP_NSEC;
+            sources_.push_back(info);
+        }
+        else
+        {
+            PacketSource *source = c->source_;
+            sources_.erase(std::remove_if(sources_.begin(), sources_.end(),
+                               [source](const SourceInfo &s)
+                               { return s.source_ == source; }),
+                sources_.end());
+            urgent_.erase(std::remove_if(urgent_.begin(), urgent_.end(),
+                              [source](const Urgent &u)
+                              { return u.source_ == source; }),
+                urgent_.end());
+            for (auto &r : repeats_)
+            {
+                if (r.source_ == source)
+                {
+                    r.source_ = nullptr;
+                }
+            }
+        }
+        delete c;
+    }
+    for (unsigned i = 0; i < num_incoming; ++i)
+    {
+        const Urgent &in = incoming_[i];
+        if (!find_source(in.source_))
+        {
+            // Unregistered sources do not get packets.
+            continue;
+        }
+        // Outdated copies of this packet must not be repeated anymore.
+        for (auto &r : repeats_)
+        {
+            if (r.source_ == in.source_ && r.code_ == in.code_)
+            {
+                r.source_ = nullptr;
+            }
+        }
+        bool pending = false;
+        for (auto &u : urgent_)
+        {
+            if (u.source_ == in.source_ && u.code_ == in.code_)
+            {
+                pending = true;
+                break;
+            }
+        }
+        if (pending ||
+            urgent_.size() >=
+                (size_t)config_dcc_update_loop_urgent_queue_size())
+        {
+            continue;
+        }
+        urgent_.push_back(in);
+    }
+}
+
+bool PriorityUpdateLoop::call_source(PacketSource *source, unsigned code)
+{
+    {
+        AtomicHolder h(this);
+        for (SourceChange *c = changes_; c; c = c->next_)
+        {
+            if (!c->add_ && c->source_ == source)
+            {
+                // Removed since apply_pending(); may be deleted already.
+                return false;
+            }
+        }
+        busySource_ = source;
+    }
+    source->get_next_packet(code, message()->data());
+    OSSem *waiter;
+    {
+        AtomicHolder h(this);
+        busySource_ = nullptr;
+        waiter = busyWaiter_;
+        busyWaiter_ = nullptr;
+    }
+    if (waiter)
+    {
+        waiter->post();
+    }
+    return true;
+}
+
+PriorityUpdateLoop::SourceInfo *PriorityUpdateLoop::fill_exclusive()
+{
+    SourceInfo *excl = nullptr;
+    for (auto &s : sources_)
+    {
+        if (s.priority_ >= EXCLUSIVE_MIN_PRIORITY &&
+            (!excl || s.priority_ > excl->priority_))
+        {
+            excl = &s;
+        }
+    }
+    if (!excl)
+    {
+        return nullptr;
+    }
+    unsigned code = 0;
+    for (unsigned i = 0; i < urgent_.size(); ++i)
+    {
+        if (urgent_[i].source_ == excl->source_)
+        {
+            code = urgent_[i].code_;
+            urgent_.erase(urgent_.begin() + i);
+            break;
+        }
+    }
+    if (!call_source(excl->source_, code))
+    {
+        return nullptr;
+    }
+    return excl;
+}
+
+PriorityUpdateLoop::SourceInfo *PriorityUpdateLoop::fill_urgent()
+{
+    for (unsigned i = 0; i < urgent_.size(); ++i)
+    {
+        SourceInfo *info = find_source(urgent_[i].source_);
+        // Removed sources are purged from the queue.
+        HASSERT(info);
+        if (!gap_ok(info))
+        {
+            continue;
+        }
+        unsigned code = urgent_[i].code_;
+        urgent_.erase(urgent_.begin() + i);
+        if (!call_source(info->source_, code))
+        {
+            return nullptr;
+        }
+        schedule_repeat(info->source_, code);
+        return info;
+    }
+    return nullptr;
+}
+
+void PriorityUpdateLoop::schedule_repeat(PacketSource *source, unsigned code)
+{
+    Packet *pkt = message()->data();
+    unsigned count = pkt->packet_header.rept_count;
+    if (count > (unsigned)config_dcc_update_loop_max_repeat())
+    {
+        count = config_dcc_update_loop_max_repeat();
+    }
+    pkt->packet_header.rept_count = count;
+    if (!count)
+    {
+        return;
+    }
+    for (auto &r : repeats_)
+    {
+        if (!r.source_)
+        {
+            // We send the packet only once now, and the copies later.
+            pkt->packet_header.rept_count = 0;
+            r.packet_ = *pkt;
+            r.source_ = source;
+            r.code_ = code;
+            r.remaining_ = count;
+            return;
+        }
+    }
+    // No free slot: the track driver repeats the packet back-to-back.
+}
+
+PriorityUpdateLoop::SourceInfo *PriorityUpdateLoop::fill_repeat()
+{
+    for (auto &r : repeats_)
+    {
+        if (!r.source_)
+        {
+            continue;
+        }
+        SourceInfo *info = find_source(r.source_);
+        HASSERT(info);
+        if (!gap_ok(info))
+        {
+            continue;
+        }
+        *message()->data() = r.packet_;
+        if (--r.remaining_ == 0)
+        {
+            r.source_ = nullptr;
+        }
+        return info;
+    }
+    return nullptr;
+}
+
+PriorityUpdateLoop::SourceInfo *PriorityUpdateLoop::fill_refresh()
+{
+    SourceInfo *best = nullptr;
+    long long best_age = 0;
+    for (auto &s : sources_)
+    {
+        if (!gap_ok(&s))
+        {
+            continue;
+        }
+        // Higher priority sources age faster.
+        long long age = (trackTime_ - s.lastEnd_) * (1 + s.priority_);
+        if (!best || age > best_age)
+        {
+            best = &s;
+            best_age = age;
+        }
+    }
+    if (best && !call_source(best->source_, 0))
+    {
+        return nullptr;
+    }
+    return best;
+}
+
+StateFlowBase::Action PriorityUpdateLoop::entry()
+{
+    apply_pending();
+    bool urgent = false;
+    SourceInfo *info = fill_exclusive();
+    if (!info)
+    {
+        // When the urgent packets have used up their share of the track
+        // time, the background refresh goes first.
+        bool urgent_first = urgentBudget_ > 0;
+        if (urgent_first)
+        {
+            info = fill_urgent();
+            if (!info)
+            {
+                info = fill_repeat();
+            }
+            urgent = info != nullptr;
+        }
+        if (!info)
+        {
+            info = fill_refresh();
+        }
+        if (!info && !urgent_first)
+        {
+            info = fill_urgent();
+            if (!info)
+            {
+                info = fill_repeat();
+            }
+            urgent = info != nullptr;
+        }
+    }
+    if (!info)
+    {
+        // Nothing to send (or too early to send to anyone).
+        message()->data()->set_dcc_idle();
+    }
+    long long d = packet_duration(*message()->data());
+    trackTime_ += d;
+    if (info)
+    {
+        info->lastEnd_ = trackTime_;
+    }
+    unsigned percent = config_dcc_update_loop_urgent_percent();
+    if (percent >= 100)
+    {
+        urgentBudget_ = MAX_URGENT_BUDGET_NSEC;
+    }
+    else if (urgent)
+    {
+        urgentBudget_ -= d;
+    }
+    else
+    {
+        urgentBudget_ += d * percent / (100 - percent);
+        if (urgentBudget_ > MAX_URGENT_BUDGET_NSEC)
+        {
+            urgentBudget_ = MAX_URGENT_BUDGET_NSEC;
+        }
+    }
+    // We pass on the filled packet to the track processor.
+    trackSend_->send(transfer_message());
+    return exit();
+}
+
+} // namespace dcc
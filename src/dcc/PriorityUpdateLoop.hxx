@@ -0,0 +1,289 @@
+/** \copyright
+ * Copyright (c) 2026, OpenMRN contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file PriorityUpdateLoop.hxx
+ *
+ * Command station update loop that sends user-action packets ahead of the
+ * background refresh.
+ *
+ * @author OpenMRN contributors
+ * @date 17 Oct 2026
+ */
+
+#ifndef _DCC_PRIORITYUPDATELOOP_HXX_
+#define _DCC_PRIORITYUPDATELOOP_HXX_
+
+#include <vector>
+
+#include "dcc/Packet.hxx"
+#include "dcc/UpdateLoop.hxx"
+#include "executor/StateFlow.hxx"
+#include "os/OS.hxx"
+#include "utils/constants.hxx"
+
+/// Maximum number of pending notify_update calls in the PriorityUpdateLoop.
+DECLARE_CONST(dcc_update_loop_urgent_queue_size);
+/// How many user-action packets the PriorityUpdateLoop can keep around for
+/// repeating them later.
+DECLARE_CONST(dcc_update_loop_repeat_slots);
+/// Upper bound on the number of repeats of a user-action packet.
+DECLARE_CONST(dcc_update_loop_max_repeat);
+/// Percentage of the track time that user-action packets may use when there
+/// are also locomotives waiting for background refresh.
+DECLARE_CONST(dcc_update_loop_urgent_percent);
+
+namespace dcc
+{
+
+/// Implementation of a command station update loop with prioritization. Can
+/// be used as a drop-in replacement for SimpleUpdateLoop.
+///
+/// Packet selection, in decreasing order of precedence:
+///
+/// - If there is an exclusive source (priority >= EXCLUSIVE_MIN_PRIORITY),
+///   only the one with the highest priority gets packets.
+///
+/// - Urgent queue: every notify_update() call (throttle speed or function
+///   change, emergency stop) is put in a FIFO. The packet is generated from
+///   the freshest state of the source when it is sent. Duplicate
+///   notifications are merged.
+///
+/// - Repeats: instead of asking the track driver to repeat a user-action
+///   packet back-to-back, a copy is kept and the repeats are interleaved with
+///   other traffic. The number of repeats is capped by
+///   config_dcc_update_loop_max_repeat(); a new notification for the same
+///   source and code drops the remaining repeats of the outdated packet.
+///
+/// - Background refresh: the source that has waited the longest (weighted by
+///   its priority) gets the next refresh packet.
+///
+/// No source gets two packets closer than MIN_GAP_NSEC apart. If nothing is
+/// eligible, an idle packet is sent.
+///
+/// Time is measured in track time: a bandwidth model (packet_duration())
+/// estimates how long each packet occupies the rails. This is used for the
+/// gap between packets to the same decoder, for refresh aging, and for
+/// limiting user-action packets to config_dcc_update_loop_urgent_percent() of
+/// the track time, so that a flood of throttle updates cannot starve the
+/// refresh of the other locomotives.
+///
+/// add_refresh_source(), remove_refresh_source() and notify_update() may be
+/// called from any thread. They only queue the change under the lock; the
+/// flow applies the queued changes at the start of the next packet. The
+/// scheduling state is owned by the flow, and the packet sources are called
+/// without holding the lock. remove_refresh_source() waits if the flow is
+/// calling that source at the same time, so the source may be deleted after
+/// it returned.
+///
+/// Usage is the same as SimpleUpdateLoop.
+class PriorityUpdateLoop : public StateFlow<Buffer<dcc::Packet>, QList<1>>,
+                           private UpdateLoopBase
+{
+public:
+    /// Constructor.
+    /// @param service defines the executor to run on.
+    /// @param track_send where to send the filled packets, usually a
+    /// dcc::LocalTrackIf.
+    PriorityUpdateLoop(Service *service, TrackIf *track_send);
+    ~PriorityUpdateLoop();
+
+    /// Minimum time between the end of a packet and the start of the next
+    /// packet to the same source.
+    static constexpr long long MIN_GAP_NSEC = MSEC_TO_NSEC(5);
+
+    /// Bandwidth model of the track.
+    /// @param pkt a packet to be sent to the track.
+    /// @return approximate time in nanoseconds that pkt occupies the rails,
+    /// including the repeats requested in its header.
+    static long long packet_duration(const Packet &pkt);
+
+    /// @return the track time, i.e. the sum of the estimated durations of all
+    /// packets generated so far.
+    long long track_time()
+    {
+        return trackTime_;
+    }
+
+    bool add_refresh_source(
+        dcc::PacketSource *source, unsigned priority) override;
+
+    void remove_refresh_source(dcc::PacketSource *source) override;
+
+    void notify_update(PacketSource *source, unsigned code) override;
+
+    /// Entry to the state flow -- when a new packet needs to be sent.
+    /// @return next action.
+    Action entry() override;
+
+private:
+    /// State of a registered packet source.
+    struct SourceInfo
+    {
+        /// The refresh source.
+        PacketSource *source_;
+        /// Priority from add_refresh_source.
+        unsigned priority_;
+        /// Track time when the last packet to this source ended.
+        long long lastEnd_;
+    };
+
+    /// A pending notify_update call.
+    struct Urgent
+    {
+        /// Source to ask for the packet.
+        PacketSource *source_;
+        /// Code from notify_update.
+        unsigned code_;
+    };
+
+    /// A user-action packet waiting to be repeated.
+    struct Repeat
+    {
+        /// Copy of the packet to repeat.
+        Packet packet_;
+        /// Where the packet came from (nullptr if the slot is free).
+        PacketSource *source_;
+        /// Code from notify_update.
+        unsigned code_;
+        /// How many more times to send the packet.
+        unsigned remaining_;
+    };
+
+    /// A queued add_refresh_source or remove_refresh_source call.
+    struct SourceChange
+    {
+        /// Next queued change (the list is in reverse order).
+        SourceChange *next_;
+        /// The source to add or remove.
+        PacketSource *source_;
+        /// Priority from add_refresh_source.
+        unsigned priority_;
+        /// true for add_refresh_source, false for remove_refresh_source.
+        bool add_;
+    };
+
+    /// A registered source with exclusive priority. Needed to compute the
+    /// return value of add_refresh_source without the flow.
+    struct ExclusiveSource
+    {
+        /// Next entry.
+        ExclusiveSource *next_;
+        /// The source.
+        PacketSource *source_;
+        /// Its priority.
+        unsigned priority_;
+    };
+
+    /// Takes the queued source changes and notifications and applies them to
+    /// the state of the flow.
+    void apply_pending();
+
+    /// Calls a packet source to fill the current message. Must not be called
+    /// with the lock held.
+    /// @param source the source to call.
+    /// @param code the code to pass to get_next_packet.
+    /// @return false if the source was removed in the meantime; the message
+    /// is not filled then.
+    bool call_source(PacketSource *source, unsigned code);
+
+    /// @param source a registered packet source
+    /// @return its state, or nullptr if it is not registered.
+    SourceInfo *find_source(PacketSource *source);
+
+    /// @param info a packet source
+    /// @return true if the gap since the last packet to this source is long
+    /// enough to send another one.
+    bool gap_ok(SourceInfo *info)
+    {
+        return trackTime_ - info->lastEnd_ >= MIN_GAP_NSEC;
+    }
+
+    /// Fills the current message with a packet from the exclusive source, if
+    /// there is one.
+    /// @return the exclusive source, or nullptr if there is none.
+    SourceInfo *fill_exclusive();
+
+    /// Fills the current message from the urgent queue.
+    /// @return the source the packet was generated by, or nullptr if there
+    /// was no eligible entry.
+    SourceInfo *fill_urgent();
+
+    /// Fills the current message from the repeat slots.
+    /// @return the source the packet belongs to, or nullptr if there was no
+    /// eligible entry.
+    SourceInfo *fill_repeat();
+
+    /// Fills the current message with a background refresh packet.
+    /// @return the source the packet was generated by, or nullptr if all
+    /// sources were refreshed too recently.
+    SourceInfo *fill_refresh();
+
+    /// Takes over the repetition of the user-action packet in the current
+    /// message if a repeat slot is available.
+    /// @param source the source that generated the packet.
+    /// @param code notify_update code that generated the packet.
+    void schedule_repeat(PacketSource *source, unsigned code);
+
+    /// Where we forward the packets filled in.
+    TrackIf *trackSend_;
+
+    /// @{ Guarded by the lock.
+    /// Queued source changes, newest first.
+    SourceChange *changes_ {nullptr};
+    /// Registered sources with exclusive priority.
+    ExclusiveSource *exclusive_ {nullptr};
+    /// Ring buffer of notify_update calls not yet seen by the flow.
+    std::vector<Urgent> inbox_;
+    /// Index of the oldest entry in inbox_.
+    unsigned inboxHead_ {0};
+    /// Number of entries in inbox_.
+    unsigned inboxCount_ {0};
+    /// The source the flow is calling right now, or nullptr.
+    PacketSource *busySource_ {nullptr};
+    /// remove_refresh_source waiting for busySource_ to be returned.
+    OSSem *busyWaiter_ {nullptr};
+    /// @}
+
+    /// @{ Owned by the flow.
+    /// Registered packet sources.
+    std::vector<SourceInfo> sources_;
+    /// Pending notifications in FIFO order.
+    std::vector<Urgent> urgent_;
+    /// Notifications taken from inbox_.
+    std::vector<Urgent> incoming_;
+    /// Storage for packets to repeat.
+    std::vector<Repeat> repeats_;
+    /// Sum of the estimated durations of all packets generated.
+    long long trackTime_ {0};
+    /// How much track time (nsec) the urgent packets may use right now. Grows
+    /// with the background refresh traffic, shrinks with the urgent traffic.
+    long long urgentBudget_;
+    /// @}
+};
+
+} // namespace dcc
+
+#endif // _DCC_PRIORITYUPDATELOOP_HXX_
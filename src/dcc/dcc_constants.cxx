@@ -35,3 +35,8 @@
 #include "utils/constants.hxx"
 
 DEFAULT_CONST(dcc_virtual_f0_offset, 100);
+
+DEFAULT_CONST(dcc_update_loop_urgent_queue_size, 32);
+DEFAULT_CONST(dcc_update_loop_repeat_slots, 8);
+DEFAULT_CONST(dcc_update_loop_max_repeat, 3);
+DEFAULT_CONST(dcc_update_loop_urgent_percent, 80);
@@ -35,17 +35,48 @@
 #ifndef _EXECUTOR_DISPATCHER_HXX_
 #define _EXECUTOR_DISPATCHER_HXX_
 
+#include <algorithm>
 #include <vector>
 
 #include "executor/Notifiable.hxx"
 #include "executor/StateFlow.hxx"
 
+/// Interface for handlers that receive messages from a DispatchFlow without
+/// the message being copied. The handler is called synchronously on the
+/// dispatcher's executor with a new reference to the incoming buffer. The
+/// handler must not modify the message contents and must not enqueue the
+/// buffer into a queue that links through QMember::next (e.g. send it to a
+/// StateFlow with a QList), because the same buffer is given to other
+/// handlers as well. It may hold on to the reference to read the message
+/// later, or enqueue it into a QPointerRing.
+///
+/// The non-shared handlers get a copy of the message, except the last one,
+/// which gets the original buffer. Therefore when shared handlers are
+/// registered, none of the handlers of the dispatcher may modify the message.
+template <class MessageType> class SharedMessageHandler
+{
+public:
+    virtual ~SharedMessageHandler()
+    {
+    }
+
+    /// Called when a message matching the registration arrives.
+    /// @param message a new reference to the incoming message.
+    virtual void handle_shared_message(
+        BufferPtr<typename MessageType::value_type> message) = 0;
+};
+
 /**
    This class takes registrations of StateFlows for incoming messages. When a
    message shows up, all the Flows that match that message will be
    invoked.
 
    Handlers are called in no particular order.
+
+   By default the dispatcher scans all registered handlers for every
+   message. In the indexed mode (see set_indexed()) the handlers are grouped
+   by their mask and kept sorted by the masked ID, so that only the matching
+   handlers need to be visited.
  */
 template <int NUM_PRIO>
 class DispatchFlowBase : public UntypedStateFlow<QList<NUM_PRIO>>
@@ -65,6 +96,19 @@ public:
     /** @returns the number of handlers registered. */
     size_t size();
 
+    /// Turns on or off the indexed dispatch mode. In indexed mode the
+    /// matching handlers are looked up by binary search in per-mask sorted
+    /// tables instead of checking every registered handler. The order in
+    /// which the handlers are called is the same in both modes. The indexed
+    /// mode is not used when negateMatch_ is set.
+    /// @param enable true to turn on the indexed mode.
+    void set_indexed(bool enable)
+    {
+        OSMutexLock h(&lock_);
+        indexed_ = enable;
+        indexDirty_ = true;
+    }
+
 protected:
     /// Proxy the identifier type for customers to use.
     typedef uint32_t ID;
@@ -84,7 +128,10 @@ protected:
        @param handler is the flow to forward message to. It must stay alive so
        long as *this is alive or the handler is removed.
      */
-    void register_handler(UntypedHandler *handler, ID id, ID mask);
+    /// @param shared if true, the handler is a SharedMessageHandler and will
+    /// be called via send_shared() without copying the message.
+    void register_handler(
+        UntypedHandler *handler, ID id, ID mask, bool shared = false);
 
     /// Removes a specific instance of a handler from this dispatcher.
     ///
@@ -119,6 +166,11 @@ protected:
      */
     virtual void send_transfer() = 0;
 
+    /** Gives a new reference of the current message to a handler that was
+     * registered as shared.
+     * @param handler the SharedMessageHandler to call. */
+    virtual void send_shared(UntypedHandler *handler) = 0;
+
     /*typedef typename StateFlow<MessageType, QList<NUM_PRIO>>::Callback Callback;
     using StateFlow<MessageType, QList<NUM_PRIO>>::again;
     using StateFlow<MessageType, QList<NUM_PRIO>>::allocate_and_call;
@@ -157,13 +209,15 @@ protected:
     /// identifier, mask, handler pointer.
     struct HandlerInfo
     {
-        HandlerInfo() : handler(nullptr)
+        HandlerInfo() : handler(nullptr), shared(false)
         {
         }
         ID id; ///< Bits that this handler is registered for.
         ID mask; ///< Mask that should be applied for the bits check.
         /// Handler to call. NULL if the handler has been removed.
         UntypedHandler *handler;
+        /// True if the handler is a SharedMessageHandler.
+        bool shared;
 
         /// Equality comparison function on the handlers. Used for remove()
         /// calls.
@@ -181,12 +235,85 @@ protected:
         }
     };
 
+    /// Entry in the index: a masked ID and the handler slot it belongs to.
+    struct IndexEntry
+    {
+        ID id; ///< id & mask of the registration.
+        uint32_t slot; ///< Index of the registration in handlers_.
+
+        /// Sort order for the index. @param o other entry. @return true if
+        /// *this comes before o.
+        bool operator<(const IndexEntry &o) const
+        {
+            return id < o.id || (id == o.id && slot < o.slot);
+        }
+    };
+
+    /// All registrations with the same mask, sorted by the masked ID.
+    struct MaskGroup
+    {
+        ID mask; ///< The common mask of these registrations.
+        vector<IndexEntry> entries; ///< Sorted registrations.
+    };
+
+    /// @return true if the current iteration is using the index.
+    bool use_index()
+    {
+        return iterIndexed_;
+    }
+
+    /// Rebuilds index_ from handlers_. Must be called with lock_ held.
+    void rebuild_index();
+
+    /// Fills candidates_ with the slots of the handlers matching an id, in
+    /// increasing slot order. Must be called with lock_ held.
+    /// @param id the identifier of the current message.
+    void lookup_candidates(ID id);
+
+    /// @return the number of entries to iterate over in the current
+    /// iteration. Must be called with lock_ held.
+    size_t num_candidates()
+    {
+        return use_index() ? candidates_.size() : handlers_.size();
+    }
+
+    /// @return the slot in handlers_ for a given iteration index, or
+    /// handlers_.size() if that slot is not valid anymore. Must be called
+    /// with lock_ held.
+    /// @param idx iteration index, less than num_candidates().
+    size_t candidate_slot(size_t idx)
+    {
+        size_t slot = use_index() ? candidates_[idx] : idx;
+        return std::min(slot, handlers_.size());
+    }
+
     /// Registered handlers.
     vector<HandlerInfo> handlers_;
 
-    /// Index of the next handler to look at.
+    /// Handlers grouped by mask. Only maintained in the indexed mode.
+    vector<MaskGroup> index_;
+
+    /// Slots of the handlers that match the current message. Only used in the
+    /// indexed mode.
+    vector<uint32_t> candidates_;
+
+    /// Index of the next handler (or candidate) to look at.
     size_t currentIndex_;
 
+    /// True if any handler matched the current message.
+    bool anyMatched_{false};
+
+    /// True if the indexed dispatch mode is enabled.
+    bool indexed_{false};
+
+    /// Copy of indexed_ (unless negateMatch_) taken under lock_ when the
+    /// current iteration started, so that set_indexed() does not switch
+    /// the meaning of currentIndex_ in the middle of a message.
+    bool iterIndexed_{false};
+
+    /// True if index_ needs to be rebuilt before the next lookup.
+    bool indexDirty_{true};
+
     /// If non-NULL we still need to call this handler.
     UntypedHandler *lastHandlerToCall_{nullptr};
     /// Handler to give all messages that were not matched by any other handler
@@ -229,6 +356,8 @@ public:
 
     /// Interface type for handlers that can be registered.
     typedef FlowInterface<MessageType> HandlerType;
+    /// Interface type for handlers that get the message without a copy.
+    typedef SharedMessageHandler<MessageType> SharedHandlerType;
     /// Maskable type of the dispatched messages upon which handlers can
     /// configure to trigger.
     typedef typename MessageType::value_type::id_type ID;
@@ -272,6 +401,39 @@ public:
         Base::unregister_handler_all(handler);
     }
 
+    /**
+       Adds a new shared handler to this dispatcher. The handler will be
+       called synchronously with a reference to the incoming message, without
+       allocating a copy of it. The matching rules are the same as for
+       register_handler.
+
+       @param id is the identifier of the message to listen to.
+       @param mask is the mask of the ID matcher.
+       @param handler is the handler to call. It must stay alive so long as
+       *this is alive or the handler is removed.
+     */
+    void register_shared_handler(SharedHandlerType *handler, ID id, ID mask)
+    {
+        Base::register_handler(handler, id, mask, true);
+    }
+
+    /// Removes a specific instance of a shared handler from this dispatcher.
+    ///
+    /// @param handler handler pointer to unregister.
+    /// @param id bits to unregister the handler for
+    /// @param mask mask to unregister the handler for.
+    ///
+    void unregister_shared_handler(SharedHandlerType *handler, ID id, ID mask)
+    {
+        Base::unregister_handler(handler, id, mask);
+    }
+
+    /// Removes all instances of a shared handler from this dispatcher.
+    void unregister_shared_handler_all(SharedHandlerType *handler)
+    {
+        Base::unregister_handler_all(handler);
+    }
+
     /// Sets one handler to receive all messages that no other handler has
     /// matched. May be called only once in the lifetime of a dispatcher
     /// object. @param handler is the handler pointer for the fallback handler.
@@ -319,6 +481,14 @@ protected:
         HandlerType* h = static_cast<HandlerType *>(this->lastHandlerToCall_);
         h->send(this->transfer_message());
     }
+
+    /// Calls a shared handler with a new reference to the current message.
+    void send_shared(typename Base::UntypedHandler *handler) OVERRIDE
+    {
+        SharedHandlerType *h = static_cast<SharedHandlerType *>(handler);
+        h->handle_shared_message(
+            get_buffer_deleter(this->message()->ref()));
+    }
 };
 
 
@@ -354,10 +524,11 @@ size_t DispatchFlowBase<NUM_PRIO>::size()
 }
 
 template<int NUM_PRIO>
-void DispatchFlowBase<NUM_PRIO>::register_handler(UntypedHandler *handler,
-                                                  ID id, ID mask)
+void DispatchFlowBase<NUM_PRIO>::register_handler(
+    UntypedHandler *handler, ID id, ID mask, bool shared)
 {
     OSMutexLock h(&lock_);
+    indexDirty_ = true;
     size_t idx = 0;
     while (idx < handlers_.size() && handlers_[idx].handler)
     {
@@ -370,6 +541,7 @@ void DispatchFlowBase<NUM_PRIO>::register_handler(UntypedHandler *handler,
     handlers_[idx].handler = handler;
     handlers_[idx].id = id;
     handlers_[idx].mask = mask;
+    handlers_[idx].shared = shared;
 }
 
 template<int NUM_PRIO>
@@ -378,6 +550,7 @@ DispatchFlowBase<NUM_PRIO>::unregister_handler(UntypedHandler *handler,
                                                ID id, ID mask)
 {
     OSMutexLock h(&lock_);
+    indexDirty_ = true;
     /// @todo(balazs.racz) optimize by looking at the current index - 1.
     size_t idx = 0;
     while (idx < handlers_.size() && !handlers_[idx].Equals(id, mask, handler))
@@ -402,6 +575,7 @@ void DispatchFlowBase<NUM_PRIO>::unregister_handler_all(
     UntypedHandler *handler)
 {
     OSMutexLock h(&lock_);
+    indexDirty_ = true;
     for (size_t i = 0; i < handlers_.size(); ++i)
     {
         if (handlers_[i].handler == handler)
@@ -415,11 +589,74 @@ void DispatchFlowBase<NUM_PRIO>::unregister_handler_all(
     }
 }
 
+template <int NUM_PRIO> void DispatchFlowBase<NUM_PRIO>::rebuild_index()
+{
+    index_.clear();
+    for (size_t slot = 0; slot < handlers_.size(); ++slot)
+    {
+        auto &h = handlers_[slot];
+        if (!h.handler)
+        {
+            continue;
+        }
+        auto it = index_.begin();
+        while (it != index_.end() && it->mask != h.mask)
+        {
+            ++it;
+        }
+        if (it == index_.end())
+        {
+            index_.emplace_back();
+            it = index_.end() - 1;
+            it->mask = h.mask;
+        }
+        it->entries.push_back({(ID)(h.id & h.mask), (uint32_t)slot});
+    }
+    for (auto &g : index_)
+    {
+        std::sort(g.entries.begin(), g.entries.end());
+    }
+    indexDirty_ = false;
+}
+
+template <int NUM_PRIO>
+void DispatchFlowBase<NUM_PRIO>::lookup_candidates(ID id)
+{
+    if (indexDirty_)
+    {
+        rebuild_index();
+    }
+    candidates_.clear();
+    for (auto &g : index_)
+    {
+        IndexEntry key{(ID)(id & g.mask), 0};
+        auto it = std::lower_bound(g.entries.begin(), g.entries.end(), key);
+        for (; it != g.entries.end() && it->id == key.id; ++it)
+        {
+            candidates_.push_back(it->slot);
+        }
+    }
+    if (index_.size() > 1)
+    {
+        // Keeps the registration order, same as the linear scan.
+        std::sort(candidates_.begin(), candidates_.end());
+    }
+}
+
 template<int NUM_PRIO>
 StateFlowBase::Action DispatchFlowBase<NUM_PRIO>::entry()
 {
     currentIndex_ = 0;
     lastHandlerToCall_ = nullptr;
+    anyMatched_ = false;
+    {
+        OSMutexLock l(&lock_);
+        iterIndexed_ = indexed_ && !negateMatch_;
+        if (iterIndexed_)
+        {
+            lookup_candidates(get_message_id());
+        }
+    }
     return call_immediately(STATE(iterate));
 }
 
@@ -427,36 +664,63 @@ template<int NUM_PRIO>
 StateFlowBase::Action DispatchFlowBase<NUM_PRIO>::iterate()
 {
     ID id = get_message_id();
+    while (true)
     {
-        // @todo(balazs.racz) make the registered handlers structure for the
-        // dispatcher lock-free. This mutex here is very expensive.
-        OSMutexLock l(&lock_);
-        for (; currentIndex_ < handlers_.size(); ++currentIndex_)
+        UntypedHandler *shared_handler = nullptr;
         {
-            auto &h = handlers_[currentIndex_];
-            if (!h.handler)
+            // @todo(balazs.racz) make the registered handlers structure for
+            // the dispatcher lock-free. This mutex here is very expensive.
+            OSMutexLock l(&lock_);
+            for (; currentIndex_ < num_candidates(); ++currentIndex_)
             {
-                continue;
+                size_t slot = candidate_slot(currentIndex_);
+                if (slot >= handlers_.size())
+                {
+                    continue;
+                }
+                auto &h = handlers_[slot];
+                if (!h.handler)
+                {
+                    continue;
+                }
+                if (negateMatch_ && (id & h.mask) == (h.id & h.mask))
+                {
+                    continue;
+                }
+                if ((!negateMatch_) && (id & h.mask) != (h.id & h.mask))
+                {
+                    continue;
+                }
+                anyMatched_ = true;
+                if (h.shared)
+                {
+                    // Called outside of the lock, without a copy.
+                    shared_handler = h.handler;
+                    ++currentIndex_;
+                    break;
+                }
+                // At this point: we have another handler.
+                if (!lastHandlerToCall_)
+                {
+                    // This was the first we found.
+                    lastHandlerToCall_ = h.handler;
+                    continue;
+                }
+                break;
             }
-            if (negateMatch_ && (id & h.mask) == (h.id & h.mask))
-            {
-                continue;
-            }
-            if ((!negateMatch_) && (id & h.mask) != (h.id & h.mask))
-            {
-                continue;
-            }
-            // At this point: we have another handler.
-            if (!lastHandlerToCall_)
-            {
-                // This was the first we found.
-                lastHandlerToCall_ = handlers_[currentIndex_].handler;
-                continue;
-            }            
+        }
+        if (!shared_handler)
+        {
             break;
         }
+        send_shared(shared_handler);
     }
-    if (currentIndex_ >= handlers_.size())
+    bool more;
+    {
+        OSMutexLock l(&lock_);
+        more = currentIndex_ < num_candidates();
+    }
+    if (!more)
     {
         return iteration_done();
     }
@@ -468,7 +732,14 @@ StateFlowBase::Action DispatchFlowBase<NUM_PRIO>::iterate()
 template<int NUM_PRIO>
 StateFlowBase::Action DispatchFlowBase<NUM_PRIO>::clone_done()
 {
-    lastHandlerToCall_ = handlers_[currentIndex_].handler;
+    {
+        OSMutexLock l(&lock_);
+        size_t slot = currentIndex_ < num_candidates()
+            ? candidate_slot(currentIndex_)
+            : handlers_.size();
+        lastHandlerToCall_ =
+            slot < handlers_.size() ? handlers_[slot].handler : nullptr;
+    }
     ++currentIndex_;
     return call_immediately(STATE(iterate));
 }
@@ -480,7 +751,7 @@ StateFlowBase::Action DispatchFlowBase<NUM_PRIO>::iteration_done()
     {
         send_transfer();
     }
-    else if (fallbackHandler_)
+    else if (fallbackHandler_ && !anyMatched_)
     {
         // Nothing handled this message, and we have a fallbac handler
         // registered. Gives the message to the fallback handler.
@@ -46,6 +46,12 @@
 #include <sys/select.h>
 #endif
 
+#if OPENMRN_FEATURE_EXECUTOR_EPOLL
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#endif
+
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
 #endif
@@ -77,10 +83,19 @@ ExecutorBase::ExecutorBase()
     , started_(0)
     , selectPrescaler_(0)
 {
+#if OPENMRN_FEATURE_EXECUTOR_EPOLL
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    HASSERT(epollFd_ >= 0);
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.fd = selectHelper_.wakeup_fd();
+    HASSERT(!epoll_ctl(epollFd_, EPOLL_CTL_ADD, ev.data.fd, &ev));
+#else
     FD_ZERO(&selectRead_);
     FD_ZERO(&selectWrite_);
     FD_ZERO(&selectExcept_);
     selectNFds_ = 0;
+#endif
 }
 
 /** Lookup an executor by its name.
@@ -329,6 +344,210 @@ void *ExecutorBase::entry()
     return NULL;
 }
 
+#if OPENMRN_FEATURE_EXECUTOR_EPOLL
+
+/// @param type is a Selectable::SelectType.
+/// @return the epoll events to wait for for a given select type.
+static uint32_t epoll_wait_events(unsigned type)
+{
+    switch (type)
+    {
+        case Selectable::READ: return EPOLLIN;
+        case Selectable::WRITE: return EPOLLOUT;
+        case Selectable::EXCEPT: return EPOLLPRI;
+    }
+    return 0;
+}
+
+/// @param type is a Selectable::SelectType.
+/// @return the epoll events that make a selectable of a given type ready. This
+/// matches what the kernel reports for ::select.
+static uint32_t epoll_ready_events(unsigned type)
+{
+    switch (type)
+    {
+        case Selectable::READ: return EPOLLIN | EPOLLHUP | EPOLLERR;
+        case Selectable::WRITE: return EPOLLOUT | EPOLLERR;
+        case Selectable::EXCEPT: return EPOLLPRI;
+    }
+    return 0;
+}
+
+bool ExecutorBase::epoll_update(int fd, EpollSlot *slot)
+{
+    uint32_t events = 0;
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        if (slot->jobs_[i])
+        {
+            events |= epoll_wait_events(i + 1);
+        }
+    }
+    if (events == slot->events_)
+    {
+        return true;
+    }
+    struct epoll_event ev;
+    ev.events = events;
+    ev.data.fd = fd;
+    int ret;
+    if (!events)
+    {
+        // Fails if the fd was closed already, which also removed it from the
+        // epoll set.
+        epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, &ev);
+        slot->events_ = 0;
+        return true;
+    }
+    else if (slot->events_)
+    {
+        ret = epoll_ctl(epollFd_, EPOLL_CTL_MOD, fd, &ev);
+        if (ret < 0 && errno == ENOENT)
+        {
+            // The fd was closed and reopened since we added it.
+            ret = epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev);
+        }
+    }
+    else
+    {
+        ret = epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev);
+        if (ret < 0 && errno == EEXIST)
+        {
+            ret = epoll_ctl(epollFd_, EPOLL_CTL_MOD, fd, &ev);
+        }
+    }
+    if (ret < 0)
+    {
+        // EPERM: regular files cannot be waited upon with epoll; they are
+        // always ready, which is also what ::select would report. EBADF: the
+        // fd was closed; the owner will get the error from its next
+        // read/write call.
+        if (errno != EPERM && errno != EBADF && errno != ENOENT)
+        {
+            LOG(WARNING, "epoll_ctl for fd %d failed: %s", fd,
+                strerror(errno));
+        }
+        slot->events_ = 0;
+        for (unsigned i = 0; i < 3; ++i)
+        {
+            Selectable *job = slot->jobs_[i];
+            if (job)
+            {
+                slot->jobs_[i] = nullptr;
+                add(job->wakeup_, job->priority_);
+            }
+        }
+        return false;
+    }
+    slot->events_ = events;
+    return true;
+}
+
+void ExecutorBase::select(Selectable *job)
+{
+    unsigned fd = job->fd_;
+    unsigned idx = job->selectType_ - 1;
+    if (fd >= epollSlots_.size())
+    {
+        epollSlots_.resize(fd + 1);
+    }
+    EpollSlot *slot = &epollSlots_[fd];
+    if (slot->jobs_[idx] && slot->jobs_[idx] != job)
+    {
+        struct epoll_event ev;
+        ev.events = slot->events_;
+        ev.data.fd = fd;
+        if (epoll_ctl(epollFd_, EPOLL_CTL_MOD, fd, &ev) == 0)
+        {
+            LOG(FATAL,
+                "Multiple Selectables are waiting for the same fd %d type %u",
+                fd, job->selectType_);
+        }
+        // The kernel does not know this fd anymore: it was closed (which
+        // removed it from the epoll set) while selectables were waiting on
+        // it, and the number got reused. The old selectables would never be
+        // woken up by the kernel. They are woken up now, like epoll_update()
+        // does for a closed fd; their owners will get the error from the
+        // next read/write call.
+        LOG(WARNING, "Dropping stale selectables on reused fd %d", fd);
+        for (unsigned i = 0; i < 3; ++i)
+        {
+            Selectable *stale = slot->jobs_[i];
+            if (stale)
+            {
+                add(stale->wakeup_, stale->priority_);
+            }
+        }
+        *slot = EpollSlot();
+    }
+    slot->jobs_[idx] = job;
+    // If the fd cannot be added, the job is woken up right away.
+    epoll_update(fd, slot);
+}
+
+bool ExecutorBase::is_selected(Selectable *job)
+{
+    unsigned fd = job->fd_;
+    return fd < epollSlots_.size() &&
+        epollSlots_[fd].jobs_[job->selectType_ - 1] == job;
+}
+
+void ExecutorBase::unselect(Selectable *job)
+{
+    if (!is_selected(job))
+    {
+        // Already woken up, or dropped because the fd was closed.
+        return;
+    }
+    EpollSlot *slot = &epollSlots_[job->fd_];
+    slot->jobs_[job->selectType_ - 1] = nullptr;
+    epoll_update(job->fd_, slot);
+}
+
+void ExecutorBase::wait_with_select(long long wait_length)
+{
+    // See the select() based implementation below for why this is here.
+    selectHelper_.clear_wakeup();
+    if (!empty())
+    {
+        wait_length = 0;
+    }
+    long long max_sleep = MSEC_TO_NSEC(config_executor_max_sleep_msec());
+    if (wait_length > max_sleep)
+    {
+        wait_length = max_sleep;
+    }
+    struct epoll_event events[EPOLL_MAX_EVENTS];
+    int ret = selectHelper_.wait_epoll(
+        epollFd_, events, EPOLL_MAX_EVENTS, wait_length);
+    for (int i = 0; i < ret; ++i)
+    {
+        int fd = events[i].data.fd;
+        if (fd == selectHelper_.wakeup_fd())
+        {
+            selectHelper_.drain_wakeup();
+            continue;
+        }
+        if ((unsigned)fd >= epollSlots_.size())
+        {
+            continue;
+        }
+        EpollSlot *slot = &epollSlots_[fd];
+        for (unsigned t = 0; t < 3; ++t)
+        {
+            Selectable *job = slot->jobs_[t];
+            if (job && (events[i].events & epoll_ready_events(t + 1)))
+            {
+                add(job->wakeup_, job->priority_);
+                slot->jobs_[t] = nullptr;
+            }
+        }
+        epoll_update(fd, slot);
+    }
+}
+
+#else
+
 void ExecutorBase::select(Selectable *job)
 {
     fd_set *s = get_select_set(job->type());
@@ -425,6 +644,8 @@ void ExecutorBase::wait_with_select(long long wait_length)
     selectNFds_ = max_fd;
 }
 
+#endif // OPENMRN_FEATURE_EXECUTOR_EPOLL
+
 #endif
 
 #if defined(ARDUINO)
@@ -458,4 +679,7 @@ ExecutorBase::~ExecutorBase()
     {
         shutdown();
     }
+#if OPENMRN_FEATURE_EXECUTOR_EPOLL
+    ::close(epollFd_);
+#endif
 }
@@ -38,6 +38,7 @@
 
 #include <functional>
 #include <atomic>
+#include <vector>
 
 #include "executor/Executable.hxx"
 #include "executor/Notifiable.hxx"
@@ -192,6 +193,28 @@ private:
      * @param next_timer_nsec is the maximum time to sleep in nanoseconds. */
     void wait_with_select(long long next_timer_nsec);
 
+#if OPENMRN_FEATURE_EXECUTOR_EPOLL
+    /// Registration state of one file descriptor in the epoll set.
+    struct EpollSlot
+    {
+        /// Selectables waiting on this fd, indexed by SelectType - 1.
+        Selectable *jobs_[3] = {nullptr, nullptr, nullptr};
+        /// Event mask currently registered in the kernel; 0 if not added.
+        uint32_t events_ = 0;
+    };
+
+    /// Brings the kernel's epoll registration of an fd in sync with the
+    /// selectables waiting on it.
+    /// @param fd the file descriptor.
+    /// @param slot is epollSlots_[fd].
+    /// @return false if the fd cannot be added to the epoll set (e.g. it is a
+    /// regular file or it was closed). The selectables waiting on it are then
+    /// woken up and removed from the slot.
+    bool epoll_update(int fd, EpollSlot *slot);
+
+    /// How many ready fds we take from the kernel in one call.
+    static constexpr int EPOLL_MAX_EVENTS = 64;
+#else
     /// Helper function.
     ///
     /// @param type a select type: READ, WRITE or EXCEPT
@@ -209,6 +232,7 @@ private:
         LOG(FATAL, "Unexpected select type %d", type);
         return nullptr;
     }
+#endif
 
     /** name of this Executor */
     const char *name_;
@@ -219,6 +243,12 @@ private:
     /** List of active timers. */
     ActiveTimers activeTimers_;
 
+#if OPENMRN_FEATURE_EXECUTOR_EPOLL
+    /** epoll set containing all selected fds and the wakeup fd. */
+    int epollFd_;
+    /** Registered selectables, indexed by fd. */
+    std::vector<EpollSlot> epollSlots_;
+#else
     /** fd to select for read. */
     fd_set selectRead_;
     /** fd to select for write. */
@@ -229,6 +259,7 @@ private:
     int selectNFds_;
     /** Head of the linked list for the select calls. */
     TypedQueue<Selectable> selectables_;
+#endif
 
     /** Set to 1 when the executor thread has exited and it is safe to delete
      * *this. */
@@ -1286,6 +1286,13 @@ protected:
         return queue_.empty();
     }
 
+    /// @return the queue of pending messages. All accesses need to hold the
+    /// lock of this flow (AtomicHolder on this).
+    QueueType *queue()
+    {
+        return &queue_;
+    }
+
 private:
     /** Implementation of the queue. */
     QueueType queue_;
@@ -85,32 +85,28 @@ long long ActiveTimers::get_next_timeout()
 {
     OSMutexLock l(&lock_);
 
-    QMember **last = &activeTimers_.next;
-    Timer *current_timer = static_cast<Timer *>(*last);
     long long now = OSTime::get_monotonic();
     bool found_timer = false;
-    while (current_timer && current_timer->when_ <= now)
+    while (!heap_.empty() && heap_[0]->when_ <= now)
     {
         // Deques next timer.
         found_timer = true;
-        *last = current_timer->next;
-        current_timer->next = nullptr;
+        Timer *current_timer = heap_[0];
+        remove_locked(current_timer);
 
         current_timer->isActive_ = 0;
         current_timer->isExpired_ = 1;
         // Puts it on the executor.
         executor_->add(current_timer, current_timer->priority_);
-        // Takes the next timer.
-        current_timer = static_cast<Timer *>(*last);
     }
 
     if (found_timer)
     {
         return 0;
     }
-    else if (current_timer)
+    else if (!heap_.empty())
     {
-        long long ret = current_timer->when_ - now;
+        long long ret = heap_[0]->when_ - now;
         return ret;
     }
     else
@@ -123,10 +119,7 @@ long long ActiveTimers::get_next_timeout()
 
 bool ActiveTimers::empty() {
     OSMutexLock l(&lock_);
-
-    QMember **last = &activeTimers_.next;
-    Timer *current_timer = static_cast<Timer *>(*last);
-    return (current_timer == nullptr);
+    return heap_.empty();
 }
 
 void ActiveTimers::schedule_timer(Timer *timer)
@@ -135,21 +128,80 @@ void ActiveTimers::schedule_timer(Timer *timer)
     insert_locked(timer);
 }
 
-void ActiveTimers::insert_locked(Timer *timer)
+bool ActiveTimers::timer_less(Timer *a, Timer *b)
 {
-    HASSERT(timer);
-    HASSERT(timer->next == nullptr);
+    if (a->when_ != b->when_)
+    {
+        return a->when_ < b->when_;
+    }
+    // Wraparound-safe comparison of the sequence numbers.
+    return (int32_t)(a->seq_ - b->seq_) < 0;
+}
 
-    QMember **last = &activeTimers_.next;
-    Timer *current_timer = static_cast<Timer *>(*last);
-    while (current_timer && current_timer->when_ <= timer->when_)
+void ActiveTimers::heap_set(unsigned idx, Timer *timer)
+{
+    heap_[idx] = timer;
+    timer->heapIdx_ = idx;
+}
+
+void ActiveTimers::sift_up(unsigned idx)
+{
+    Timer *timer = heap_[idx];
+    while (idx > 0)
     {
-        last = &current_timer->next;
-        current_timer = static_cast<Timer *>(*last);
+        unsigned parent = (idx - 1) / HEAP_ARITY;
+        if (!timer_less(timer, heap_[parent]))
+        {
+            break;
+        }
+        heap_set(idx, heap_[parent]);
+        idx = parent;
     }
-    // Inserts into the queue.
-    timer->next = current_timer;
-    *last = timer;
+    heap_set(idx, timer);
+}
+
+void ActiveTimers::sift_down(unsigned idx)
+{
+    Timer *timer = heap_[idx];
+    unsigned size = heap_.size();
+    while (true)
+    {
+        unsigned first = idx * HEAP_ARITY + 1;
+        if (first >= size)
+        {
+            break;
+        }
+        unsigned last = first + HEAP_ARITY;
+        if (last > size)
+        {
+            last = size;
+        }
+        unsigned best = first;
+        for (unsigned c = first + 1; c < last; ++c)
+        {
+            if (timer_less(heap_[c], heap_[best]))
+            {
+                best = c;
+            }
+        }
+        if (!timer_less(heap_[best], timer))
+        {
+            break;
+        }
+        heap_set(idx, heap_[best]);
+        idx = best;
+    }
+    heap_set(idx, timer);
+}
+
+void ActiveTimers::insert_locked(Timer *timer)
+{
+    HASSERT(timer);
+    HASSERT(timer->heapIdx_ == Timer::NO_HEAP_INDEX);
+
+    timer->seq_ = nextSeq_++;
+    heap_.push_back(timer);
+    sift_up(heap_.size() - 1);
 
     // This will wake up the executor, which will schedule all expired timers
     // and recompute sleep length.
@@ -159,15 +211,25 @@ void ActiveTimers::insert_locked(Timer *timer)
 void ActiveTimers::remove_locked(Timer *timer)
 {
     HASSERT(timer);
-    // Removes the timer from the queue.
-    QMember **last = &activeTimers_.next;
-    while (*last && *last != timer)
+    // Removes the timer from the heap.
+    unsigned idx = timer->heapIdx_;
+    HASSERT(idx < heap_.size() && heap_[idx] == timer);
+    timer->heapIdx_ = Timer::NO_HEAP_INDEX;
+    Timer *last = heap_.back();
+    heap_.pop_back();
+    if (idx < heap_.size())
     {
-        last = &((*last)->next);
+        // Fills the hole with the last element.
+        heap_set(idx, last);
+        if (idx > 0 && timer_less(last, heap_[(idx - 1) / HEAP_ARITY]))
+        {
+            sift_up(idx);
+        }
+        else
+        {
+            sift_down(idx);
+        }
     }
-    HASSERT(*last == timer);
-    *last = timer->next;
-    timer->next = nullptr;
 }
 
 void ActiveTimers::update_timer(Timer *timer)
@@ -35,6 +35,8 @@
 #ifndef _EXECUTOR_TIMER_HXX_
 #define _EXECUTOR_TIMER_HXX_
 
+#include <vector>
+
 #include "executor/Notifiable.hxx"
 #include "utils/Buffer.hxx"
 #include "utils/QMember.hxx"
@@ -44,7 +46,12 @@ class Timer;
 class ExecutorBase;
 
 /** Class that manages the list of active timers. The Executor uses this class
- * tightly in its sleep-execute loop. */
+ * tightly in its sleep-execute loop.
+ *
+ * The active timers are kept in a 4-ary min-heap ordered by expiration
+ * time. Timers with the same expiration time expire in the order they were
+ * scheduled. Each timer knows its position in the heap, so scheduling,
+ * updating and removing a timer are all O(log n). */
 class ActiveTimers : public Executable
 {
 public:
@@ -75,17 +82,15 @@ public:
      * scheduled. */
     void schedule_timer(::Timer *timer);
 
-    /** Updates the expiration time of an already scheduled timer. This call is
-     * somewhat expensive, because it needs to walk the entire queue of active
-     * timers. May wake up the executor.
+    /** Updates the expiration time of an already scheduled timer. May wake up
+     * the executor.
      *
      * @param timer is the timer whose next execution time has been updated. It
      * must already be scheduled. */
     void update_timer(::Timer *timer);
 
-    /** Deletes an already scheduled but not yet expired timer. This call is
-     * somewhat expensive, because it needs to walk the entire queue of active
-     * timers. Asserts that the timer is in fact not yet expired.
+    /** Deletes an already scheduled but not yet expired timer. Asserts that
+     * the timer is in fact not yet expired.
      *
      * @param timer is the timer to delete. */
     void remove_timer(::Timer *timer);
@@ -104,6 +109,9 @@ public:
     void run() override;
 
 private:
+    /// Number of children of each heap node.
+    static constexpr unsigned HEAP_ARITY = 4;
+
     /** Removes a timer from the active list. Assert fails if it is not
      * there. Caller must hold the lock. 
      * @param timer what to remove from the active list. */
@@ -113,12 +121,35 @@ private:
      * @param timer what to insert into the active list. */
     void insert_locked(::Timer *timer);
 
+    /** Comparison function of the heap.
+     * @param a one timer
+     * @param b other timer
+     * @return true if a has to expire before b. */
+    static bool timer_less(::Timer *a, ::Timer *b);
+
+    /** Stores a timer in a heap slot. Caller must hold the lock.
+     * @param idx heap index
+     * @param timer what to store there. */
+    void heap_set(unsigned idx, ::Timer *timer);
+
+    /** Moves a timer towards the root of the heap until the heap property is
+     * restored. Caller must hold the lock.
+     * @param idx heap index of the timer to move. */
+    void sift_up(unsigned idx);
+
+    /** Moves a timer towards the leaves of the heap until the heap property
+     * is restored. Caller must hold the lock.
+     * @param idx heap index of the timer to move. */
+    void sift_down(unsigned idx);
+
     /// Parent.
     ExecutorBase *executor_;
     /// Protects the timer list.
     OSMutex lock_;
-    /// List of timers that are scheduled.
-    QMember activeTimers_;
+    /// Min-heap of the timers that are scheduled.
+    std::vector<::Timer *> heap_;
+    /// Sequence number to assign to the next scheduled timer.
+    uint32_t nextSeq_ {0};
     /// 1 if we in the executor's queue.
     std::atomic_uint_least8_t isPending_;
 
@@ -145,6 +176,8 @@ public:
         , isExpired_(0)
         , isCancelled_(0)
         , tcRequestStop_(0)
+        , heapIdx_(NO_HEAP_INDEX)
+        , seq_(0)
     {
     }
 
@@ -313,6 +346,14 @@ private:
     /** For children: 1 if a repeated timer should stop sending wakeups. */
     unsigned tcRequestStop_ : 1;
 
+    /// Value of heapIdx_ when the timer is not in the active timers heap.
+    static constexpr unsigned NO_HEAP_INDEX = UINT_MAX;
+    /** Index of this timer in the active timers heap. */
+    unsigned heapIdx_;
+    /** Order of scheduling, used to expire timers with the same when_ in
+     * FIFO order. */
+    uint32_t seq_;
+
     DISALLOW_COPY_AND_ASSIGN(Timer);
 };
 
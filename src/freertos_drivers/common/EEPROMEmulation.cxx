@@ -33,6 +33,7 @@
 
 #include "EEPROMEmulation.hxx"
 
+#include <algorithm>
 #include <cstring>
 
 const size_t EEPROMEmulation::HEADER_BLOCK_COUNT = 3;
@@ -104,6 +105,13 @@ void EEPROMEmulation::mount()
         }
     }
 
+    /* do we index the slots in RAM to speed up reads */
+    if (INDEX_IN_RAM)
+    {
+        index_ = new uint16_t[fblock_count()];
+        build_index();
+    }
+
     /* do we shadow_ the data in RAM to speed up reads */
     if (SHADOW_IN_RAM)
     {
@@ -118,6 +126,24 @@ void EEPROMEmulation::mount()
     }
 }
 
+/** Fills in index_ from the journal of the active sector.
+ */
+void EEPROMEmulation::build_index()
+{
+    memset(index_, 0, fblock_count() * sizeof(index_[0]));
+    /* later slots hold newer data, so they overwrite earlier ones */
+    for (unsigned block_index = slot_first();
+         block_index < rawBlockCount_ - availableSlots_;
+         ++block_index)
+    {
+        unsigned fblock = *block(activeSector_, block_index) >> 16;
+        if (fblock < fblock_count())
+        {
+            index_[fblock] = block_index;
+        }
+    }
+}
+
 /** Write to the EEPROM.  NOTE!!! This is not necessarily atomic across
  * BLOCK_SIZE boundaries in the case of power loss.  The user should take this
  * into account as it relates to data integrity of a whole block.
@@ -130,9 +156,6 @@ void EEPROMEmulation::write(unsigned int index, const void *buf, size_t len)
     HASSERT((index + len) <= file_size());
 
     uint8_t* byte_data = (uint8_t*)buf;
-    uint8_t* shadow_data = (uint8_t*)buf;
-    unsigned shadow_index = index;
-    size_t shadow_len = len;
 
     while (len)
     {
@@ -191,11 +214,6 @@ void EEPROMEmulation::write(unsigned int index, const void *buf, size_t len)
         }
     }
 
-    if (shadowInRam_)
-    {
-        memcpy(shadow_ + shadow_index, shadow_data, shadow_len);
-    }
-
     updated_notification();
 }
 
@@ -205,6 +223,14 @@ void EEPROMEmulation::write(unsigned int index, const void *buf, size_t len)
  */
 void EEPROMEmulation::write_fblock(unsigned int index, const uint8_t data[])
 {
+    if (shadowInRam_)
+    {
+        /* A sector overflow below reads every other block from the shadow, so
+         * it has to be up to date block by block. */
+        unsigned ofs = index * BYTES_PER_BLOCK;
+        memcpy(shadow_ + ofs, data,
+            std::min((size_t)BYTES_PER_BLOCK, file_size() - ofs));
+    }
     if (availableSlots_)
     {
         /* still have room in this sector for at least one more write */
@@ -216,6 +242,10 @@ void EEPROMEmulation::write_fblock(unsigned int index, const uint8_t data[])
                            (data[(i * 2) + 0] << 0);
         }
         flash_program(activeSector_, rawBlockCount_ - availableSlots_, slot_data, BLOCK_SIZE);
+        if (index_)
+        {
+            index_[index] = rawBlockCount_ - availableSlots_;
+        }
         --availableSlots_;
     }
     else
@@ -271,6 +301,10 @@ void EEPROMEmulation::write_fblock(unsigned int index, const uint8_t data[])
         flash_program(activeSector_, MAGIC_USED_INDEX, magic, BLOCK_SIZE);
         activeSector_ = new_sector;
         availableSlots_ = available_slots;
+        if (index_)
+        {
+            build_index();
+        }
     }
 }
 
@@ -290,6 +324,23 @@ void EEPROMEmulation::read(unsigned int offset, void *buf, size_t len)
     }
 
     uint8_t *byte_data = (uint8_t *)buf;
+
+    if (index_)
+    {
+        while (len)
+        {
+            uint8_t data[MAX_BLOCK_SIZE];
+            unsigned lsa = offset & (BYTES_PER_BLOCK - 1);
+            size_t copylen = std::min(len, (size_t)(BYTES_PER_BLOCK - lsa));
+            read_fblock(offset / BYTES_PER_BLOCK, data);
+            memcpy(byte_data, data + lsa, copylen);
+            offset += copylen;
+            byte_data += copylen;
+            len -= copylen;
+        }
+        return;
+    }
+
     memset(byte_data, 0xff, len); // default if data not found
 
     for (unsigned block_index = slot_first();
@@ -355,6 +406,22 @@ bool EEPROMEmulation::read_fblock(unsigned int index, uint8_t data[])
         }
         return false;
     }
+    else if (index_)
+    {
+        unsigned raw_block = index_[index];
+        if (!raw_block)
+        {
+            memset(data, 0xFF, BYTES_PER_BLOCK);
+            return false;
+        }
+        const uint32_t* address = block(activeSector_, raw_block);
+        for (unsigned int i = 0; i < BLOCK_SIZE / sizeof(uint32_t); ++i)
+        {
+            data[(i * 2) + 0] = (address[i] >> 0) & 0xFF;
+            data[(i * 2) + 1] = (address[i] >> 8) & 0xFF;
+        }
+        return true;
+    }
     else
     {
         /* default data value if not found */
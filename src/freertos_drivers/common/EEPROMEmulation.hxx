@@ -99,6 +99,11 @@ extern const char __eeprom_end;
  *  be allocated in RAM that will be pre-filled with the entire eeprom
  *  data. Dramatically speeds up reads, because reads will not have to go
  *  through the log anymore.
+ *  @param INDEX_IN_RAM: a boolean, if set to true, an index_ array will be
+ *  allocated in RAM with one 16-bit entry per BYTES_PER_BLOCK bytes of the
+ *  file, pointing at the slot holding the newest copy of each block. Reads
+ *  then go directly to the right slot instead of scanning the journal. Uses
+ *  2 / BYTES_PER_BLOCK times the RAM that SHADOW_IN_RAM would.
  *  @param file_size: The total number of bytes held by the emulated eeprom
  *  file. Reads from address 0 .. file_size - 1 will be valid. Must be smaller
  *  than half of one sector, but should be realistically about 35% of the
@@ -140,6 +145,7 @@ protected:
      */
     ~EEPROMEmulation()
     {
+        delete[] index_;
     }
 
     /** Mount the EEPROM file.  Should be called during construction of the
@@ -199,6 +205,12 @@ private:
      */
     static const bool SHADOW_IN_RAM;
 
+    /** Keep an index of the slot of every block in RAM. This will make reads
+     * independent of the number of slots in use, at the expense of two bytes
+     * of RAM per block.
+     */
+    static const bool INDEX_IN_RAM;
+
 protected:
     /** magic marker for an intact block */
     static const uint32_t MAGIC_INTACT;
@@ -240,6 +252,17 @@ private:
      */
     bool read_fblock(unsigned int index, uint8_t data[]);
 
+    /** Fills in index_ from the journal of the active sector. */
+    void build_index();
+
+    /** Number of blocks in the file.
+     * @return number of BYTES_PER_BLOCK sized blocks in the file.
+     */
+    unsigned fblock_count()
+    {
+        return (file_size() + BYTES_PER_BLOCK - 1) / BYTES_PER_BLOCK;
+    }
+
     /** Get the next active sector pointer.
      * @return sector index for the next sector to use.
      */
@@ -327,6 +350,11 @@ protected:
     /** pointer to RAM for shadowing EEPROM. */
     uint8_t *shadow_{nullptr};
 
+    /** For each block of the file, the raw block index of the slot holding
+     * its newest copy in the active sector, or 0 if the block was never
+     * written. nullptr if INDEX_IN_RAM is false. */
+    uint16_t *index_{nullptr};
+
 
     /** Default constructor.
      */
@@ -37,6 +37,7 @@
 // emulation implementation to prevent GCC from mistakenly optimizing away the
 // constant into a linker reference.
 const bool __attribute__((weak)) EEPROMEmulation::SHADOW_IN_RAM = false;
+const bool __attribute__((weak)) EEPROMEmulation::INDEX_IN_RAM = false;
 
 /// This function will be called after every write. The default
 /// implementation is a weak symbol with an empty function. It is intended
@@ -120,3 +120,12 @@ void *buffer_malloc(size_t length)
     void *volatile v = usb_malloc(length);
     return v;
 }
+
+/// Frees a buffer. Overrides the (weak) definition, which would hand the
+/// USB RAM block returned by buffer_malloc to free(). The segment has no way
+/// to release memory, so a block given back here (e.g. by a DynamicPool with
+/// a trim watermark) is lost; do not enable pool trimming on this target.
+/// @param buffer is a block returned by buffer_malloc.
+void buffer_free(void *buffer)
+{
+}
@@ -35,6 +35,7 @@
 
 #include <set>
 
+#include "nmranet_config.h"
 #include "os/OS.hxx"
 #include "utils/logging.h"
 
@@ -63,15 +64,20 @@ static NodeAlias resolve_notresponding(NodeAlias stored)
 #if defined(TEST_CONSISTENCY)
 extern volatile int consistency_result;
 volatile int consistency_result = 0;
+/// Benchmarks clear this to skip the consistency check after every
+/// operation.
+extern bool alias_cache_check_consistency;
+bool alias_cache_check_consistency = true;
 
 int AliasCache::check_consistency()
 {
-    if (idMap.size() != aliasMap.size())
+    if (hashed ? idHash.size() != aliasHash.size()
+               : idMap.size() != aliasMap.size())
     {
         LOG(INFO, "idmap size != aliasmap size.");
         return 1;
     }
-    if (aliasMap.size() == entries)
+    if (index_size() == entries)
     {
         if (!freeList.empty())
         {
@@ -87,7 +93,7 @@ int AliasCache::check_consistency()
             return 3;
         }
     }
-    if (aliasMap.size() == 0 && (!oldest.empty() || !newest.empty()))
+    if (index_size() == 0 && (!oldest.empty() || !newest.empty()))
     {
         LOG(INFO, "LRU head/tail elements should be null when map is empty.");
         return 4;
@@ -103,7 +109,7 @@ int AliasCache::check_consistency()
         }
         free_entries.insert(m);
     }
-    if (free_entries.size() + aliasMap.size() != entries)
+    if (free_entries.size() + index_size() != entries)
     {
         LOG(INFO, "Lost some metadata entries.");
         return 6;
@@ -124,7 +130,25 @@ int AliasCache::check_consistency()
             return 20;
         }
     }
-    if (aliasMap.size() == 0)
+    for (unsigned i = 0; i < aliasHash.capacity(); ++i)
+    {
+        PoolIdx kv = aliasHash.slot(i);
+        if (!kv.empty() && free_entries.count(kv.deref(this)))
+        {
+            LOG(INFO, "Found an alias hash entry in the freelist.");
+            return 28;
+        }
+    }
+    for (unsigned i = 0; i < idHash.capacity(); ++i)
+    {
+        PoolIdx kv = idHash.slot(i);
+        if (!kv.empty() && free_entries.count(kv.deref(this)))
+        {
+            LOG(INFO, "Found an id hash entry in the freelist.");
+            return 29;
+        }
+    }
+    if (index_size() == 0)
     {
         if (!oldest.empty())
         {
@@ -160,7 +184,7 @@ int AliasCache::check_consistency()
             return 12; // newest is free
         }
     }
-    if (aliasMap.size() == 0)
+    if (index_size() == 0)
     {
         return 0;
     }
@@ -194,7 +218,7 @@ int AliasCache::check_consistency()
             LOG(INFO, "Prev link points to newest.");
             return 18;
         }
-        if (count != aliasMap.size())
+        if (count != index_size())
         {
             LOG(INFO, "LRU link list length is incorrect.");
             return 27;
@@ -235,23 +259,23 @@ int AliasCache::check_consistency()
             continue;
         }
         auto *e = pool + i;
-        if (idMap.find(e->get_node_id()) == idMap.end())
+        if (find_id(e->get_node_id()).empty())
         {
             LOG(INFO, "Metadata ID is not in the id map.");
             return 23;
         }
-        if (idMap.find(e->get_node_id())->idx_ != i)
+        if (find_id(e->get_node_id()).idx_ != i)
         {
             LOG(INFO,
                 "Id map entry does not point back to the expected index.");
             return 24;
         }
-        if (aliasMap.find(e->alias_) == aliasMap.end())
+        if (find_alias(e->alias_).empty())
         {
             LOG(INFO, "Metadata alias is not in the alias map.");
             return 25;
         }
-        if (aliasMap.find(e->alias_)->idx_ != i)
+        if (find_alias(e->alias_).idx_ != i)
         {
             LOG(INFO,
                 "Alis map entry does not point back to the expected index.");
@@ -263,10 +287,166 @@ int AliasCache::check_consistency()
 
 #endif
 
+template <class Key> void AliasCache::HashIndex<Key>::reserve(size_t entries)
+{
+    // Keeps the load factor at or below 1/2.
+    unsigned bits = 2;
+    while ((1u << bits) < entries * 2)
+    {
+        ++bits;
+    }
+    delete[] slots_;
+    slots_ = new uint16_t[1u << bits];
+    mask_ = (1u << bits) - 1;
+    shift_ = 32 - bits;
+    clear();
+}
+
+template <class Key> void AliasCache::HashIndex<Key>::clear()
+{
+    for (unsigned i = 0; i < capacity(); ++i)
+    {
+        slots_[i] = NONE_ENTRY;
+    }
+    size_ = 0;
+}
+
+template <class Key>
+AliasCache::PoolIdx AliasCache::HashIndex<Key>::find(
+    typename Key::key_type key)
+{
+    PoolIdx ret;
+    for (unsigned i = home(key); slots_[i] != NONE_ENTRY; i = (i + 1) & mask_)
+    {
+        if (Key::get(parent_->pool + slots_[i]) == key)
+        {
+            ret.idx_ = slots_[i];
+            break;
+        }
+    }
+    return ret;
+}
+
+template <class Key> void AliasCache::HashIndex<Key>::insert(PoolIdx idx)
+{
+    unsigned i = home(Key::get(idx.deref(parent_)));
+    while (slots_[i] != NONE_ENTRY)
+    {
+        i = (i + 1) & mask_;
+    }
+    slots_[i] = idx.idx_;
+    ++size_;
+}
+
+template <class Key> void AliasCache::HashIndex<Key>::erase(PoolIdx idx)
+{
+    unsigned i = home(Key::get(idx.deref(parent_)));
+    while (slots_[i] != idx.idx_)
+    {
+        HASSERT(slots_[i] != NONE_ENTRY);
+        i = (i + 1) & mask_;
+    }
+    // Backward-shift deletion: moves every following entry of the probe
+    // sequence whose home slot is not between the hole and the entry into
+    // the hole.
+    for (unsigned j = (i + 1) & mask_; slots_[j] != NONE_ENTRY;
+         j = (j + 1) & mask_)
+    {
+        unsigned h = home(Key::get(parent_->pool + slots_[j]));
+        if (((j - h) & mask_) >= ((j - i) & mask_))
+        {
+            slots_[i] = slots_[j];
+            i = j;
+        }
+    }
+    slots_[i] = NONE_ENTRY;
+    --size_;
+}
+
+void AliasCache::init_index(IndexType index)
+{
+    if (index == INDEX_AUTO)
+    {
+        size_t min_entries = config_alias_cache_hash_min_entries();
+        index = (min_entries > 0 && entries >= min_entries) ? INDEX_HASHED
+                                                            : INDEX_SORTED;
+    }
+    hashed = (index == INDEX_HASHED);
+    if (hashed)
+    {
+        aliasHash.reserve(entries);
+        idHash.reserve(entries);
+    }
+    else
+    {
+        aliasMap.reserve(entries);
+        idMap.reserve(entries);
+    }
+}
+
+AliasCache::PoolIdx AliasCache::find_alias(NodeAlias alias)
+{
+    if (hashed)
+    {
+        return aliasHash.find(alias);
+    }
+    auto it = aliasMap.find(alias);
+    if (it == aliasMap.end())
+    {
+        return PoolIdx();
+    }
+    return *it;
+}
+
+AliasCache::PoolIdx AliasCache::find_id(NodeID id)
+{
+    if (hashed)
+    {
+        return idHash.find(id);
+    }
+    auto it = idMap.find(id);
+    if (it == idMap.end())
+    {
+        return PoolIdx();
+    }
+    return *it;
+}
+
+void AliasCache::index_insert(PoolIdx idx)
+{
+    if (hashed)
+    {
+        aliasHash.insert(idx);
+        idHash.insert(idx);
+    }
+    else
+    {
+        aliasMap.insert(PoolIdx(idx));
+        idMap.insert(PoolIdx(idx));
+    }
+}
+
+void AliasCache::index_erase(PoolIdx idx)
+{
+    if (hashed)
+    {
+        aliasHash.erase(idx);
+        idHash.erase(idx);
+    }
+    else
+    {
+        Metadata *metadata = idx.deref(this);
+        aliasMap.erase(aliasMap.find(metadata->alias_));
+        idMap.erase(idMap.find(metadata->get_node_id()));
+    }
+}
+
 void AliasCache::clear()
 {
     idMap.clear();
     aliasMap.clear();
+    idHash.clear();
+    aliasHash.clear();
     oldest.idx_ = NONE_ENTRY;
     newest.idx_ = NONE_ENTRY;
     freeList.idx_ = NONE_ENTRY;
@@ -301,16 +481,16 @@ void AliasCache::add(NodeID id, NodeAlias alias)
     
     Metadata *insert;
 
-    auto it = aliasMap.find(alias);
-    if (alias == NOT_RESPONDING)
+    PoolIdx it;
+    if (alias != NOT_RESPONDING)
     {
         // We can have more than one NOT_RESPONDING entry.
-        it = aliasMap.end();
+        it = find_alias(alias);
     }
-    if (it != aliasMap.end())
+    if (!it.empty())
     {
         /* we already have a mapping for this alias, so lets remove it */
-        insert = it->deref(this);
+        insert = it.deref(this);
         auto nid = insert->get_node_id();
         remove(insert->alias_);
 
@@ -320,11 +500,11 @@ void AliasCache::add(NodeID id, NodeAlias alias)
             (*removeCallback)(nid, insert->alias_, context);
         }
     }
-    auto nit = idMap.find(id);
-    if (nit != idMap.end())
+    PoolIdx nit = find_id(id);
+    if (!nit.empty())
     {
         /* we already have a mapping for this id, so lets remove it */
-        insert = nit->deref(this);
+        insert = nit.deref(this);
         auto nid = insert->get_node_id();
         remove(insert->alias_);
 
@@ -356,10 +536,10 @@ void AliasCache::add(NodeID id, NodeAlias alias)
         {
             newest.idx_ = NONE_ENTRY;
         }
+        PoolIdx evicted = oldest;
         oldest = second;
 
-        aliasMap.erase(aliasMap.find(insert->alias_));
-        idMap.erase(idMap.find(insert->get_node_id()));
+        index_erase(evicted);
 
         if (removeCallback)
         {
@@ -373,16 +553,14 @@ void AliasCache::add(NodeID id, NodeAlias alias)
         // This code will make all NOT_RESPONDING aliases unique in our map.
         unsigned ofs = insert - pool;
         alias = NOT_RESPONDING | ofs;
-        auto it = aliasMap.find(alias);
-        HASSERT(it == aliasMap.end());
+        HASSERT(find_alias(alias).empty());
     }
     insert->set_node_id(id);
     insert->alias_ = alias;
 
     PoolIdx n;
     n.idx_ = insert - pool;
-    aliasMap.insert(PoolIdx(n));
-    idMap.insert(PoolIdx(n));
+    index_insert(n);
 
     /* update the time based list */
     insert->newer_.idx_ = NONE_ENTRY;
@@ -403,8 +581,11 @@ void AliasCache::add(NodeID id, NodeAlias alias)
     newest = n;
 
 #if defined(TEST_CONSISTENCY)
-    consistency_result = check_consistency();
-    HASSERT(0 == consistency_result);
+    if (alias_cache_check_consistency)
+    {
+        consistency_result = check_consistency();
+        HASSERT(0 == consistency_result);
+    }
 #endif
 }
 
@@ -415,13 +596,12 @@ void AliasCache::add(NodeID id, NodeAlias alias)
  */
 void AliasCache::remove(NodeAlias alias)
 {
-    auto it = aliasMap.find(alias);
+    PoolIdx it = find_alias(alias);
 
-    if (it != aliasMap.end())
+    if (!it.empty())
     {
-        Metadata *metadata = it->deref(this);
-        aliasMap.erase(it);
-        idMap.erase(idMap.find(metadata->get_node_id()));
+        Metadata *metadata = it.deref(this);
+        index_erase(it);
         // Ensures that the AME query handler does not find this metadata.
         metadata->set_node_id(0);
 
@@ -449,8 +629,11 @@ void AliasCache::remove(NodeAlias alias)
     }
 
 #if defined(TEST_CONSISTENCY)
-    consistency_result = check_consistency();
-    HASSERT(0 == consistency_result);
+    if (alias_cache_check_consistency)
+    {
+        consistency_result = check_consistency();
+        HASSERT(0 == consistency_result);
+    }
 #endif
 }
 
@@ -475,12 +658,33 @@ bool AliasCache::retrieve(unsigned entry, NodeID* node, NodeAlias* alias)
 
 bool AliasCache::next_entry(NodeID bound, NodeID *node, NodeAlias *alias)
 {
-    auto it = idMap.upper_bound(bound);
-    if (it == idMap.end())
+    Metadata *metadata = nullptr;
+    if (hashed)
     {
-        return false;
+        // There is no ordering by node ID; scans all live entries.
+        for (PoolIdx idx = newest; !idx.empty(); idx = idx.deref(this)->older_)
+        {
+            Metadata *m = idx.deref(this);
+            NodeID id = m->get_node_id();
+            if (id > bound && (!metadata || id < metadata->get_node_id()))
+            {
+                metadata = m;
+            }
+        }
+        if (!metadata)
+        {
+            return false;
+        }
+    }
+    else
+    {
+        auto it = idMap.upper_bound(bound);
+        if (it == idMap.end())
+        {
+            return false;
+        }
+        metadata = it->deref(this);
     }
-    Metadata *metadata = it->deref(this);
     if (alias)
     {
         *alias = resolve_notresponding(metadata->alias_);
@@ -500,11 +704,11 @@ NodeAlias AliasCache::lookup(NodeID id)
 {
     HASSERT(id != 0);
 
-    auto it = idMap.find(id);
+    PoolIdx it = find_id(id);
 
-    if (it != idMap.end())
+    if (!it.empty())
     {
-        Metadata *metadata = it->deref(this);
+        Metadata *metadata = it.deref(this);
 
         /* update timestamp */
         touch(metadata);
@@ -526,11 +730,11 @@ NodeID AliasCache::lookup(NodeAlias alias)
         return 0;
     }
 
-    auto it = aliasMap.find(alias);
+    PoolIdx it = find_alias(alias);
 
-    if (it != aliasMap.end())
+    if (!it.empty())
     {
-        Metadata *metadata = it->deref(this);
+        Metadata *metadata = it.deref(this);
 
         /* update timestamp */
         touch(metadata);
@@ -602,8 +806,11 @@ void AliasCache::touch(Metadata* metadata)
         newest.idx_ = metadata - pool;
     }
 #if defined(TEST_CONSISTENCY)
-    consistency_result = check_consistency();
-    HASSERT(0 == consistency_result);
+    if (alias_cache_check_consistency)
+    {
+        consistency_result = check_consistency();
+        HASSERT(0 == consistency_result);
+    }
 #endif
 }
 
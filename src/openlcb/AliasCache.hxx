@@ -82,30 +82,55 @@ namespace openlcb
  *
  * A similar sorted vector is kept sorted by the NodeID values. This also takes
  * only 2 bytes per entry.
+ *
+ * Inserting into and removing from the sorted vectors is O(n). For caches with
+ * thousands of entries (e.g. the remote alias cache of a gateway) the two
+ * sorted vectors can be replaced by open-addressing hash tables (see
+ * IndexType). These use linear probing with backward-shift deletion, take 4-8
+ * bytes per entry each and make add, remove and lookup O(1). The LRU list is
+ * the same in both modes; next_entry() however becomes O(n) with the hash
+ * tables, as there is no ordering by Node ID then.
  */
 class AliasCache
 {
 public:
+    /// Selects the data structure used for looking up entries by alias and by
+    /// Node ID.
+    enum IndexType
+    {
+        /// Uses hash tables if the number of entries is at least
+        /// config_alias_cache_hash_min_entries(), sorted vectors otherwise.
+        INDEX_AUTO,
+        /// Sorted vectors: 2 bytes per entry, O(n) add and remove.
+        INDEX_SORTED,
+        /// Open-addressing hash tables: 8-16 bytes per entry, O(1) add and
+        /// remove, O(n) next_entry.
+        INDEX_HASHED,
+    };
+
     /** Constructor.
      * @param seed starting seed for generation of aliases
      * @param entries maximum number of entries in this cache
      * @param remove_callback callback to call when we remove a mapping from
      *        the cache however it will not be called in the remove() method
      * @param context context pointer to pass to remove_callback
+     * @param index which lookup data structure to use
      */
     AliasCache(NodeID seed, size_t _entries,
         void (*remove_callback)(NodeID id, NodeAlias alias, void *) = NULL,
-        void *context = NULL)
+        void *context = NULL, IndexType index = INDEX_AUTO)
         : pool(new Metadata[_entries])
         , aliasMap(this)
         , idMap(this)
+        , aliasHash(this)
+        , idHash(this)
         , seed(seed)
         , entries(_entries)
         , removeCallback(remove_callback)
         , context(context)
     {
-        aliasMap.reserve(_entries);
-        idMap.reserve(_entries);
+        HASSERT(_entries < NONE_ENTRY);
+        init_index(index);
         clear();
     }
 
@@ -153,6 +178,12 @@ public:
         return entries;
     }
 
+    /** @return true if this cache uses hash tables for the lookups. */
+    bool is_hashed()
+    {
+        return hashed;
+    }
+
     /** Retrieves an entry by index. Allows stable iteration in the face of
      * changes.
      * @param entry is between 0 and size() - 1.
@@ -339,12 +370,139 @@ private:
     /** Short hand for the ID Map type */
     typedef SortedListSet<PoolIdx, IdComparator> IdMap;
 
+    /// Key accessor for the alias hash table.
+    struct AliasKey
+    {
+        /// Type of the key.
+        typedef NodeAlias key_type;
+        /// @param m pool entry
+        /// @return the key of the pool entry.
+        static key_type get(Metadata *m)
+        {
+            return m->alias_;
+        }
+        /// @param key alias
+        /// @return hash value of the key.
+        static uint32_t hash(key_type key)
+        {
+            return key * 0x9E3779B1u;
+        }
+    };
+
+    /// Key accessor for the Node ID hash table.
+    struct IdKey
+    {
+        /// Type of the key.
+        typedef NodeID key_type;
+        /// @param m pool entry
+        /// @return the key of the pool entry.
+        static key_type get(Metadata *m)
+        {
+            return m->get_node_id();
+        }
+        /// @param key node ID
+        /// @return hash value of the key.
+        static uint32_t hash(key_type key)
+        {
+            return (key * UINT64_C(0x9E3779B97F4A7C15)) >> 32;
+        }
+    };
+
+    /// Open-addressing hash table of pool indexes, keyed by a property of the
+    /// referenced Metadata entry. Uses linear probing and backward-shift
+    /// deletion, so there are no tombstones to clean up under churn.
+    template <class Key> class HashIndex
+    {
+    public:
+        /// Constructor.
+        /// @param parent owning AliasCache.
+        HashIndex(AliasCache *parent)
+            : parent_(parent)
+        {
+        }
+
+        ~HashIndex()
+        {
+            delete[] slots_;
+        }
+
+        /// Allocates the table.
+        /// @param entries maximum number of entries that will be stored.
+        void reserve(size_t entries);
+
+        /// Removes all entries.
+        void clear();
+
+        /// @param key what to look for
+        /// @return the pool index with the given key, or empty if not found.
+        PoolIdx find(typename Key::key_type key);
+
+        /// Adds an entry. The key must not be in the table yet.
+        /// @param idx pool index to add.
+        void insert(PoolIdx idx);
+
+        /// Removes an entry. The key of the entry must not have changed since
+        /// it was inserted.
+        /// @param idx pool index to remove.
+        void erase(PoolIdx idx);
+
+        /// @return number of entries stored.
+        size_t size()
+        {
+            return size_;
+        }
+
+        /// @return number of slots in the table.
+        size_t capacity()
+        {
+            return slots_ ? mask_ + 1 : 0;
+        }
+
+        /// @param i slot number, 0 <= i < capacity().
+        /// @return the pool index stored in the slot (may be empty).
+        PoolIdx slot(unsigned i)
+        {
+            PoolIdx ret;
+            ret.idx_ = slots_[i];
+            return ret;
+        }
+
+    private:
+        /// @param key key to hash
+        /// @return home slot of the key.
+        unsigned home(typename Key::key_type key)
+        {
+            return Key::hash(key) >> shift_;
+        }
+
+        /// AliasCache whose pool we are indexing into.
+        AliasCache *parent_;
+        /// Hash table slots, holding pool indexes or NONE_ENTRY.
+        uint16_t *slots_ {nullptr};
+        /// Number of slots minus one. Number of slots is a power of two.
+        unsigned mask_ {0};
+        /// Shift to turn a 32-bit hash into a slot number.
+        unsigned shift_ {32};
+        /// Number of entries stored.
+        size_t size_ {0};
+    };
+
     /** Map of alias to corresponding Metadata */
     AliasMap aliasMap;
     
     /** Map of Node ID to corresponding Metadata */
     IdMap idMap;
 
+    /** Hashed map of alias to corresponding Metadata */
+    HashIndex<AliasKey> aliasHash;
+
+    /** Hashed map of Node ID to corresponding Metadata */
+    HashIndex<IdKey> idHash;
+
+    /** true if we are using aliasHash and idHash instead of aliasMap and
+     * idMap. */
+    bool hashed;
+
     /** list of unused mapping entries (index into pool) */
     PoolIdx freeList;
 
@@ -371,6 +529,33 @@ private:
      */
     void touch(Metadata* metadata);
 
+    /** Sets up the lookup data structures.
+     * @param index which data structure to use. */
+    void init_index(IndexType index);
+
+    /** @return number of entries in the lookup structures. */
+    size_t index_size()
+    {
+        return hashed ? aliasHash.size() : aliasMap.size();
+    }
+
+    /** @param alias alias to look for
+     * @return pool index of the entry with the given alias or empty. */
+    PoolIdx find_alias(NodeAlias alias);
+
+    /** @param id Node ID to look for
+     * @return pool index of the entry with the given Node ID or empty. */
+    PoolIdx find_id(NodeID id);
+
+    /** Adds a pool entry to the lookup structures.
+     * @param idx pool index of the entry to add. */
+    void index_insert(PoolIdx idx);
+
+    /** Removes a pool entry from the lookup structures. Must be called before
+     * the alias or node ID of the entry changes.
+     * @param idx pool index of the entry to remove. */
+    void index_erase(PoolIdx idx);
+
     DISALLOW_COPY_AND_ASSIGN(AliasCache);
 };
 
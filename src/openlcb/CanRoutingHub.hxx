@@ -52,8 +52,12 @@ namespace openlcb
    GridConnect protocol, performs routing decisions on the frames and sends out
    to the appropriate ports.
 
-   TODO: need to process consumer and producer identified messages.
-   TODO: need to exclude CHECK ID frames from the source address learning.
+   Addressed messages are routed to the port where the destination alias was
+   last seen as a source. Event reports are routed only to the ports where a
+   consumer or producer (or a range thereof) was identified for the given
+   event. Event reports for events that no port has declared interest in are
+   dropped, unless set_flood_unknown_events() is enabled, in which case they
+   are sent to all ports.
  */
 class GcCanRoutingHub : public HubPortInterface
 {
@@ -81,9 +85,12 @@ public:
             return;
         }
         const string &p = *b->data();
-        for (unsigned i = 0; i < p.size(); ++i)
+        for (size_t i = 0; i < p.size();)
         {
-            if (it->second.segmenter_.consume_byte(p[i]))
+            bool has_frame;
+            i += it->second.segmenter_.consume_data(
+                p.data() + i, p.size() - i, &has_frame);
+            if (has_frame)
             {
                 // We have a frame.
                 string ret;
@@ -116,6 +123,30 @@ public:
         ports_[port].hubPort_ = port;
     }
 
+    /// Sets what to do with event reports for which no port has identified
+    /// a consumer or producer.
+    /// @param flood if true, such event reports will be sent to all ports; if
+    /// false (default), they will be dropped.
+    void set_flood_unknown_events(bool flood)
+    {
+        OSMutexLock l(&lock_);
+        floodUnknownEvents_ = flood;
+    }
+
+    /// @param port a registered port.
+    /// @return the number of event report frames that were not sent to port
+    /// because there was no interested party on that port.
+    unsigned get_suppressed_frames(HubPortInterface *port)
+    {
+        OSMutexLock l(&lock_);
+        auto it = ports_.find(port);
+        if (it == ports_.end())
+        {
+            return 0;
+        }
+        return it->second.suppressedFrames_;
+    }
+
     void unregister_port(HubPortInterface *port)
     {
         OSMutexLock l(&lock_);
@@ -166,6 +197,8 @@ private:
             for (void *p : parent_->pendingRemove_)
             {
                 parent_->ports_.erase(p);
+                parent_->routingTable_.remove_port(
+                    static_cast<CanHubPortInterface *>(p));
             }
             parent_->pendingRemove_.clear();
 
@@ -178,6 +211,11 @@ private:
                 return release_and_exit();
             }
             classify_frame(frame);
+            if (forwardType_ == EVENT && parent_->floodUnknownEvents_ &&
+                !parent_->routingTable_.check_pcer_any_port(event_))
+            {
+                forwardType_ = FORWARD_ALL;
+            }
 
             if (srcAddress_ != 0)
             {
@@ -328,6 +366,11 @@ private:
                 {
                     forward_to_port();
                 }
+                else if (!nextIt_->second.inactive_ &&
+                    nextIt_->first != message()->data()->skipMember_)
+                {
+                    ++nextIt_->second.suppressedFrames_;
+                }
             }
             else
             {
@@ -422,6 +465,8 @@ private:
         /// If true, we must not send any data to this target, because it has
         /// been unregistered.
         bool inactive_{false};
+        /// How many event reports were not sent to this port.
+        unsigned suppressedFrames_{0};
         GcStreamParser segmenter_;
         CanHubPortInterface *canPort_{nullptr};
         HubPortInterface *hubPort_{nullptr};
@@ -433,8 +478,11 @@ private:
      * delay applying unregister requests until the next packet is being
      * sent. */
     std::vector<void *> pendingRemove_;
+    /// If true, event reports without any known interested port are sent to
+    /// all ports.
+    bool floodUnknownEvents_{false};
 
-    RoutingLogic<CanHubPortInterface, NodeAlias> routingTable_;
+    FlatRoutingLogic<CanHubPortInterface, NodeAlias> routingTable_;
 };
 
 } // namespace openlcb
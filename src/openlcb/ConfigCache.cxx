@@ -0,0 +1,270 @@
+/** \copyright
+ * Copyright (c) 2026, OpenMRN contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file ConfigCache.cxx
+ *
+ * In-RAM image of the configuration file.
+ *
+ * @author OpenMRN contributors
+ * @date 17 Oct 2026
+ */
+
+#include "openlcb/ConfigCache.hxx"
+
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "utils/FdUtils.hxx"
+#include "utils/logging.h"
+
+namespace openlcb
+{
+
+ConfigCache::ConfigCache(int fd, size_t size)
+    : fd_(fd)
+    , size_(size)
+    , image_(new uint8_t[size])
+{
+    load(image_);
+    // Nobody has seen this image yet.
+    add_range(&changed_, 0, size_);
+}
+
+ConfigCache::~ConfigCache()
+{
+    flush();
+    delete[] image_;
+}
+
+void ConfigCache::load(uint8_t *buf)
+{
+    int ret = lseek(fd_, 0, SEEK_SET);
+    ERRNOCHECK("seek_config", ret);
+    size_t ofs = 0;
+    while (ofs < size_)
+    {
+        ssize_t r = ::read(fd_, buf + ofs, size_ - ofs);
+        ERRNOCHECK("read_config", r);
+        if (r == 0)
+        {
+            break;
+        }
+        ofs += r;
+    }
+    memset(buf + ofs, 0xFF, size_ - ofs);
+}
+
+bool ConfigCache::read(unsigned offset, void *buf, size_t len)
+{
+    if (offset + len > size_)
+    {
+        return false;
+    }
+    OSMutexLock h(&lock_);
+    memcpy(buf, image_ + offset, len);
+    return true;
+}
+
+bool ConfigCache::write(unsigned offset, const void *buf, size_t len)
+{
+    if (offset + len > size_)
+    {
+        return false;
+    }
+    {
+        OSMutexLock h(&lock_);
+        if (memcmp(image_ + offset, buf, len) == 0)
+        {
+            // Rewriting the same value is common (e.g. trimming, defaults);
+            // it needs neither a flash write nor a listener call.
+            return true;
+        }
+        memcpy(image_ + offset, buf, len);
+        add_range(&dirty_, offset, offset + len);
+        add_range(&changed_, offset, offset + len);
+        if (batchDepth_)
+        {
+            return true;
+        }
+    }
+    flush();
+    return true;
+}
+
+void ConfigCache::start_batch()
+{
+    OSMutexLock h(&lock_);
+    ++batchDepth_;
+}
+
+void ConfigCache::end_batch()
+{
+    {
+        OSMutexLock h(&lock_);
+        HASSERT(batchDepth_);
+        if (--batchDepth_)
+        {
+            return;
+        }
+    }
+    flush();
+}
+
+void ConfigCache::flush()
+{
+    OSMutexLock io(&ioLock_);
+    flush_io_locked();
+}
+
+void ConfigCache::flush_io_locked()
+{
+    std::vector<Range> ranges;
+    std::vector<uint8_t> data;
+    {
+        OSMutexLock h(&lock_);
+        if (dirty_.empty())
+        {
+            return;
+        }
+        ranges.swap(dirty_);
+        size_t total = 0;
+        for (const Range &r : ranges)
+        {
+            total += r.second - r.first;
+        }
+        data.resize(total);
+        uint8_t *dst = data.data();
+        for (const Range &r : ranges)
+        {
+            memcpy(dst, image_ + r.first, r.second - r.first);
+            dst += r.second - r.first;
+        }
+    }
+    // Writes arriving from now on go to dirty_ again and are written by the
+    // next flush.
+    const uint8_t *src = data.data();
+    for (const Range &r : ranges)
+    {
+        int ret = lseek(fd_, r.first, SEEK_SET);
+        ERRNOCHECK("seek_config", ret);
+        FdUtils::repeated_write(fd_, src, r.second - r.first);
+        src += r.second - r.first;
+        ++numFileWrites_;
+    }
+}
+
+void ConfigCache::reload()
+{
+    OSMutexLock io(&ioLock_);
+    flush_io_locked();
+    uint8_t *fresh = new uint8_t[size_];
+    load(fresh);
+    {
+        OSMutexLock h(&lock_);
+        // Writes that arrived since the flush are newer than the file.
+        for (const Range &r : dirty_)
+        {
+            memcpy(fresh + r.first, image_ + r.first, r.second - r.first);
+        }
+        unsigned i = 0;
+        while (i < size_)
+        {
+            if (fresh[i] == image_[i])
+            {
+                ++i;
+                continue;
+            }
+            unsigned begin = i;
+            while (i < size_ && fresh[i] != image_[i])
+            {
+                ++i;
+            }
+            add_range(&changed_, begin, i);
+        }
+        std::swap(fresh, image_);
+    }
+    delete[] fresh;
+}
+
+bool ConfigCache::is_changed(unsigned offset, size_t len)
+{
+    if (offset + len > size_)
+    {
+        // We do not track changes outside of the cached area.
+        return true;
+    }
+    OSMutexLock h(&lock_);
+    for (const Range &r : changed_)
+    {
+        if (r.first >= offset + len)
+        {
+            // Ranges are sorted.
+            break;
+        }
+        if (r.second > offset)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ConfigCache::clear_changes()
+{
+    OSMutexLock h(&lock_);
+    changed_.clear();
+}
+
+void ConfigCache::add_range(
+    std::vector<Range> *ranges, unsigned begin, unsigned end)
+{
+    // Finds the first range that ends at or after begin.
+    auto it = ranges->begin();
+    while (it != ranges->end() && it->second < begin)
+    {
+        ++it;
+    }
+    if (it == ranges->end() || it->first > end)
+    {
+        // No overlap with an existing range.
+        ranges->insert(it, Range(begin, end));
+        return;
+    }
+    // Merges with every range that overlaps or touches.
+    it->first = std::min(it->first, begin);
+    it->second = std::max(it->second, end);
+    auto next = it + 1;
+    while (next != ranges->end() && next->first <= it->second)
+    {
+        it->second = std::max(it->second, next->second);
+        ++next;
+    }
+    ranges->erase(it + 1, next);
+}
+
+} // namespace openlcb
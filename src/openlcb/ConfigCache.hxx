@@ -0,0 +1,178 @@
+/** \copyright
+ * Copyright (c) 2026, OpenMRN contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file ConfigCache.hxx
+ *
+ * In-RAM image of the configuration file.
+ *
+ * @author OpenMRN contributors
+ * @date 17 Oct 2026
+ */
+
+#ifndef _OPENLCB_CONFIGCACHE_HXX_
+#define _OPENLCB_CONFIGCACHE_HXX_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <utility>
+#include <vector>
+
+#include "os/OS.hxx"
+#include "utils/Singleton.hxx"
+
+namespace openlcb
+{
+
+/// Keeps the whole configuration file in RAM. The ConfigEntry read and write
+/// calls on the file descriptor of the cache are served from the image
+/// instead of issuing a seek and a read or write system call per field.
+///
+/// Writes go to the image and through to the file before the write call
+/// returns, so code reading the file descriptor directly (e.g. the memory
+/// config protocol) sees them, and they survive a reset. Between
+/// start_batch() and end_batch() the writes are collected as dirty ranges
+/// instead, and written to the file with a few large writes at the end of
+/// the batch. The ConfigUpdateFlow uses a batch for the factory reset.
+///
+/// The cache also tracks which byte ranges changed. reload() picks up the
+/// changes that were written to the file bypassing the cache (e.g. by the
+/// memory config protocol). The ConfigUpdateFlow uses the changed ranges to
+/// call only those listeners whose configuration changed.
+class ConfigCache : public Singleton<ConfigCache>
+{
+public:
+    /// Constructor. Loads the file image. The entire image is marked as
+    /// changed.
+    /// @param fd is the configuration file, open for reading and writing.
+    /// @param size is the number of bytes to cache, from offset 0. If the
+    /// file is shorter, the rest reads as 0xFF.
+    ConfigCache(int fd, size_t size);
+
+    /// Destructor. Flushes the pending writes.
+    ~ConfigCache();
+
+    /// @return the file descriptor this cache belongs to.
+    int fd()
+    {
+        return fd_;
+    }
+
+    /// Reads data from the image.
+    /// @param offset is the file offset to read from.
+    /// @param buf is where to copy the data.
+    /// @param len is the number of bytes to read.
+    /// @return false if the range is not (entirely) cached; nothing is copied
+    /// then.
+    bool read(unsigned offset, void *buf, size_t len);
+
+    /// Writes data to the image and marks it as changed. Unless a batch is
+    /// open, also writes it to the file.
+    /// @param offset is the file offset to write to.
+    /// @param buf is the data to write.
+    /// @param len is the number of bytes to write.
+    /// @return false if the range is not (entirely) cached; nothing is
+    /// written then.
+    bool write(unsigned offset, const void *buf, size_t len);
+
+    /// Starts collecting the writes in RAM. Batches may be nested.
+    void start_batch();
+
+    /// Ends a batch started by start_batch(). When the outermost batch ends,
+    /// writes the collected writes to the file.
+    void end_batch();
+
+    /// Writes every dirty range back to the file.
+    void flush();
+
+    /// Flushes the dirty ranges, then reads the file again. The ranges where
+    /// the file differs from the image are marked as changed.
+    void reload();
+
+    /// @param offset is the start of a range in the file.
+    /// @param len is the length of the range.
+    /// @return true if any byte in the range changed since the last call to
+    /// clear_changes(), or if the range is not (entirely) cached.
+    bool is_changed(unsigned offset, size_t len);
+
+    /// Forgets about all changes.
+    void clear_changes();
+
+    /// @return the number of write system calls issued by flush() so far.
+    unsigned num_file_writes()
+    {
+        return numFileWrites_;
+    }
+
+private:
+    /// A range of bytes in the file; first is the start offset, second is the
+    /// end offset (exclusive).
+    typedef std::pair<unsigned, unsigned> Range;
+
+    /// Adds a range to a sorted list of disjoint ranges, merging it with the
+    /// ranges it overlaps or touches.
+    /// @param ranges is the list to add to.
+    /// @param begin is the start offset.
+    /// @param end is the end offset (exclusive).
+    static void add_range(std::vector<Range> *ranges, unsigned begin,
+        unsigned end);
+
+    /// Reads size_ bytes of the file from offset 0, padding with 0xFF.
+    /// @param buf is where to read the data to.
+    void load(uint8_t *buf);
+
+    /// Implementation of flush(). Copies the dirty ranges under lock_, then
+    /// writes them to the file without holding lock_. Caller must hold
+    /// ioLock_.
+    void flush_io_locked();
+
+    /// File descriptor of the configuration file.
+    int fd_;
+    /// Number of bytes cached.
+    size_t size_;
+    /// Image of the first size_ bytes of the file.
+    uint8_t *image_;
+    /// Ranges written to the image but not to the file.
+    std::vector<Range> dirty_;
+    /// Ranges that changed since the last clear_changes().
+    std::vector<Range> changed_;
+    /// Number of write system calls made by flush().
+    unsigned numFileWrites_ {0};
+    /// Number of start_batch() calls without a matching end_batch().
+    unsigned batchDepth_ {0};
+    /// Guards image_, dirty_, changed_ and batchDepth_. Never held during
+    /// file I/O.
+    OSMutex lock_;
+    /// Serializes the file I/O of flush() and reload(), so that an older
+    /// copy of a range never overwrites a newer one in the file.
+    OSMutex ioLock_;
+
+    DISALLOW_COPY_AND_ASSIGN(ConfigCache);
+};
+
+} // namespace openlcb
+
+#endif // _OPENLCB_CONFIGCACHE_HXX_
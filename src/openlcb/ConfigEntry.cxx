@@ -34,6 +34,8 @@
 
 #include "openlcb/ConfigEntry.hxx"
 
+#include "openlcb/ConfigCache.hxx"
+
 #include <sys/types.h>
 #include <unistd.h>
 #include "utils/logging.h"
@@ -44,6 +46,11 @@ namespace openlcb
 
 void ConfigEntryBase::repeated_read(int fd, void *buf, size_t size) const
 {
+    if (ConfigCache::exists() && ConfigCache::instance()->fd() == fd &&
+        ConfigCache::instance()->read(offset_, buf, size))
+    {
+        return;
+    }
     int ret = lseek(fd, offset_, SEEK_SET);
     ERRNOCHECK("seek_config", ret);
     FdUtils::repeated_read(fd, buf, size);
@@ -51,6 +58,11 @@ void ConfigEntryBase::repeated_read(int fd, void *buf, size_t size) const
 
 void ConfigEntryBase::repeated_write(int fd, const void *buf, size_t size) const
 {
+    if (ConfigCache::exists() && ConfigCache::instance()->fd() == fd &&
+        ConfigCache::instance()->write(offset_, buf, size))
+    {
+        return;
+    }
     int ret = lseek(fd, offset_, SEEK_SET);
     ERRNOCHECK("seek_config", ret);
     FdUtils::repeated_write(fd, buf, size);
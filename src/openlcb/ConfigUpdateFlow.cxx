@@ -37,9 +37,13 @@
 #include "openlcb/ConfigUpdateFlow.hxx"
 #include <fcntl.h>
 
+#include "nmranet_config.h"
+
 namespace openlcb
 {
 
+extern const size_t CONFIG_FILE_SIZE;
+
 int ConfigUpdateFlow::open_file(const char *path)
 {
     HASSERT(fd_ < 0);
@@ -51,11 +55,29 @@ int ConfigUpdateFlow::open_file(const char *path)
 
 void ConfigUpdateFlow::init_flow()
 {
+    if (config_enable_config_cache() == CONSTANT_TRUE && !cache_ && fd_ >= 0 &&
+        CONFIG_FILE_SIZE > 0)
+    {
+        enable_cache(CONFIG_FILE_SIZE);
+    }
     trigger_update();
 }
 
+void ConfigUpdateFlow::enable_cache(size_t size)
+{
+    HASSERT(fd_ >= 0);
+    cache_.reset();
+    cache_.reset(new ConfigCache(fd_, size));
+}
+
 void ConfigUpdateFlow::factory_reset()
 {
+    if (cache_)
+    {
+        // The listeners write many small fields; they go to the file with a
+        // few large writes at the end.
+        cache_->start_batch();
+    }
     for (auto it = listeners_.begin(); it != listeners_.end(); ++it) {
         it->factory_reset(fd_);
     }
@@ -64,6 +86,10 @@ void ConfigUpdateFlow::factory_reset()
     {
         it->factory_reset(fd_);
     }
+    if (cache_)
+    {
+        cache_->end_batch();
+    }
 }
 
 void ConfigUpdateFlow::register_update_listener(ConfigUpdateListener *listener)
@@ -37,7 +37,10 @@
 #ifndef _OPENLCB_CONFIGUPDATEFLOW_HXX_
 #define _OPENLCB_CONFIGUPDATEFLOW_HXX_
 
+#include <memory>
+
 #include "openmrn_features.h"
+#include "openlcb/ConfigCache.hxx"
 #include "utils/ConfigUpdateListener.hxx"
 #include "utils/ConfigUpdateService.hxx"
 #include "openlcb/NodeInitializeFlow.hxx"
@@ -67,6 +70,7 @@ public:
         , nextRefresh_(listeners_.begin())
         , needsReboot_(0)
         , needsReInit_(0)
+        , needsReload_(0)
         , fd_(-1)
     {
     }
@@ -74,8 +78,14 @@ public:
     /// Must be called once (only) before calling anything else. Returns the
     /// file descriptor.
     int open_file(const char *path);
-    /// Asynchronously invokes all update listeners with the config FD.
+    /// Asynchronously invokes all update listeners with the config FD. Turns
+    /// on the config cache if config_enable_config_cache() is set.
     void init_flow();
+    /// Loads the configuration file into a ConfigCache. Must be called after
+    /// open_file(), and after any changes to the file that bypass the
+    /// ConfigEntry write calls (such as resizing it).
+    /// @param size is the number of bytes to cache.
+    void enable_cache(size_t size);
     /// Synchronously invokes all update listeners to factory reset.
     void factory_reset();
 
@@ -86,6 +96,12 @@ public:
         return fd_;
     }
 
+    /// @return the config cache, or nullptr if the cache is not enabled.
+    ConfigCache *cache()
+    {
+        return cache_.get();
+    }
+
 #ifdef GTEST
     void TEST_set_fd(int fd)
     {
@@ -111,6 +127,7 @@ public:
         nextRefresh_ = listeners_.begin();
         needsReboot_ = 0;
         needsReInit_ = 0;
+        needsReload_ = 1;
         if (is_state(exit().next_state()))
         {
             start_flow(STATE(call_next_listener));
@@ -123,14 +140,36 @@ private:
     Action call_next_listener()
     {
         ConfigUpdateListener *l = nullptr;
+        bool reload = false;
+        {
+            AtomicHolder h(this);
+            reload = needsReload_;
+            needsReload_ = 0;
+        }
+        if (reload && cache_)
+        {
+            // Picks up the changes written to the file by others.
+            cache_->reload();
+        }
         {
             AtomicHolder h(this);
-            if (nextRefresh_ == listeners_.end())
+            while (true)
             {
-                return call_immediately(STATE(do_initial_load));
+                if (nextRefresh_ == listeners_.end())
+                {
+                    return call_immediately(STATE(do_initial_load));
+                }
+                l = nextRefresh_.operator->();
+                ++nextRefresh_;
+                unsigned offset, size;
+                if (cache_ && l->config_range(&offset, &size) &&
+                    !cache_->is_changed(offset, size))
+                {
+                    // Nothing changed that this listener would read.
+                    continue;
+                }
+                break;
             }
-            l = nextRefresh_.operator->();
-            ++nextRefresh_;
         }
         return call_listener(l, false);
     }
@@ -184,6 +223,10 @@ private:
 
     Action apply_action()
     {
+        if (cache_)
+        {
+            cache_->clear_changes();
+        }
         /// TODO(balazs.racz) apply the changes reported.
         if (needsReboot_)
         {
@@ -211,7 +254,11 @@ private:
     unsigned needsReboot_ : 1;
     /// did anybody request a node reinit to happen?
     unsigned needsReInit_ : 1;
+    /// does the config cache need to re-read the file?
+    unsigned needsReload_ : 1;
     int fd_;
+    /// In-RAM image of the config file; nullptr if not enabled.
+    std::unique_ptr<ConfigCache> cache_;
     BarrierNotifiable n_;
 };
 
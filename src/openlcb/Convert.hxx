@@ -49,7 +49,7 @@ namespace openlcb
  * @returns a new buffer (from the main pool) with 6 bytes of used space, a
  * big-endian representation of the node ID.
  */
-extern string node_id_to_buffer(NodeID id);
+extern Payload node_id_to_buffer(NodeID id);
 /** Convenience function to render a 48-bit NMRAnet node ID into an existing
  * buffer.
  *
@@ -65,7 +65,7 @@ extern void node_id_to_data(NodeID id, void *data);
  * big-endian node id.
  * @returns the node id (in host endian).
  */
-extern NodeID buffer_to_node_id(const string &buf);
+extern NodeID buffer_to_node_id(const Payload &buf);
 /** Converts 6 bytes of big-endian data to a node ID.
  *
  * @param d is a pointer to at least 6 valid bytes.
@@ -87,11 +87,11 @@ inline uint64_t data_to_eventid(const void *data)
 
 /** Formats a payload for response of error response messages such as OPtioanl
  * Interaction Rejected or Terminate Due To Error. */
-extern string error_to_buffer(uint16_t error_code, uint16_t mti);
+extern Payload error_to_buffer(uint16_t error_code, uint16_t mti);
 
 /** Formats a payload for response of error response messages such as Datagram
  * Rejected. */
-extern string error_to_buffer(uint16_t error_code);
+extern Payload error_to_buffer(uint16_t error_code);
 
 /** Writes an error code into a payload object at a given pointer. */
 extern void error_to_data(uint16_t error_code, void *data);
@@ -121,7 +121,7 @@ extern void buffer_to_error(const Payload &payload, uint16_t *error_code,
 extern Payload error_payload(uint16_t error_code, Defs::MTI incoming_mti);
 
 /** A global class / variable for empty or not-yet-initialized payloads. */
-extern string EMPTY_PAYLOAD;
+extern Payload EMPTY_PAYLOAD;
 
 /// @return the high 4 bytes of a node ID. @param id is the node ID.
 inline unsigned node_high(NodeID id)
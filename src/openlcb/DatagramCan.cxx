@@ -141,7 +141,11 @@ public:
             CanDefs::CAN_FRAME_TYPE_MASK,
     };
 
-    CanDatagramParser(IfCan *iface);
+    /// Constructor.
+    /// @param iface the interface to listen on.
+    /// @param proxy if true, datagrams are also accepted for local aliases
+    /// that have no local Node object (nodes proxied from another bus).
+    CanDatagramParser(IfCan *iface, bool proxy = false);
     ~CanDatagramParser();
 
     /// Handler callback for incoming frames.
@@ -171,7 +175,9 @@ public:
         {
             dstNode_ = if_can()->lookup_local_node(dst_.id);
         }
-        if (!dstNode_)
+        if (!dstNode_ &&
+            (!proxy_ || !dst_.id ||
+                CanDefs::is_reserved_alias_node_id(dst_.id)))
         {
             // Destination not local node.
             return release_and_exit();
@@ -286,7 +292,7 @@ public:
     Action send_rejection()
     {
         HASSERT(errorCode_);
-        HASSERT(dstNode_);
+        HASSERT(dst_.id);
         auto *f =
             get_allocation_result(if_can()->addressed_message_write_flow());
         f->data()->reset(Defs::MTI_DATAGRAM_REJECTED, dst_.id, {0, srcAlias_},
@@ -329,6 +335,8 @@ private:
 
     Node *dstNode_;
     NodeHandle dst_;
+    /// True if datagrams to proxied nodes are accepted.
+    bool proxy_;
     unsigned short srcAlias_ : 12;
     /// If non-zero, contains a Rejection error code and the datagram should not
     /// be forwarded to the upper layer in this case.
@@ -362,12 +370,21 @@ Executable *TEST_CreateCanDatagramParser(IfCan *if_can)
     return new CanDatagramParser(if_can);
 }
 
+MessageHandler *add_can_datagram_proxy_support(IfCan *if_can)
+{
+    if_can->add_owned_flow(new CanDatagramParser(if_can, true));
+    auto *dg_send = new CanDatagramWriteFlow(if_can);
+    if_can->add_owned_flow(dg_send);
+    return dg_send;
+}
+
 CanDatagramService::~CanDatagramService()
 {
 }
 
-CanDatagramParser::CanDatagramParser(IfCan *iface)
+CanDatagramParser::CanDatagramParser(IfCan *iface, bool proxy)
     : CanFrameStateFlow(iface)
+    , proxy_(proxy)
 {
     if_can()->frame_dispatcher()->register_handler(this,
         CAN_FILTER |
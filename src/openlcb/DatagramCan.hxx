@@ -66,6 +66,15 @@ public:
 /// Creates a CAN datagram parser flow. Exposed for testing only.
 Executable *TEST_CreateCanDatagramParser(IfCan *if_can);
 
+/// Adds datagram framing to an interface that stands in for nodes on another
+/// bus (a router), without a DatagramService. Incoming datagrams to any local
+/// alias are sent to the interface's dispatcher, with dstNode == nullptr if
+/// the destination is a proxied node. The flows are owned by the interface.
+/// @param if_can the interface.
+/// @return the flow that sends datagram messages to the bus. It does not wait
+/// for the datagram response message.
+MessageHandler *add_can_datagram_proxy_support(IfCan *if_can);
+
 } // namespace openlcb
 
 #endif // _OPENLCB_DATAGRAMCAN_HXX_
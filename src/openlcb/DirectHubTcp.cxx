@@ -0,0 +1,691 @@
+/** \copyright
+ * Copyright (c) 2026, OpenMRN contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file DirectHubTcp.cxx
+ *
+ * Message segmenter for carrying native OpenLCB-TCP traffic through a
+ * DirectHub, and bridge between such a hub and a CAN frame typed DirectHub.
+ *
+ * @author OpenMRN contributors
+ * @date 17 Oct 2026
+ */
+
+#include "utils/DirectHub.hxx"
+
+#include "executor/StateFlow.hxx"
+#include "openlcb/AliasAllocator.hxx"
+#include "openlcb/CanDefs.hxx"
+#include "openlcb/DatagramCan.hxx"
+#include "openlcb/DatagramDefs.hxx"
+#include "openlcb/IfCan.hxx"
+#include "openlcb/IfTcpImpl.hxx"
+#include "utils/Hub.hxx"
+
+extern DataBufferPool g_direct_hub_kbyte_pool;
+
+namespace openlcb
+{
+
+extern long long ADDRESSED_MESSAGE_LOOKUP_TIMEOUT_NSEC;
+
+/// Message segmenter that chops an incoming byte stream into binary
+/// OpenLCB-TCP messages, using the length field of the message header.
+class DirectHubTcpSegmenter : public MessageSegmenter
+{
+public:
+    DirectHubTcpSegmenter()
+    {
+        clear();
+    }
+
+    ssize_t segment_message(const void *d, size_t size) override
+    {
+        const uint8_t *data = static_cast<const uint8_t *>(d);
+        if (totalLen_ < 0)
+        {
+            // Collects the header until the length is known.
+            size_t copy = std::min(size, (size_t)HDR_BYTES - hdrLen_);
+            memcpy(hdr_ + hdrLen_, data, copy);
+            hdrLen_ += copy;
+            totalLen_ = TcpDefs::get_tcp_message_len(hdr_, hdrLen_);
+        }
+        seenLen_ += size;
+        if (totalLen_ >= 0 && seenLen_ >= (size_t)totalLen_)
+        {
+            return totalLen_;
+        }
+        return 0;
+    }
+
+    /// Resets internal state machine. The next call to segment_message()
+    /// assumes no previous data present.
+    void clear() override
+    {
+        hdrLen_ = 0;
+        seenLen_ = 0;
+        totalLen_ = -1;
+    }
+
+private:
+    /// How many bytes of the header we need to know the message length.
+    static constexpr unsigned HDR_BYTES = TcpDefs::HDR_SIZE_END;
+    /// Prefix of the current message.
+    uint8_t hdr_[HDR_BYTES];
+    /// Number of bytes in hdr_.
+    unsigned hdrLen_;
+    /// Number of bytes of the current message seen so far.
+    size_t seenLen_;
+    /// Length of the current message, or -1 if not known yet.
+    int totalLen_;
+};
+
+
+/// Bridge between a DirectHub carrying native OpenLCB-TCP messages and a CAN
+/// frame typed DirectHub. Unlike the gridconnect bridge this works on the
+/// message level: the bridge contains an IfCan that represents every node
+/// seen on the TCP side as a proxied local node with its own alias. The IfCan
+/// is attached to a private legacy CAN hub, which exchanges frames with the
+/// CAN DirectHub.
+///
+/// TCP to CAN: messages are parsed and handed to the write flows of the
+/// IfCan, which allocate the source alias, look up the destination alias and
+/// split the message into frames. Messages addressed to another TCP node stay
+/// on the TCP hub.
+///
+/// CAN to TCP: the IfCan reassembles the frames into messages. Global
+/// messages and messages addressed to a TCP node are rendered into the TCP
+/// hub. If the node ID of the source alias is not known yet, it is looked up
+/// with a Verify Node ID message before the message is forwarded.
+///
+/// Everything runs on the executor of the CAN hub.
+class TcpCanBridge : public Destructable
+{
+public:
+    /// Constructor.
+    /// @param tcp_hub the OpenLCB-TCP hub.
+    /// @param can_hub the CAN frame hub.
+    /// @param gateway_node_id node ID of the bridge.
+    TcpCanBridge(ByteDirectHubInterface *tcp_hub,
+        CanDirectHubInterface *can_hub, NodeID gateway_node_id)
+        : tcpHub_(tcp_hub)
+        , canHub_(can_hub)
+        , gatewayId_(gateway_node_id)
+        , legacyHub_(can_hub->get_service())
+        , ifCan_(can_hub->get_service()->executor(), &legacyHub_,
+              LOCAL_ALIAS_CACHE_SIZE, REMOTE_ALIAS_CACHE_SIZE, 1)
+        , tcpPort_(this)
+        , canPort_(this)
+        , frameToCan_(this)
+        , messageToCan_(this)
+        , messageToTcp_(this)
+    {
+        ifCan_.set_alias_allocator(new AliasAllocator(gatewayId_, &ifCan_));
+        datagramWriteFlow_ = add_can_datagram_proxy_support(&ifCan_);
+        legacyHub_.register_port(&frameToCan_);
+        ifCan_.dispatcher()->register_handler(&messageToTcp_, 0, 0);
+        tcpHub_->register_port(&tcpPort_);
+        canHub_->register_port(&canPort_);
+    }
+
+    ~TcpCanBridge()
+    {
+        tcpHub_->unregister_port(&tcpPort_);
+        canHub_->unregister_port(&canPort_);
+        ifCan_.dispatcher()->unregister_handler(&messageToTcp_, 0, 0);
+        legacyHub_.unregister_port(&frameToCan_);
+    }
+
+private:
+    /// How many nodes of the TCP side can have an alias at the same time.
+    static constexpr unsigned LOCAL_ALIAS_CACHE_SIZE = 64;
+    /// How many nodes of the CAN side we remember the alias of.
+    static constexpr unsigned REMOTE_ALIAS_CACHE_SIZE = 256;
+
+    /// @param mti an OpenLCB message type.
+    /// @return true if messages of this type can be carried between TCP and
+    /// CAN by the bridge.
+    static bool is_bridged_mti(Defs::MTI mti)
+    {
+        switch (mti)
+        {
+            case Defs::MTI_DATAGRAM:
+                return true;
+            case Defs::MTI_STREAM_INITIATE_REQUEST:
+            case Defs::MTI_STREAM_INITIATE_REPLY:
+            case Defs::MTI_STREAM_PROCEED:
+            case Defs::MTI_STREAM_COMPLETE:
+                // Stream data frames are not bridged, so there is no point in
+                // opening a stream.
+                return false;
+            default:
+                // These would not fit the 12-bit MTI of a CAN frame.
+                return (mti &
+                           (Defs::MTI_DATAGRAM_MASK | Defs::MTI_SPECIAL_MASK |
+                               Defs::MTI_RESERVED_MASK)) == 0;
+        }
+    }
+
+    /// Port on the TCP hub. Parses the incoming messages.
+    class TcpPort : public DirectHubPort<uint8_t[]>
+    {
+    public:
+        /// @param parent the owning bridge.
+        TcpPort(TcpCanBridge *parent)
+            : parent_(parent)
+        {
+        }
+
+        /// TCP to CAN path. Called by the TCP hub with a message.
+        void send(MessageAccessor<uint8_t[]> *msg) override
+        {
+            if (!parent_->canHub_->has_recipients(&parent_->canPort_))
+            {
+                // Nobody would receive the converted message.
+                return;
+            }
+            string packet;
+            msg->buf_.append_to(&packet);
+            Buffer<GenMessage> *b;
+            mainBufferPool->alloc(&b);
+            if (!TcpDefs::parse_tcp_message(packet, b->data()))
+            {
+                b->unref();
+                return;
+            }
+            if (msg->done_)
+            {
+                b->set_done(msg->done_->new_child());
+            }
+            parent_->messageToCan_.send(b);
+        }
+
+    private:
+        /// Owning bridge.
+        TcpCanBridge *parent_;
+    };
+
+    /// Port on the CAN frame hub. Hands the frames to the IfCan.
+    class CanPort : public DirectHubPort<CanHubData>
+    {
+    public:
+        /// @param parent the owning bridge.
+        CanPort(TcpCanBridge *parent)
+            : parent_(parent)
+        {
+        }
+
+        /// CAN to TCP path. Called by the CAN hub with a frame.
+        void send(MessageAccessor<CanHubData> *msg) override
+        {
+            // The frame buffer is shared between the ports of the CAN hub, so
+            // the legacy hub gets a copy it can mark as coming from us.
+            Buffer<CanHubData> *b = parent_->legacyHub_.alloc();
+            *b->data()->mutable_frame() = msg->payload_->data()->frame();
+            b->data()->skipMember_ = &parent_->frameToCan_;
+            if (msg->done_)
+            {
+                b->set_done(msg->done_->new_child());
+            }
+            parent_->legacyHub_.send(b);
+        }
+
+    private:
+        /// Owning bridge.
+        TcpCanBridge *parent_;
+    };
+
+    /// Port on the legacy CAN hub. Sends the frames generated by the IfCan to
+    /// the CAN frame hub.
+    class FrameToCanFlow : public StateFlow<Buffer<CanHubData>, QList<1>>
+    {
+    public:
+        /// @param parent the owning bridge.
+        FrameToCanFlow(TcpCanBridge *parent)
+            : StateFlow<Buffer<CanHubData>, QList<1>>(
+                  parent->canHub_->get_service())
+            , parent_(parent)
+        {
+        }
+
+        /// Handles the next CAN frame that we need to send.
+        Action entry() override
+        {
+            wait_and_call(STATE(do_send));
+            inlineRun_ = true;
+            inlineComplete_ = false;
+            parent_->canHub_->enqueue_send(this, &parent_->canPort_);
+            inlineRun_ = false;
+            if (inlineComplete_)
+            {
+                return exit();
+            }
+            else
+            {
+                return wait();
+            }
+        }
+
+        /// Handles the callback from the CAN hub when it is ready for us to
+        /// send the message.
+        Action do_send()
+        {
+            auto *m = parent_->canHub_->mutable_message();
+            // The legacy hub gave us our own copy of the frame, which now
+            // goes to the hub to be shared with the output ports.
+            m->payload_.reset(transfer_message());
+            m->source_ = &parent_->canPort_;
+            parent_->canHub_->do_send();
+            if (inlineRun_)
+            {
+                inlineComplete_ = true;
+                return wait();
+            }
+            else
+            {
+                return exit();
+            }
+        }
+
+    private:
+        /// Owning bridge.
+        TcpCanBridge *parent_;
+        /// True while we are calling the target hub send method.
+        bool inlineRun_ : 1;
+        /// True if the send completed inline.
+        bool inlineComplete_ : 1;
+    };
+
+    /// Flow that sends the messages parsed from TCP to the write flows of the
+    /// IfCan.
+    class MessageToCanFlow : public StateFlow<Buffer<GenMessage>, QList<1>>
+    {
+    public:
+        /// @param parent the owning bridge.
+        MessageToCanFlow(TcpCanBridge *parent)
+            : StateFlow<Buffer<GenMessage>, QList<1>>(&parent->ifCan_)
+            , parent_(parent)
+        {
+        }
+
+        /// Handles the next message from the TCP side.
+        Action entry() override
+        {
+            GenMessage *m = message()->data();
+            IfCan *iface = &parent_->ifCan_;
+            if (m->has_flag_dst(GenMessage::DSTFLAG_NOT_FIRST_MESSAGE |
+                    GenMessage::DSTFLAG_NOT_LAST_MESSAGE))
+            {
+                LOG(INFO, "TCP-CAN bridge: dropping fragmented message with "
+                          "MTI %04x.",
+                    m->mti);
+                return release_and_exit();
+            }
+            if (!is_bridged_mti(m->mti))
+            {
+                LOG(VERBOSE, "TCP-CAN bridge: MTI %04x is not bridged.",
+                    m->mti);
+                return release_and_exit();
+            }
+            if (m->mti == Defs::MTI_DATAGRAM)
+            {
+                if (m->payload.size() > DatagramDefs::MAX_SIZE)
+                {
+                    return drop_too_long();
+                }
+            }
+            else if (Defs::get_mti_address(m->mti))
+            {
+                if (m->payload.size() > MAX_ADDRESSED_PAYLOAD)
+                {
+                    return drop_too_long();
+                }
+            }
+            else if (m->payload.size() > 8)
+            {
+                return drop_too_long();
+            }
+            if (Defs::get_mti_address(m->mti))
+            {
+                if (!m->dst.id)
+                {
+                    return release_and_exit();
+                }
+                if (iface->local_aliases()->lookup(m->dst.id))
+                {
+                    // Destination is on the TCP side; the TCP hub has already
+                    // delivered this message.
+                    return release_and_exit();
+                }
+            }
+            if (m->mti == Defs::MTI_DATAGRAM)
+            {
+                parent_->datagramWriteFlow_->send(transfer_message());
+            }
+            else if (Defs::get_mti_address(m->mti))
+            {
+                iface->addressed_message_write_flow()->send(
+                    transfer_message());
+            }
+            else
+            {
+                iface->global_message_write_flow()->send(transfer_message());
+            }
+            return exit();
+        }
+
+    private:
+        /// Longest payload of an addressed message the CAN write flow can
+        /// split into frames.
+        static constexpr unsigned MAX_ADDRESSED_PAYLOAD = 255;
+
+        /// Drops the current message because its payload does not fit the
+        /// CAN framing of its MTI.
+        Action drop_too_long()
+        {
+            LOG(INFO, "TCP-CAN bridge: dropping message with MTI %04x and "
+                      "%u bytes of payload.",
+                message()->data()->mti,
+                (unsigned)message()->data()->payload.size());
+            return release_and_exit();
+        }
+
+        /// Owning bridge.
+        TcpCanBridge *parent_;
+    };
+
+    /// Flow that renders the messages coming from CAN into the TCP hub.
+    /// Registered on the dispatcher of the IfCan for all messages.
+    class MessageToTcpFlow : public StateFlow<Buffer<GenMessage>, QList<1>>
+    {
+    public:
+        /// @param parent the owning bridge.
+        MessageToTcpFlow(TcpCanBridge *parent)
+            : StateFlow<Buffer<GenMessage>, QList<1>>(&parent->ifCan_)
+            , parent_(parent)
+        {
+        }
+
+        /// Handles the next message from the CAN side. The message buffer is
+        /// shared with the other handlers of the dispatcher, so it must not
+        /// be modified.
+        Action entry() override
+        {
+            GenMessage *m = message()->data();
+            IfCan *iface = &parent_->ifCan_;
+            if (!parent_->tcpHub_->has_recipients(&parent_->tcpPort_))
+            {
+                // Nobody would receive the rendered message.
+                return release_and_exit();
+            }
+            if (m->src.id && iface->local_aliases()->lookup(m->src.id))
+            {
+                // Loopback of a message that came from TCP.
+                return release_and_exit();
+            }
+            if (!is_bridged_mti(m->mti))
+            {
+                return release_and_exit();
+            }
+            if (Defs::get_mti_address(m->mti) &&
+                (!m->dst.id || m->dst.id == parent_->gatewayId_ ||
+                    CanDefs::is_reserved_alias_node_id(m->dst.id)))
+            {
+                // Not for a node on the TCP side.
+                return release_and_exit();
+            }
+            srcId_ = m->src.id;
+            if (!srcId_ && m->src.alias)
+            {
+                srcId_ = iface->remote_aliases()->lookup(m->src.alias);
+            }
+            if (!srcId_)
+            {
+                if (!m->src.alias)
+                {
+                    return release_and_exit();
+                }
+                return allocate_and_call(
+                    iface->addressed_message_write_flow(),
+                    STATE(send_verify));
+            }
+            return call_immediately(STATE(render));
+        }
+
+    private:
+        /// Asks the source node of the current message for its node ID.
+        Action send_verify()
+        {
+            IfCan *iface = &parent_->ifCan_;
+            auto *b =
+                get_allocation_result(iface->addressed_message_write_flow());
+            NodeAlias alias = message()->data()->src.alias;
+            b->data()->reset(Defs::MTI_VERIFY_NODE_ID_ADDRESSED,
+                parent_->gatewayId_, NodeHandle(0, alias), EMPTY_PAYLOAD);
+            replyHandler_.set_alias_waiting(alias);
+            iface->addressed_message_write_flow()->send(b);
+            return sleep_and_call(&timer_,
+                ADDRESSED_MESSAGE_LOOKUP_TIMEOUT_NSEC, STATE(verify_done));
+        }
+
+        /// Called when the verified node ID arrived or the lookup timed out.
+        Action verify_done()
+        {
+            replyHandler_.set_alias_waiting(0);
+            GenMessage *m = message()->data();
+            srcId_ = parent_->ifCan_.remote_aliases()->lookup(m->src.alias);
+            if (!srcId_)
+            {
+                LOG(INFO, "TCP-CAN bridge: could not find the node ID of "
+                          "alias %03x. Dropping message with MTI %04x.",
+                    m->src.alias, m->mti);
+                return release_and_exit();
+            }
+            return call_immediately(STATE(render));
+        }
+
+        /// Renders the current message into the output buffer and sends it
+        /// to the TCP hub.
+        Action render()
+        {
+            GenMessage *m = message()->data();
+            if (srcId_ == m->src.id)
+            {
+                TcpDefs::render_tcp_message(*m, parent_->gatewayId_,
+                    sequence_.get_sequence_number(), &rendered_);
+            }
+            else
+            {
+                GenMessage copy(*m);
+                copy.src.id = srcId_;
+                TcpDefs::render_tcp_message(copy, parent_->gatewayId_,
+                    sequence_.get_sequence_number(), &rendered_);
+            }
+            // Allocates output buffer if needed.
+            if (buf_.free() < rendered_.size())
+            {
+                DataBuffer *b;
+                g_direct_hub_kbyte_pool.alloc(&b);
+                buf_.append_empty_buffer(b);
+            }
+            HASSERT(buf_.free() >= rendered_.size());
+            memcpy(buf_.data_write_pointer(), rendered_.data(),
+                rendered_.size());
+            packetSize_ = rendered_.size();
+            buf_.data_write_advance(packetSize_);
+            pktDone_ = message()->new_child();
+            release();
+            // Sends off output message.
+            wait_and_call(STATE(do_send));
+            inlineRun_ = true;
+            inlineComplete_ = false;
+            parent_->tcpHub_->enqueue_send(this, &parent_->tcpPort_);
+            inlineRun_ = false;
+            if (inlineComplete_)
+            {
+                return exit();
+            }
+            else
+            {
+                return wait();
+            }
+        }
+
+        /// Handles the callback from the TCP hub when it is ready for us to
+        /// send the message.
+        Action do_send()
+        {
+            auto *m = parent_->tcpHub_->mutable_message();
+            m->buf_ = buf_.transfer_head(packetSize_);
+            m->source_ = &parent_->tcpPort_;
+            m->done_ = pktDone_;
+            parent_->tcpHub_->do_send();
+            if (inlineRun_)
+            {
+                inlineComplete_ = true;
+                return wait();
+            }
+            else
+            {
+                return exit();
+            }
+        }
+
+        /// Listens to Verified Node ID messages, adds the alias of the sender
+        /// to the remote alias cache, and wakes up the flow if it is waiting
+        /// for this alias. Runs before the message gets to the queue of the
+        /// flow.
+        class ReplyHandler : public MessageHandler
+        {
+        public:
+            /// @param parent the flow that looks up the aliases.
+            ReplyHandler(MessageToTcpFlow *parent)
+                : parent_(parent)
+            {
+                parent_->parent_->ifCan_.dispatcher()->register_handler(
+                    this, Defs::MTI_VERIFIED_NODE_ID_NUMBER, Defs::MTI_EXACT);
+            }
+
+            ~ReplyHandler()
+            {
+                parent_->parent_->ifCan_.dispatcher()->unregister_handler(
+                    this, Defs::MTI_VERIFIED_NODE_ID_NUMBER, Defs::MTI_EXACT);
+            }
+
+            /// Handles a Verified Node ID message.
+            void send(Buffer<GenMessage> *message, unsigned priority) override
+            {
+                AutoReleaseBuffer<GenMessage> ab(message);
+                GenMessage *msg = message->data();
+                if (!msg->src.alias || msg->payload.size() != 6)
+                {
+                    return;
+                }
+                NodeID id = data_to_node_id(msg->payload.data());
+                AliasCache *cache = parent_->parent_->ifCan_.remote_aliases();
+                if (cache->lookup(msg->src.alias) != id)
+                {
+                    cache->add(id, msg->src.alias);
+                }
+                if (msg->src.alias == aliasWaiting_)
+                {
+                    aliasWaiting_ = 0;
+                    parent_->timer_.trigger();
+                }
+            }
+
+            /// @param alias the alias the flow is waiting for, or 0.
+            void set_alias_waiting(NodeAlias alias)
+            {
+                aliasWaiting_ = alias;
+            }
+
+        private:
+            /// Alias the flow is waiting for, or 0.
+            NodeAlias aliasWaiting_ {0};
+            /// Flow that looks up the aliases.
+            MessageToTcpFlow *parent_;
+        };
+
+        /// Owning bridge.
+        TcpCanBridge *parent_;
+        /// Timer for the node ID lookup.
+        StateFlowTimer timer_ {this};
+        /// Handles the responses of the node ID lookup.
+        ReplyHandler replyHandler_ {this};
+        /// Generates the sequence numbers of the TCP messages.
+        ClockBaseSequenceNumberGenerator sequence_;
+        /// Node ID of the source of the current message.
+        NodeID srcId_;
+        /// The current message in TCP format.
+        string rendered_;
+        /// Output buffer of TCP message bytes.
+        LinkedDataBufferPtr buf_;
+        /// Done notifiable from the source message.
+        BarrierNotifiable *pktDone_ = nullptr;
+        /// True while we are calling the target hub send method.
+        bool inlineRun_ : 1;
+        /// True if the send completed inline.
+        bool inlineComplete_ : 1;
+        /// Number of bytes this TCP message is.
+        uint16_t packetSize_;
+    };
+
+    /// OpenLCB-TCP hub.
+    ByteDirectHubInterface *tcpHub_;
+    /// CAN frame hub.
+    CanDirectHubInterface *canHub_;
+    /// Node ID of the bridge.
+    NodeID gatewayId_;
+    /// Legacy hub connecting the IfCan to the CAN frame hub.
+    CanHubFlow legacyHub_;
+    /// Interface that represents the TCP nodes on CAN.
+    IfCan ifCan_;
+    /// Sends datagrams to CAN. Owned by ifCan_.
+    MessageHandler *datagramWriteFlow_;
+    /// Our port on the TCP hub.
+    TcpPort tcpPort_;
+    /// Our port on the CAN frame hub.
+    CanPort canPort_;
+    /// Sends the frames of the IfCan to the CAN frame hub.
+    FrameToCanFlow frameToCan_;
+    /// Sends the TCP messages to the IfCan.
+    MessageToCanFlow messageToCan_;
+    /// Sends the messages of the IfCan to the TCP hub.
+    MessageToTcpFlow messageToTcp_;
+};
+
+} // namespace openlcb
+
+MessageSegmenter *create_tcp_message_segmenter()
+{
+    return new openlcb::DirectHubTcpSegmenter();
+}
+
+Destructable *create_tcp_to_can_bridge(ByteDirectHubInterface *tcp_hub,
+    CanDirectHubInterface *can_hub, uint64_t gateway_node_id)
+{
+    return new openlcb::TcpCanBridge(tcp_hub, can_hub, gateway_node_id);
+}
@@ -160,4 +160,338 @@ TreeEventHandlers::TreeEventHandlers()
 {
 }
 
+FlatEventHandlers::Snapshot::Snapshot()
+{
+    std::fill(bucketStart_, bucketStart_ + NUM_WIDTHS + 1, 0);
+}
+
+void FlatEventHandlers::Snapshot::update_populated()
+{
+    populatedWidths_ = 0;
+    for (unsigned w = 0; w < 64; ++w)
+    {
+        if (is_populated(w))
+        {
+            populatedWidths_ |= (1ULL << w);
+        }
+    }
+}
+
+FlatEventHandlers::FlatEventHandlers()
+    : current_(new Snapshot())
+{
+}
+
+FlatEventHandlers::~FlatEventHandlers()
+{
+    AtomicHolder h(this);
+    HASSERT(current_->refCount_ == 1);
+    release_locked(current_);
+}
+
+void FlatEventHandlers::register_handler(
+    const EventRegistryEntry &entry, unsigned mask)
+{
+    HASSERT(mask < NUM_WIDTHS);
+    AtomicHolder h(this);
+    LOG(VERBOSE, "%p: register %p", this, entry.handler);
+    set_dirty();
+    pending_.emplace_back(entry, mask);
+}
+
+void FlatEventHandlers::unregister_handler(
+    EventHandler *handler, uint32_t user_arg, uint32_t user_arg_mask)
+{
+    AtomicHolder h(this);
+    set_dirty();
+    LOG(VERBOSE, "%p: unregister %p", this, handler);
+    auto matches = [handler, user_arg, user_arg_mask](
+                       const EventRegistryEntry &e) {
+        return e.handler == handler &&
+            ((e.user_arg & user_arg_mask) == (user_arg & user_arg_mask));
+    };
+    pending_.erase(std::remove_if(pending_.begin(), pending_.end(),
+                       [&matches](const PendingEntry &p) {
+                           return matches(p.entry);
+                       }),
+        pending_.end());
+    Snapshot *src = current_;
+    if (std::none_of(src->entries_.begin(), src->entries_.end(), matches))
+    {
+        return;
+    }
+    Snapshot *dst = src;
+    if (src->refCount_ > 1)
+    {
+        // An iteration is reading the current arrays, so they must stay
+        // intact. The remaining entries are copied to a new snapshot.
+        dst = new Snapshot();
+        dst->keys_.reserve(src->keys_.size());
+        dst->entries_.reserve(src->entries_.size());
+    }
+    // Compacts the two parallel arrays bucket by bucket. When dst == src,
+    // this happens in place.
+    uint32_t d = 0;
+    for (unsigned w = 0; w < NUM_WIDTHS; ++w)
+    {
+        uint32_t i = src->bucketStart_[w];
+        uint32_t i_end = src->bucketStart_[w + 1];
+        dst->bucketStart_[w] = d;
+        for (; i < i_end; ++i)
+        {
+            if (matches(src->entries_[i]))
+            {
+                continue;
+            }
+            if (dst != src)
+            {
+                dst->keys_.push_back(src->keys_[i]);
+                dst->entries_.push_back(src->entries_[i]);
+            }
+            else if (d != i)
+            {
+                dst->keys_[d] = src->keys_[i];
+                dst->entries_[d] = src->entries_[i];
+            }
+            ++d;
+        }
+    }
+    dst->bucketStart_[NUM_WIDTHS] = d;
+    if (dst == src)
+    {
+        dst->keys_.resize(d);
+        dst->entries_.erase(dst->entries_.begin() + d, dst->entries_.end());
+    }
+    dst->update_populated();
+    if (dst != src)
+    {
+        current_ = dst;
+        release_locked(src);
+    }
+}
+
+void FlatEventHandlers::reserve(size_t count)
+{
+    AtomicHolder h(this);
+    if (current_->refCount_ == 1)
+    {
+        // Reallocating the arrays is only allowed when no iteration uses
+        // them.
+        size_t total = current_->keys_.size() + pending_.size() + count;
+        current_->keys_.reserve(total);
+        current_->entries_.reserve(total);
+    }
+    pending_.reserve(pending_.size() + count);
+}
+
+void FlatEventHandlers::flush_pending()
+{
+    if (pending_.empty())
+    {
+        return;
+    }
+    std::stable_sort(pending_.begin(), pending_.end(),
+        [](const PendingEntry &a, const PendingEntry &b) {
+            if (a.width != b.width)
+            {
+                return a.width < b.width;
+            }
+            return a.entry.event < b.entry.event;
+        });
+    Snapshot *src = current_;
+    Snapshot *dst = src->refCount_ > 1 ? new Snapshot() : src;
+    size_t total = src->keys_.size() + pending_.size();
+    std::vector<EventId> keys;
+    std::vector<EventRegistryEntry> entries;
+    keys.reserve(std::max(total, src->keys_.capacity()));
+    entries.reserve(std::max(total, src->entries_.capacity()));
+    auto p = pending_.begin();
+    for (unsigned w = 0; w < NUM_WIDTHS; ++w)
+    {
+        uint32_t i = src->bucketStart_[w];
+        uint32_t i_end = src->bucketStart_[w + 1];
+        dst->bucketStart_[w] = keys.size();
+        // Two-way merge of the existing bucket and the new entries of the
+        // same width. Existing entries go first among equal keys.
+        while (i < i_end || (p != pending_.end() && p->width == w))
+        {
+            if (i < i_end &&
+                (p == pending_.end() || p->width != w ||
+                    src->keys_[i] <= p->entry.event))
+            {
+                keys.push_back(src->keys_[i]);
+                entries.push_back(src->entries_[i]);
+                ++i;
+            }
+            else
+            {
+                keys.push_back(p->entry.event);
+                entries.push_back(p->entry);
+                ++p;
+            }
+        }
+    }
+    dst->bucketStart_[NUM_WIDTHS] = keys.size();
+    dst->keys_.swap(keys);
+    dst->entries_.swap(entries);
+    pending_.clear();
+    dst->update_populated();
+    if (dst != src)
+    {
+        current_ = dst;
+        release_locked(src);
+    }
+}
+
+/// Class representing the iteration state on the flat event handler
+/// registry. The iterator holds a reference to a snapshot of the registry
+/// arrays; the lock is only taken to acquire and release the snapshot. If the
+/// registry epoch changed since the iteration was started, the iteration
+/// restarts from the beginning on the current snapshot.
+class FlatEventHandlers::Iterator : public EventIterator
+{
+public:
+    Iterator(FlatEventHandlers *parent)
+        : parent_(parent)
+    {
+        clear_iteration();
+    }
+
+    ~Iterator()
+    {
+        AtomicHolder h(parent_);
+        release_locked(snapshot_);
+    }
+
+    EventRegistryEntry *next_entry() OVERRIDE
+    {
+        if (!currentReport_)
+        {
+            return nullptr;
+        }
+        if (epoch_ != parent_->get_epoch())
+        {
+            // The registry changed under us. This may cause duplicate
+            // delivery, but never skips any handler.
+            AtomicHolder h(parent_);
+            restart_locked();
+        }
+        while (true)
+        {
+            if (it_ < end_)
+            {
+                return &snapshot_->entries_[it_++];
+            }
+            if (!next_width())
+            {
+                // Lets the registry modify the arrays in place again. The
+                // caller may still use the returned entries until it checks
+                // the epoch, so the snapshot is only deleted if the registry
+                // has replaced it, which changed the epoch too.
+                clear_iteration();
+                return nullptr;
+            }
+        }
+    }
+
+    void clear_iteration() OVERRIDE
+    {
+        AtomicHolder h(parent_);
+        release_locked(snapshot_);
+        snapshot_ = nullptr;
+        currentReport_ = nullptr;
+        nextWidth_ = NUM_WIDTHS;
+        it_ = end_ = 0;
+    }
+
+    void init_iteration(EventReport *r) OVERRIDE
+    {
+        AtomicHolder h(parent_);
+        currentReport_ = r;
+        restart_locked();
+    }
+
+private:
+    /// Merges the pending registrations, takes the current snapshot and
+    /// starts the iteration from the first mask width. Must be called with
+    /// the lock held.
+    void restart_locked()
+    {
+        // The old snapshot is released only after the flush, so that the
+        // flush does not overwrite it in place.
+        parent_->flush_pending();
+        release_locked(snapshot_);
+        snapshot_ = parent_->acquire_locked();
+        epoch_ = parent_->get_epoch();
+        nextWidth_ = 0;
+        it_ = end_ = 0;
+    }
+
+    /// Skips to the next populated mask width and sets up it_ and end_ to the
+    /// matching range of entries in there.
+    /// @return false if there are no more mask widths to look at.
+    bool next_width()
+    {
+        if (nextWidth_ < 64)
+        {
+            uint64_t remaining = snapshot_->populatedWidths_ >> nextWidth_;
+            if (remaining)
+            {
+                unsigned w = nextWidth_ + __builtin_ctzll(remaining);
+                nextWidth_ = w + 1;
+                setup_width(w);
+                return true;
+            }
+            nextWidth_ = 64;
+        }
+        if (nextWidth_ == 64)
+        {
+            nextWidth_ = NUM_WIDTHS;
+            if (snapshot_->is_populated(64))
+            {
+                // 64 bits -> all events go to everyone.
+                it_ = snapshot_->bucketStart_[64];
+                end_ = snapshot_->bucketStart_[NUM_WIDTHS];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Sets up it_ and end_ to the range of entries in mask width w that
+    /// overlap with the current report.
+    /// @param w mask width, 0..63.
+    void setup_width(unsigned w)
+    {
+        const EventId *keys = snapshot_->keys_.data();
+        const EventId *b = keys + snapshot_->bucketStart_[w];
+        const EventId *e = keys + snapshot_->bucketStart_[w + 1];
+        uint64_t current_mask = (1ULL << w) - 1;
+        uint64_t lo = currentReport_->event & (~current_mask);
+        uint64_t hi = currentReport_->event + currentReport_->mask;
+        b = std::lower_bound(b, e, lo);
+        e = std::upper_bound(b, e, hi);
+        it_ = b - keys;
+        end_ = e - keys;
+    }
+
+    FlatEventHandlers *parent_;
+    EventReport *currentReport_{nullptr};
+    /// Registry arrays this iteration is reading. Holds a reference.
+    Snapshot *snapshot_{nullptr};
+    /// Registry epoch when the iteration was started.
+    unsigned epoch_{0};
+    /// Next mask width to look at.
+    unsigned nextWidth_;
+    /// Index of the next entry to return.
+    uint32_t it_;
+    /// Index after the last matching entry in the current mask width.
+    uint32_t end_;
+};
+
+EventIterator *FlatEventHandlers::create_iterator()
+{
+    return new Iterator(this);
+}
+
 } // namespace openlcb
@@ -187,6 +187,117 @@ private:
     MaskLookupMap handlers_;
 };
 
+/// EventRegistry implementation that keeps event handlers in a flat, sorted
+/// array. The event IDs and the registry entries are stored in two parallel
+/// vectors (so that binary searches only touch the densely packed keys),
+/// ordered first by the mask width then by event ID. A bitmap of the
+/// populated mask widths allows the iteration to skip all empty widths.
+///
+/// Registrations are collected in a pending list and merged into the sorted
+/// array when the next iteration starts. The arrays are kept in a reference
+/// counted snapshot. An iterator takes the lock only to acquire or release a
+/// snapshot; the steps in between read the snapshot without locking. A
+/// snapshot that is referenced by an iterator is never modified: the next
+/// registry change creates a new copy instead (copy-on-write). When the
+/// registry epoch changes during an iteration, the iteration is restarted on
+/// the new snapshot instead of being cut short.
+///
+/// All iterators have to be destroyed before the registry.
+class FlatEventHandlers : public EventRegistry, private Atomic
+{
+public:
+    FlatEventHandlers();
+    ~FlatEventHandlers();
+
+    EventIterator *create_iterator() OVERRIDE;
+    void register_handler(
+        const EventRegistryEntry &entry, unsigned mask) OVERRIDE;
+    void unregister_handler(EventHandler *handler, uint32_t user_arg = 0,
+        uint32_t user_arg_mask = 0) OVERRIDE;
+    void reserve(size_t count) OVERRIDE;
+
+private:
+    class Iterator;
+    friend class Iterator;
+
+    /// Number of different mask widths (0..64 inclusive).
+    static constexpr unsigned NUM_WIDTHS = 65;
+
+    /// A registration that is not merged into the sorted array yet.
+    struct PendingEntry
+    {
+        PendingEntry(const EventRegistryEntry &e, unsigned w)
+            : entry(e)
+            , width(w)
+        {
+        }
+        EventRegistryEntry entry;
+        unsigned width;
+    };
+
+    /// Sorted arrays of the registry entries. Instances are shared between
+    /// the registry and the running iterations.
+    struct Snapshot
+    {
+        Snapshot();
+
+        /// Recomputes populatedWidths_ from the bucket boundaries.
+        void update_populated();
+
+        /// @return true if there are any entries registered with mask width
+        /// w.
+        /// @param w mask width, 0..64.
+        bool is_populated(unsigned w)
+        {
+            return bucketStart_[w] != bucketStart_[w + 1];
+        }
+
+        /// Event IDs, sorted by (mask width, event ID).
+        std::vector<EventId> keys_;
+        /// Registry entries, parallel to keys_.
+        std::vector<EventRegistryEntry> entries_;
+        /// bucketStart_[w] is the index of the first entry with mask width
+        /// w; bucketStart_[NUM_WIDTHS] == keys_.size().
+        uint32_t bucketStart_[NUM_WIDTHS + 1];
+        /// Bit w is set if there is at least one entry with mask width w,
+        /// for w in 0..63. Width 64 is checked via bucketStart_.
+        uint64_t populatedWidths_{0};
+        /// Number of owners (the registry and the iterators). Guarded by the
+        /// registry lock.
+        unsigned refCount_{1};
+    };
+
+    /// Merges the pending registrations into the sorted array. Must be called
+    /// with the lock held.
+    void flush_pending();
+
+    /// Takes a reference to the current snapshot. Must be called with the
+    /// lock held.
+    /// @return the current snapshot.
+    Snapshot *acquire_locked()
+    {
+        ++current_->refCount_;
+        return current_;
+    }
+
+    /// Drops a reference to a snapshot, deleting it if it was the last
+    /// one. Must be called with the lock held.
+    /// @param s snapshot to release, may be nullptr.
+    static void release_locked(Snapshot *s)
+    {
+        if (s && --s->refCount_ == 0)
+        {
+            delete s;
+        }
+    }
+
+    /// The snapshot that reflects the current registrations (except the
+    /// pending ones).
+    Snapshot *current_;
+    /// Registrations that arrived since the last flush.
+    std::vector<PendingEntry> pending_;
+};
+
 }; /* namespace openlcb */
 
 #endif  // _OPENLCB_EVENTHANDLERCONTAINER_HXX_
@@ -13,6 +13,7 @@
 #include "openlcb/EventHandlerContainer.hxx"
 #include "openlcb/Defs.hxx"
 #include "openlcb/EndianHelper.hxx"
+#include "nmranet_config.h"
 
 namespace openlcb
 {
@@ -46,6 +47,16 @@ void EventService::register_interface(If *iface)
     impl()->ownedFlows_.emplace_back(new InlineEventIteratorFlow(
         iface, this, EventService::Impl::MTI_VALUE_EVENT,
         EventService::Impl::MTI_MASK_EVENT));
+    if (config_event_handler_batch_size() > 0)
+    {
+        impl()->ownedFlows_.emplace_back(new BatchEventIteratorFlow(
+            iface, this, EventService::Impl::MTI_VALUE_GLOBAL,
+            EventService::Impl::MTI_MASK_GLOBAL));
+        impl()->ownedFlows_.emplace_back(new BatchEventIteratorFlow(
+            iface, this, EventService::Impl::MTI_VALUE_ADDRESSED_ALL,
+            EventService::Impl::MTI_MASK_ADDRESSED_ALL));
+        return;
+    }
     impl()->ownedFlows_.emplace_back(new EventIteratorFlow(
         iface, this, EventService::Impl::MTI_VALUE_GLOBAL,
         EventService::Impl::MTI_MASK_GLOBAL));
@@ -59,7 +70,14 @@ EventService::Impl::Impl(EventService *service) : callerFlow_(service)
 #ifdef TARGET_LPC11Cxx
     registry.reset(new VectorEventHandlers());
 #else
-    registry.reset(new TreeEventHandlers());
+    if (config_flat_event_registry() == CONSTANT_TRUE)
+    {
+        registry.reset(new FlatEventHandlers());
+    }
+    else
+    {
+        registry.reset(new TreeEventHandlers());
+    }
 #endif
 }
 
@@ -77,6 +95,7 @@ StateFlowBase::Action EventCallerFlow::entry()
     }
     n_.reset(this);
     (c->registry_entry->handler->*(c->fn))(*c->registry_entry, c->rep, &n_);
+    static_cast<EventService *>(service())->impl()->dispatchStats_.add_turn(1);
     return wait_and_call(STATE(call_done));
 }
 
@@ -316,4 +335,72 @@ InlineEventIteratorFlow::dispatch_event(const EventRegistryEntry *entry)
     }
 }
 
+BatchEventIteratorFlow::BatchEventIteratorFlow(If *iface,
+    EventService *event_service, unsigned mti_value, unsigned mti_mask)
+    : EventIteratorFlow(iface, event_service, mti_value, mti_mask)
+{
+    batch_.reserve(config_event_handler_batch_size());
+}
+
+StateFlowBase::Action
+BatchEventIteratorFlow::dispatch_event(const EventRegistryEntry *entry)
+{
+    unsigned batch_size = config_event_handler_batch_size();
+    batch_.clear();
+    batch_.push_back(entry);
+    while (batch_.size() < batch_size)
+    {
+        entry = iterator_->next_entry();
+        if (!entry)
+        {
+            break;
+        }
+        batch_.push_back(entry);
+    }
+    batchIndex_ = 0;
+    callsThisTurn_ = 0;
+    return call_immediately(STATE(call_batch));
+}
+
+StateFlowBase::Action BatchEventIteratorFlow::call_batch()
+{
+    while (batchIndex_ < batch_.size())
+    {
+        if (eventRegistryEpoch_ != eventService_->impl()->registry->get_epoch())
+        {
+            // Event registry was invalidated since this batch was
+            // collected. The rest of the batch is dropped and the iteration
+            // will restart.
+            end_turn();
+            return call_immediately(STATE(iterate_next));
+        }
+        const EventRegistryEntry *e = batch_[batchIndex_++];
+        n_.reset(this);
+        // It is required to hold on to a child to call abort_if_almost_done.
+        auto *c = n_.new_child();
+        (e->handler->*(fn_))(*e, &eventReport_, &n_);
+        ++callsThisTurn_;
+        if (!n_.abort_if_almost_done())
+        {
+            // The event handler did an asynchronous action. We continue with
+            // the rest of the batch once it is done.
+            c->notify();
+            end_turn();
+            return wait_and_call(STATE(call_batch));
+        }
+    }
+    end_turn();
+    return yield_and_call(STATE(iterate_next));
+}
+
+void BatchEventIteratorFlow::end_turn()
+{
+    if (!callsThisTurn_)
+    {
+        return;
+    }
+    eventService_->impl()->dispatchStats_.add_turn(callsThisTurn_);
+    callsThisTurn_ = 0;
+}
+
 } /* namespace openlcb */
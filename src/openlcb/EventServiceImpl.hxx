@@ -37,6 +37,7 @@
 #ifndef _OPENLCB_EVENTSERVICEIMPL_HXX_
 #define _OPENLCB_EVENTSERVICEIMPL_HXX_
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
@@ -107,6 +108,29 @@ public:
     /// calls need to be sent to this flow.
     EventCallerFlow callerFlow_;
 
+    /// Statistics about how many event handlers get invoked per executor
+    /// turn. Updated by the EventCallerFlow and the BatchEventIteratorFlow
+    /// (but not the inline event iterator).
+    struct DispatchStats
+    {
+        /// Records an executor turn.
+        /// @param calls how many event handlers were called in that turn.
+        void add_turn(unsigned calls)
+        {
+            ++numTurns;
+            numCalls += calls;
+            maxCallsPerTurn = std::max(maxCallsPerTurn, calls);
+        }
+
+        /// How many executor turns were used for calling event handlers.
+        unsigned numTurns{0};
+        /// How many event handler calls were made in those turns.
+        unsigned numCalls{0};
+        /// Largest number of handler calls in a single executor turn.
+        unsigned maxCallsPerTurn{0};
+    };
+    DispatchStats dispatchStats_;
+
     enum
     {
         // These address/mask should match all the messages carrying an event
@@ -190,6 +214,35 @@ private:
     const EventRegistryEntry *currentEntry_{nullptr};
 };
 
+/** Flow to receive incoming messages of event protocol, and dispatch them to
+ * the registered event handler without going through the EventCallerFlow. The
+ * matching registry entries are collected into a batch of up to
+ * event_handler_batch_size entries, which are then called one after the other
+ * in the same executor turn. The flow yields after each batch, and waits only
+ * if an event handler does not complete synchronously. */
+class BatchEventIteratorFlow : public EventIteratorFlow
+{
+public:
+    BatchEventIteratorFlow(If *iface, EventService *event_service,
+        unsigned mti_value, unsigned mti_mask);
+
+private:
+    Action dispatch_event(const EventRegistryEntry *entry) OVERRIDE;
+
+    /// Calls the event handlers in batch_ from batchIndex_ onwards.
+    Action call_batch();
+
+    /// Adds the calls made in the current executor turn to the statistics.
+    void end_turn();
+
+    /// Registry entries to call in the current batch.
+    std::vector<const EventRegistryEntry *> batch_;
+    /// Index of the next entry to call in batch_.
+    unsigned batchIndex_{0};
+    /// How many handlers were called in the current executor turn.
+    unsigned callsThisTurn_{0};
+};
+
 } // namespace openlcb
 
 #endif // _OPENLCB_EVENTSERVICEIMPL_HXX_
@@ -58,13 +58,21 @@ void FilteringCanHubFlow::unregister_port(CanHubFlow::port_type *port)
     CanHubFlow::unregister_port(port);
 }
 
+void FilteringCanHubFlow::unregister_shared_port(
+    CanHubFlow::shared_port_type *port)
+{
+    filter_.remove_port(port_id(port));
+    CanHubFlow::unregister_shared_port(port);
+}
+
 void FilteringCanHubFlow::set_port_promiscuous(
     CanHubFlow::port_type *port, bool is_promiscuous)
 {
     OSMutexLock l(&lock_);
     for (auto &h : handlers_)
     {
-        if (h.handler == port)
+        if (h.handler &&
+            handler_port_id(h) == reinterpret_cast<uintptr_t>(port))
         {
             h.mask = is_promiscuous ? 0 : POINTER_MASK;
             return;
@@ -80,28 +88,47 @@ StateFlowBase::Action FilteringCanHubFlow::iterate()
     }
 
     // Filtering behavior
+    while (true)
     {
-        OSMutexLock l(&lock_);
-        for (; currentIndex_ < handlers_.size(); ++currentIndex_)
+        UntypedHandler *shared_handler = nullptr;
         {
-            auto &h = handlers_[currentIndex_];
-            bool is_promisc = (h.mask == 0);
-            // Filtering check. Will also prevent loopback.
-            if (!filter_.is_matching(
-                    reinterpret_cast<uintptr_t>(h.handler), is_promisc))
+            OSMutexLock l(&lock_);
+            for (; currentIndex_ < handlers_.size(); ++currentIndex_)
             {
-                continue;
-            }
+                auto &h = handlers_[currentIndex_];
+                if (!h.handler)
+                {
+                    continue;
+                }
+                bool is_promisc = (h.mask == 0);
+                // Filtering check. Will also prevent loopback.
+                if (!filter_.is_matching(handler_port_id(h), is_promisc))
+                {
+                    continue;
+                }
+                if (h.shared)
+                {
+                    // Called outside of the lock, without a copy.
+                    shared_handler = h.handler;
+                    ++currentIndex_;
+                    break;
+                }
 
-            // At this point: we have another handler.
-            if (!lastHandlerToCall_)
-            {
-                // This was the first we found.
-                lastHandlerToCall_ = handlers_[currentIndex_].handler;
-                continue;
+                // At this point: we have another handler.
+                if (!lastHandlerToCall_)
+                {
+                    // This was the first we found.
+                    lastHandlerToCall_ = handlers_[currentIndex_].handler;
+                    continue;
+                }
+                break;
             }
+        }
+        if (!shared_handler)
+        {
             break;
         }
+        send_shared(shared_handler);
     }
     if (currentIndex_ >= handlers_.size())
     {
@@ -58,6 +58,7 @@ public:
     Action iterate() override;
 
     void unregister_port(CanHubFlow::port_type *port) override;
+    void unregister_shared_port(CanHubFlow::shared_port_type *port) override;
 
     /** Sets a port to be promiscuous.
      * @param port the port to set.
@@ -66,6 +67,19 @@ public:
     void set_port_promiscuous(CanHubFlow::port_type *port, bool is_promiscuous);
 
 private:
+    /// @return the port pointer of a registered handler, the same value that
+    /// messages from that port carry in skipMember_. @param h registration.
+    static uintptr_t handler_port_id(const HandlerInfo &h)
+    {
+        if (h.shared)
+        {
+            // Only register_shared_port() adds shared handlers to the hub.
+            return port_id(static_cast<shared_port_type *>(
+                static_cast<SharedMessageHandler<buffer_type> *>(h.handler)));
+        }
+        return reinterpret_cast<uintptr_t>(h.handler);
+    }
+
     CanFilter filter_;
     bool isFiltering_;
 };
@@ -556,7 +556,7 @@ private:
     /// CAN frame ID, saved from the incoming frame.
     uint32_t id_;
     /// Payload for the MTI message.
-    string buf_;
+    Payload buf_;
 };
 
 /** This class listens for incoming CAN frames of regular addressed OpenLCB
@@ -699,7 +699,7 @@ public:
 
 private:
     uint32_t id_;
-    string buf_;
+    Payload buf_;
     NodeHandle dstHandle_;
     /// Reassembly buffers for multi-frame messages.
     StlMap<uint32_t, Payload> pendingBuffers_;
@@ -389,12 +389,14 @@ public:
     FdToTcpParser(FdHubPortService *s, HubPortInterface *dst,
         HubPortInterface *skipMember)
         : StateFlowBase(s)
+        , bufEnd_(0)
+        , bufOfs_(0)
+        , expectedLen_(-1)
+        , msgFill_(0)
         , dst_(dst)
         , skipMember_(skipMember)
     {
         HASSERT(s->fd() >= 0);
-        bufEnd_ = 0;
-        bufOfs_ = 0;
         start_flow(STATE(start_msg));
     }
 
@@ -424,6 +426,7 @@ private:
     Action start_msg()
     {
         msg_.clear();
+        msgFill_ = 0;
         expectedLen_ = -1;
         return parse_bytes();
     }
@@ -460,22 +463,22 @@ private:
                 }
                 return call_immediately(STATE(read_more_bytes));
             }
+            // The assembly buffer gets its final size right away, so that
+            // the rest of the message can be read into it directly.
+            msg_.resize(expectedLen_);
         }
         // now: we have an expected length.
         DASSERT(expectedLen_ > 0);
-        if (msg_.empty())
-        {
-            msg_.reserve(expectedLen_);
-        }
         // Copy some bytes to the assembly buffer.
-        int needed = expectedLen_ - msg_.size();
+        int needed = expectedLen_ - msgFill_;
         if (needed > available)
         {
             needed = available;
         }
-        msg_.append((const char *)(buffer_ + bufOfs_), needed);
+        memcpy(&msg_[msgFill_], buffer_ + bufOfs_, needed);
+        msgFill_ += needed;
         bufOfs_ += needed;
-        if (msg_.size() >= (unsigned)expectedLen_)
+        if (msgFill_ >= expectedLen_)
         {
             // we're done.
             return send_entry();
@@ -496,6 +499,15 @@ private:
         {
             bufOfs_ = 0;
             bufEnd_ = 0;
+            if (expectedLen_ - msgFill_ >= (int)READ_BUFFER_SIZE)
+            {
+                // The rest of the message would fill the internal buffer
+                // anyway, so we read it directly into the assembly buffer
+                // instead of copying it there.
+                return read_single(&helper_, device()->fd(), &msg_[msgFill_],
+                    expectedLen_ - msgFill_, STATE(direct_read_done),
+                    READ_PRIO);
+            }
         }
         return read_single(&helper_, device()->fd(), buffer_ + bufEnd_,
             READ_BUFFER_SIZE - bufEnd_, STATE(read_done), READ_PRIO);
@@ -507,15 +519,39 @@ private:
     {
         if (helper_.hasError_)
         {
-            notify_barrier();
-            set_terminated();
-            device()->report_read_error();
-            return exit();
+            return read_error();
         }
         bufEnd_ = READ_BUFFER_SIZE - helper_.remaining_;
         return parse_bytes();
     }
 
+    /// Callback state when the kernel read directly into the assembly buffer
+    /// is completed.
+    /// @return next state
+    Action direct_read_done()
+    {
+        if (helper_.hasError_)
+        {
+            return read_error();
+        }
+        msgFill_ = expectedLen_ - helper_.remaining_;
+        if (msgFill_ >= expectedLen_)
+        {
+            return send_entry();
+        }
+        return call_immediately(STATE(read_more_bytes));
+    }
+
+    /// Terminates the flow after a read error.
+    /// @return next state
+    Action read_error()
+    {
+        notify_barrier();
+        set_terminated();
+        device()->report_read_error();
+        return exit();
+    }
+
     /// Sends an assembled message (1) to the destination flow.
     /// @return next state.
     Action send_entry()
@@ -570,7 +606,10 @@ private:
     /// How many bytes we think the current message will be. -1 if we don't
     /// know yet.
     int expectedLen_;
-    /// Assembly buffer. Holds the captured message so far.
+    /// How many bytes of the current message are in msg_ already.
+    int msgFill_;
+    /// Assembly buffer. Sized to the length of the message as soon as that is
+    /// known; holds the captured message so far.
     string msg_;
     /// Where to send parsed messages to.
     HubPortInterface *dst_;
@@ -39,6 +39,10 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include "openmrn_features.h"
+#if OPENMRN_FEATURE_FILE_MMAP
+#include <sys/mman.h>
+#endif
+#include "nmranet_config.h"
 #include "utils/logging.h"
 #ifdef __FreeRTOS__
 #include "freertos/can_ioctl.h"
@@ -113,6 +117,16 @@ FileMemorySpace::FileMemorySpace(const char *name, address_t len)
     HASSERT(name_);
 }
 
+FileMemorySpace::~FileMemorySpace()
+{
+#if OPENMRN_FEATURE_FILE_MMAP
+    if (map_)
+    {
+        munmap(map_, mapSize_);
+    }
+#endif
+}
+
 void FileMemorySpace::ensure_file_open()
 {
     if (fd_ < 0)
@@ -142,6 +156,150 @@ void FileMemorySpace::ensure_file_open()
     }
 }
 
+bool FileMemorySpace::enable_mmap()
+{
+#if OPENMRN_FEATURE_FILE_MMAP
+    if (map_)
+    {
+        return true;
+    }
+    ensure_file_open();
+    if (fd_ < 0)
+    {
+        return false;
+    }
+    struct stat buf;
+    if (fstat(fd_, &buf) < 0)
+    {
+        return false;
+    }
+    // Pages beyond the end of the file cannot be accessed, so the mapping
+    // only covers the part of the space that exists in the file.
+    uint64_t len = buf.st_size;
+    if (fileSize_ < len)
+    {
+        len = fileSize_;
+    }
+    if (!len)
+    {
+        return false;
+    }
+    int prot = read_only() ? PROT_READ : PROT_READ | PROT_WRITE;
+    void *m = mmap(nullptr, len, prot, MAP_SHARED, fd_, 0);
+    if (m == MAP_FAILED)
+    {
+        LOG(WARNING, "Error mapping fd %d: %s", fd_, strerror(errno));
+        return false;
+    }
+    map_ = static_cast<uint8_t *>(m);
+    mapSize_ = len;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void FileMemorySpace::hint_sequential_read(address_t source, size_t len)
+{
+    ensure_file_open();
+    if (fd_ < 0 || source >= fileSize_)
+    {
+        return;
+    }
+    address_t end = fileSize_;
+    if (len < fileSize_ - source)
+    {
+        end = source + len;
+    }
+#if OPENMRN_FEATURE_FILE_MMAP
+    if (map_)
+    {
+        if (source < mapSize_)
+        {
+            address_t page = sysconf(_SC_PAGESIZE);
+            address_t start = source - (source % page);
+            madvise(map_ + start, std::min(end, mapSize_) - start,
+                MADV_SEQUENTIAL | MADV_WILLNEED);
+        }
+        return;
+    }
+    posix_fadvise(fd_, source, end - source, POSIX_FADV_SEQUENTIAL);
+#endif
+    size_t size = config_file_memory_space_read_ahead();
+    if (!size)
+    {
+        return;
+    }
+    if (!readAhead_ || readAheadSize_ != size)
+    {
+        readAhead_.reset(new uint8_t[size]);
+        readAheadSize_ = size;
+    }
+    readAheadLen_ = 0;
+    readAheadOfs_ = source;
+    readAheadNext_ = source;
+    readAheadEnd_ = end;
+}
+
+ssize_t FileMemorySpace::file_read(address_t source, uint8_t *dst, size_t len)
+{
+#if OPENMRN_FEATURE_PREAD_PWRITE
+    return ::pread(fd_, dst, len, source);
+#else
+    off_t actual_position = lseek(fd_, source, SEEK_SET);
+    if ((address_t)actual_position != source)
+    {
+        return -1;
+    }
+    return ::read(fd_, dst, len);
+#endif
+}
+
+size_t FileMemorySpace::read_ahead(address_t source, uint8_t *dst, size_t len)
+{
+    size_t copied = 0;
+    // A read at any other offset is not part of the sequential read (e.g. a
+    // datagram read arriving while a stream is running).
+    while (len && readAhead_ && source == readAheadNext_)
+    {
+        if (source < readAheadOfs_ || source >= readAheadOfs_ + readAheadLen_)
+        {
+            readAheadLen_ = 0;
+            if (len >= readAheadSize_)
+            {
+                // The buffer would not save anything.
+                break;
+            }
+            size_t fill = readAheadSize_;
+            if (fill > readAheadEnd_ - source)
+            {
+                fill = readAheadEnd_ - source;
+            }
+            ssize_t ret = file_read(source, readAhead_.get(), fill);
+            if (ret <= 0)
+            {
+                // The direct read will report the error.
+                break;
+            }
+            readAheadOfs_ = source;
+            readAheadLen_ = ret;
+        }
+        size_t ofs = source - readAheadOfs_;
+        size_t cnt = std::min(len, (size_t)(readAheadLen_ - ofs));
+        memcpy(dst, readAhead_.get() + ofs, cnt);
+        source += cnt;
+        dst += cnt;
+        len -= cnt;
+        copied += cnt;
+        readAheadNext_ = source;
+        if (readAheadNext_ >= readAheadEnd_)
+        {
+            readAhead_.reset();
+        }
+    }
+    return copied;
+}
+
 size_t FileMemorySpace::write(address_t destination, const uint8_t *data,
                               size_t len, errorcode_t *error, Notifiable *again)
 {
@@ -151,6 +309,20 @@ size_t FileMemorySpace::write(address_t destination, const uint8_t *data,
         *error = Defs::ERROR_PERMANENT;
         return 0;
     }
+    if (readAhead_ && destination < readAheadOfs_ + readAheadLen_ &&
+        readAheadOfs_ < destination + len)
+    {
+        // Drops the stale data; the next sequential read refills the buffer.
+        readAheadLen_ = 0;
+    }
+    if (map_ && destination < mapSize_ && len <= mapSize_ - destination)
+    {
+        memcpy(map_ + destination, data, len);
+        return len;
+    }
+#if OPENMRN_FEATURE_PREAD_PWRITE
+    ssize_t ret = ::pwrite(fd_, data, len, destination);
+#else
     off_t actual_position = lseek(fd_, destination, SEEK_SET);
     if ((address_t)actual_position != destination)
     {
@@ -158,6 +330,7 @@ size_t FileMemorySpace::write(address_t destination, const uint8_t *data,
         return 0;
     }
     ssize_t ret = ::write(fd_, data, len);
+#endif
     if (ret < 0)
     {
         LOG(INFO, "Error writing to fd %d: %s", fd_, strerror(errno));
@@ -187,12 +360,6 @@ size_t FileMemorySpace::read(address_t destination, uint8_t *dst, size_t len,
         *error = Defs::ERROR_PERMANENT;
         return 0;
     }
-    off_t actual_position = lseek(fd_, destination, SEEK_SET);
-    if ((address_t)actual_position != destination)
-    {
-        *error = Defs::ERROR_PERMANENT;
-        return 0;
-    }
     if (destination >= fileSize_)
     {
         *error = MemoryConfigDefs::ERROR_OUT_OF_BOUNDS;
@@ -202,7 +369,29 @@ size_t FileMemorySpace::read(address_t destination, uint8_t *dst, size_t len,
     {
         len = fileSize_ - destination;
     }
-    ssize_t ret = ::read(fd_, dst, len);
+    if (map_ && destination < mapSize_ && len <= mapSize_ - destination)
+    {
+        memcpy(dst, map_ + destination, len);
+        return len;
+    }
+    size_t copied = 0;
+    if (readAhead_)
+    {
+        copied = read_ahead(destination, dst, len);
+        if (copied == len)
+        {
+            return copied;
+        }
+        destination += copied;
+        dst += copied;
+        len -= copied;
+    }
+    ssize_t ret = file_read(destination, dst, len);
+    if (ret <= 0 && copied)
+    {
+        // The error will be reported by the next call.
+        return copied;
+    }
     if (ret < 0)
     {
         LOG(INFO, "Error reading from fd %d: %s", fd_, strerror(errno));
@@ -215,17 +404,25 @@ size_t FileMemorySpace::read(address_t destination, uint8_t *dst, size_t len,
         *error = MemoryConfigDefs::ERROR_OUT_OF_BOUNDS;
         return 0;
     }
-    else if ((size_t)ret < len)
+    if (readAhead_ && destination == readAheadNext_)
+    {
+        readAheadNext_ += ret;
+        if (readAheadNext_ >= readAheadEnd_)
+        {
+            readAhead_.reset();
+        }
+    }
+    if ((size_t)ret < len)
     {
 #ifdef __FreeRTOS__
         *error = ERROR_AGAIN;
         HASSERT(ioctl(fd_, CAN_IOC_READ_ACTIVE, again) == 0);
 #endif
-        return ret;
+        return copied + ret;
     }
     else
     {
-        return ret;
+        return copied + ret;
     }
 }
 
@@ -35,6 +35,9 @@
 #ifndef _OPENLCB_MEMORYCONFIG_HXX_
 #define _OPENLCB_MEMORYCONFIG_HXX_
 
+#include <memory>
+#include <sys/types.h>
+
 #include "openlcb/DatagramDefs.hxx"
 #include "openlcb/DatagramHandlerDefault.hxx"
 #include "openlcb/MemoryConfigDefs.hxx"
@@ -159,6 +162,16 @@ public:
     virtual size_t read(address_t source, uint8_t *dst, size_t len,
                         errorcode_t *error, Notifiable *again) = 0;
 
+    /// Tells the memory space that the caller is about to read the range
+    /// [source, source + len) in consecutive read calls, for example to send
+    /// it out in a stream. Implementations may use this to prefetch
+    /// data. Default is no-op.
+    /// @param source memory space offset where the sequential read starts
+    /// @param len how many bytes will be read (may be larger than the space)
+    virtual void hint_sequential_read(address_t source, size_t len)
+    {
+    }
+
     /** Handles space freeze command. Returns an error code, or 0 for
      * success. */
     virtual errorcode_t freeze() {
@@ -312,11 +325,25 @@ public:
      */
     FileMemorySpace(const char *name, address_t len = AUTO_LEN);
 
+    /// Destructor. Unmaps the file if it was memory-mapped.
+    ~FileMemorySpace();
+
     bool read_only() OVERRIDE
     {
         return false;
     }
 
+    /** Maps the file into memory. Afterwards reads and writes within the
+     * mapped range are served with memcpy instead of system calls. The file
+     * must not be truncated while it is mapped. Only supported on Linux.
+     *
+     * @return true if the file is mapped, false if mapping is not supported
+     * or failed; in this case the file is accessed with positional I/O.
+     */
+    bool enable_mmap();
+
+    void hint_sequential_read(address_t source, size_t len) OVERRIDE;
+
     address_t max_address() OVERRIDE
     {
         ensure_file_open();
@@ -333,9 +360,37 @@ private:
     /** Makes fd a valid parameter, and ensures fileSize is filled in. */
     void ensure_file_open();
 
+    /** Reads from the file at a given offset without changing the file
+     * position (where supported).
+     * @return number of bytes read, or -1 on error (see errno). */
+    ssize_t file_read(address_t source, uint8_t *dst, size_t len);
+
+    /** Serves a read from the read-ahead buffer, refilling the buffer if the
+     * read continues the current sequential read.
+     * @return number of bytes copied to dst, 0 if the read has to go to the
+     * file. */
+    size_t read_ahead(address_t source, uint8_t *dst, size_t len);
+
     address_t fileSize_;
     const char *name_;
     int fd_;
+    /// Start of the file mapping, or nullptr if the file is not mapped.
+    uint8_t *map_ {nullptr};
+    /// Number of bytes mapped at map_.
+    address_t mapSize_ {0};
+    /// Buffer for sequential reads. Allocated by hint_sequential_read() and
+    /// released when the sequential read reaches its end.
+    std::unique_ptr<uint8_t[]> readAhead_;
+    /// Allocated size of readAhead_.
+    uint32_t readAheadSize_ {0};
+    /// Number of valid bytes in readAhead_.
+    uint32_t readAheadLen_ {0};
+    /// File offset of readAhead_[0].
+    address_t readAheadOfs_ {0};
+    /// File offset where the sequential read is expected to continue.
+    address_t readAheadNext_ {0};
+    /// File offset where the sequential read ends.
+    address_t readAheadEnd_ {0};
 };
 
 /// Memory space implementation that exports the contents of a file as a memory
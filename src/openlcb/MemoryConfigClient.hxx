@@ -40,6 +40,7 @@
 #include "openlcb/IfCan.hxx"
 #include "openlcb/MemoryConfig.hxx"
 #include "openlcb/StreamReceiver.hxx"
+#include "openlcb/StreamSender.hxx"
 #include "openlcb/StreamTransport.hxx"
 
 namespace openlcb
@@ -72,6 +73,11 @@ struct MemoryConfigClientRequest : public CallableFlowRequestBase
         WRITE
     };
 
+    enum WriteStreamCmd
+    {
+        WRITE_STREAM
+    };
+
     enum UpdateCompleteCmd
     {
         UPDATE_COMPLETE
@@ -180,6 +186,21 @@ struct MemoryConfigClientRequest : public CallableFlowRequestBase
         payload = std::move(data);
     }
 
+    /// Sets up a command to write a part of a memory space using stream
+    /// transport.
+    /// @param WriteStreamCmd polymorphic matching arg; always set to
+    /// WRITE_STREAM.
+    /// @param d is the destination node to write to
+    /// @param space is the memory space to write to
+    /// @param offset if the address of the first byte to write
+    /// @param data is the data to write
+    void reset(WriteStreamCmd, NodeHandle d, uint8_t space, unsigned offset,
+        string data)
+    {
+        reset(WRITE, d, space, offset, std::move(data));
+        use_stream = true;
+    }
+
     /// Sets up a command to send an Update Complete request to a remote node.
     /// @param UpdateCompleteCmd polymorphic matching arg; always set to
     /// UPDATE_COMPLETE.
@@ -781,6 +802,13 @@ private:
                     }
                     return respond_ok(0);
                 }
+                case MemoryConfigDefs::COMMAND_WRITE_STREAM_REPLY:
+                case MemoryConfigDefs::COMMAND_WRITE_STREAM_FAILED:
+                    if (!parent_->request()->use_stream)
+                    {
+                        break;
+                    }
+                    // fall through
                 case MemoryConfigDefs::COMMAND_WRITE_REPLY:
                 case MemoryConfigDefs::COMMAND_WRITE_FAILED:
                     if (parent_->request()->cmd !=
@@ -831,7 +859,7 @@ protected:
     /// timing helper
     StateFlowTimer timer_ {this};
     /// The data that came back from reading.
-    string responsePayload_;
+    Payload responsePayload_;
     /// error code that came with the response. 0 for success.
     int responseCode_;
     /// 1 if we are pending on the timer.
@@ -868,6 +896,9 @@ protected:
             case MemoryConfigClientRequest::CMD_READ_PART:
                 return allocate_and_call(
                     STATE(do_stream_read), dg_service()->client_allocator());
+            case MemoryConfigClientRequest::CMD_WRITE:
+                return allocate_and_call(STATE(do_stream_write),
+                    stream_transport()->sender_allocator());
             default:
                 return return_with_error(Defs::ERROR_UNIMPLEMENTED_SUBCMD);
         }
@@ -1005,6 +1036,173 @@ protected:
         return return_with_error(request()->resultCode);
     }
 
+    Action do_stream_write()
+    {
+        sender_ =
+            full_allocation_result(stream_transport()->sender_allocator());
+        /// @todo the APIs are not on the right object in StreamSender, so we
+        /// have to do this down cast.
+        senderCan_ = static_cast<StreamSenderCan *>(sender_);
+        srcStreamId_ = stream_transport()->get_send_stream_id();
+        if (srcStreamId_ == StreamDefs::INVALID_STREAM_ID)
+        {
+            return finish_stream_write(Defs::ERROR_TEMPORARY);
+        }
+        return allocate_and_call(STATE(stream_write_have_client),
+            dg_service()->client_allocator());
+    }
+
+    Action stream_write_have_client()
+    {
+        dgClient_ = full_allocation_result(dg_service()->client_allocator());
+        memoryConfigHandler_->set_client(&responseFlow_);
+        return allocate_and_call(dg_service()->iface()->dispatcher(),
+            STATE(send_stream_write_datagram));
+    }
+
+    Action send_stream_write_datagram()
+    {
+        auto *b = get_allocation_result(dg_service()->iface()->dispatcher());
+        b->set_done(bn_.reset(this));
+        b->data()->reset(Defs::MTI_DATAGRAM, node_->node_id(), request()->dst,
+            MemoryConfigDefs::write_stream_datagram(
+                request()->memory_space, request()->address, srcStreamId_));
+
+        isWaitingForTimer_ = 0;
+        responseCode_ = DatagramClient::OPERATION_PENDING;
+        dgClient_->write_datagram(b);
+        return wait_and_call(STATE(stream_write_dg_complete));
+    }
+
+    Action stream_write_dg_complete()
+    {
+        if (!(dgClient_->result() & DatagramClient::OPERATION_SUCCESS))
+        {
+            // some error occurred.
+            return finish_stream_write(dgClient_->result());
+        }
+        if (responseCode_ & DatagramClient::OPERATION_PENDING)
+        {
+            isWaitingForTimer_ = 1;
+            return sleep_and_call(
+                &timer_, SEC_TO_NSEC(3), STATE(stream_write_response));
+        }
+        else
+        {
+            return call_immediately(STATE(stream_write_response));
+        }
+    }
+
+    Action stream_write_response()
+    {
+        if (responseCode_ & DatagramClient::OPERATION_PENDING)
+        {
+            return finish_stream_write(Defs::OPENMRN_TIMEOUT);
+        }
+        const uint8_t *bytes =
+            MemoryConfigDefs::payload_bytes(responsePayload_);
+        if (!MemoryConfigDefs::payload_min_length_check(responsePayload_, 2))
+        {
+            LOG(INFO,
+                "Memory Config client: response datagram payload not "
+                "long enough");
+            return finish_stream_write(
+                Defs::ERROR_INVALID_ARGS_MESSAGE_TOO_SHORT);
+        }
+        unsigned ofs = MemoryConfigDefs::get_payload_offset(responsePayload_);
+        unsigned address = MemoryConfigDefs::get_address(responsePayload_);
+        uint8_t space = MemoryConfigDefs::get_space(responsePayload_);
+        uint8_t cmd = bytes[1] & MemoryConfigDefs::COMMAND_MASK;
+        if (address != request()->address ||
+            space != request()->memory_space)
+        {
+            return finish_stream_write(Defs::ERROR_OUT_OF_ORDER);
+        }
+        if (cmd == MemoryConfigDefs::COMMAND_WRITE_STREAM_FAILED)
+        {
+            uint16_t error = bytes[ofs++];
+            error <<= 8;
+            error |= bytes[ofs];
+            return finish_stream_write(error);
+        }
+        if (cmd != MemoryConfigDefs::COMMAND_WRITE_STREAM_REPLY ||
+            bytes[ofs] != srcStreamId_)
+        {
+            return finish_stream_write(Defs::ERROR_UNIMPLEMENTED);
+        }
+        senderCan_->start_stream(
+            node_, request()->dst, srcStreamId_, bytes[ofs + 1]);
+        return call_immediately(STATE(wait_for_stream_started));
+    }
+
+    Action wait_for_stream_started()
+    {
+        auto state = senderCan_->get_state();
+        if (state == StreamSender::RUNNING)
+        {
+            // The stream sender consumes the payload directly from the
+            // request, which stays alive until we are done.
+            auto *b = sender_->alloc();
+            b->data()->set_from(
+                request()->payload.data(), request()->payload.size());
+            sender_->send(b);
+            senderCan_->close_stream();
+            return call_immediately(STATE(wait_for_stream_write_close));
+        }
+        if (state == StreamSender::STATE_ERROR)
+        {
+            return finish_stream_write(senderCan_->get_error());
+        }
+        return sleep_and_call(
+            &timer_, MSEC_TO_NSEC(1), STATE(wait_for_stream_started));
+    }
+
+    Action wait_for_stream_write_close()
+    {
+        auto state = senderCan_->get_state();
+        if (state == StreamSender::CLOSING && senderCan_->is_waiting())
+        {
+            return finish_stream_write(0);
+        }
+        if (state == StreamSender::STATE_ERROR && senderCan_->is_waiting())
+        {
+            return finish_stream_write(senderCan_->get_error());
+        }
+        return sleep_and_call(
+            &timer_, MSEC_TO_NSEC(1), STATE(wait_for_stream_write_close));
+    }
+
+    /// Releases all resources of a stream write and returns the request to
+    /// the caller.
+    /// @param error 0 for success or an OpenLCB error code.
+    Action finish_stream_write(int error)
+    {
+        if (dgClient_)
+        {
+            cleanup_read();
+        }
+        if (srcStreamId_ != StreamDefs::INVALID_STREAM_ID)
+        {
+            stream_transport()->release_send_stream_id(srcStreamId_);
+            srcStreamId_ = StreamDefs::INVALID_STREAM_ID;
+        }
+        senderCan_->clear();
+        stream_transport()->sender_allocator()->typed_insert(sender_);
+        sender_ = nullptr;
+        senderCan_ = nullptr;
+        if (error)
+        {
+            return return_with_error(error);
+        }
+        return return_ok();
+    }
+
+    /// @return the stream transport of the local interface.
+    StreamTransport *stream_transport()
+    {
+        return node_->iface()->stream_transport();
+    }
+
     /// Stores incoming stream data into the request()->payload object
     /// (which is a string).
     struct DefaultSink : public ByteSink
@@ -1032,6 +1230,12 @@ protected:
     uint8_t dstStreamId_;
     /// Holds a ref to the stream receiver request.
     BufferPtr<StreamReceiveRequest> streamRecvRequest_;
+    /// Stream sender used for the stream writes.
+    StreamSender *sender_ {nullptr};
+    /// Same object as sender_.
+    StreamSenderCan *senderCan_ {nullptr};
+    /// Stream ID on the local device for stream writes.
+    uint8_t srcStreamId_ {StreamDefs::INVALID_STREAM_ID};
 }; // class MemoryConfigClientWithStream
 
 } // namespace openlcb
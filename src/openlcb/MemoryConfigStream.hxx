@@ -37,6 +37,7 @@
 
 #include "openlcb/If.hxx"
 #include "openlcb/MemoryConfig.hxx"
+#include "openlcb/StreamReceiver.hxx"
 #include "openlcb/StreamSender.hxx"
 #include "openlcb/StreamTransport.hxx"
 
@@ -124,6 +125,7 @@ private:
         {
             dstStreamId_ = senderCan_->get_dst_stream_id();
             startedCb_(0);
+            space_->hint_sequential_read(ofs_, len_);
             return call_immediately(STATE(alloc_buffer));
         }
         if (state == StreamSender::STATE_ERROR)
@@ -173,7 +175,7 @@ private:
             cnt = free;
         }
         uint8_t *ptr = sendBuffer_->data()->append_ptr();
-        MemorySpace::errorcode_t err;
+        MemorySpace::errorcode_t err = 0;
         size_t copied = space_->read(ofs_, ptr, cnt, &err, this);
         sendBuffer_->data()->append_complete(copied);
         ofs_ += copied;
@@ -264,6 +266,168 @@ private:
     StreamSender *sender_;
 };
 
+/// This is a self-owned flow which writes an incoming stream into a memory
+/// space. The stream data arrives via a StreamReceiverInterface; flow control
+/// towards the stream source happens by holding on to the received buffers
+/// until their contents are written into the memory space.
+class MemorySpaceStreamWriteFlow : public StateFlow<ByteBuffer, QList<1>>
+{
+public:
+    /// This callback function will be called with an error code, or 0 on
+    /// success.
+    using CallbackFn = std::function<void(uint16_t)>;
+
+    /// Constructor. Does NOT transfer ownership; this class will delete
+    /// itself. Synchronously starts the stream receiver, so by the time the
+    /// constructor returns, the destination stream ID is known and the stream
+    /// initiate request from the source will be accepted.
+    ///
+    /// @param receiver stream receiver to use. Must not be in use by anyone
+    /// else until the done callback is invoked.
+    /// @param node virtual node on which we receive the stream.
+    /// @param space memory space to write into.
+    /// @param src node which will send the stream.
+    /// @param src_stream_id stream ID on the source node.
+    /// @param ofs where to start writing in the memory space.
+    /// @param done_cb will be invoked when the stream is closed and all data
+    /// is written, or upon an error.
+    MemorySpaceStreamWriteFlow(StreamReceiverInterface *receiver, Node *node,
+        MemorySpace *space, NodeHandle src, uint8_t src_stream_id,
+        uint32_t ofs, CallbackFn done_cb)
+        : StateFlow<ByteBuffer, QList<1>>(node->iface())
+        , doneCb_(std::move(done_cb))
+        , space_(space)
+        , receiver_(receiver)
+        , ofs_(ofs)
+    {
+        receiver_->pool()->alloc(&recvRequest_);
+        recvRequest_->data()->reset(this, node, src, src_stream_id);
+        recvRequest_->data()->done.reset(&receiveDone_);
+        receiver_->send(recvRequest_->ref());
+    }
+
+    /// @return the stream ID on the local node.
+    uint8_t get_dst_stream_id()
+    {
+        return recvRequest_->data()->localStreamId_;
+    }
+
+    /// @return true if any stream data has arrived yet.
+    bool has_data()
+    {
+        return numBytes_ > 0;
+    }
+
+    /// Aborts the stream if it has not started yet.
+    void cancel()
+    {
+        receiver_->cancel_request();
+    }
+
+private:
+    Action entry() override
+    {
+        if (!message()->data()->size())
+        {
+            // The stream receiver never sends empty chunks, so this is the
+            // marker from receive_done().
+            return call_immediately(STATE(stream_done));
+        }
+        return call_immediately(STATE(try_write));
+    }
+
+    Action try_write()
+    {
+        ByteChunk *chunk = message()->data();
+        if (errorCode_)
+        {
+            // Drops the remaining data.
+            return release_and_exit();
+        }
+        MemorySpace::errorcode_t err = 0;
+        size_t written =
+            space_->write(ofs_, chunk->data_, chunk->size(), &err, this);
+        chunk->advance(written);
+        ofs_ += written;
+        numBytes_ += written;
+        if (err == MemorySpace::ERROR_AGAIN)
+        {
+            return wait();
+        }
+        if (err)
+        {
+            LOG(INFO, "error writing stream to memory space: %04x", err);
+            errorCode_ = err;
+            return release_and_exit();
+        }
+        if (chunk->size())
+        {
+            return again();
+        }
+        // Releasing the buffer allows the stream receiver to send the next
+        // stream proceed.
+        return release_and_exit();
+    }
+
+    Action stream_done()
+    {
+        release();
+        uint16_t err = errorCode_;
+        if (!err && recvRequest_->data()->resultCode)
+        {
+            err = recvRequest_->data()->resultCode;
+        }
+        LOG(INFO, "stream write done, %u bytes, error 0x%04x",
+            (unsigned)numBytes_, err);
+        recvRequest_.reset();
+        doneCb_(err);
+        return delete_this();
+    }
+
+    /// Called by the stream receiver when the stream is closed. Enqueues an
+    /// empty chunk behind the pending data.
+    void receive_done()
+    {
+        send(alloc());
+    }
+
+    /// Notifiable for the stream receive request completion.
+    class ReceiveDone : public Notifiable
+    {
+    public:
+        /// Constructor.
+        /// @param parent owning flow.
+        ReceiveDone(MemorySpaceStreamWriteFlow *parent)
+            : parent_(parent)
+        {
+        }
+
+        void notify() override
+        {
+            parent_->receive_done();
+        }
+
+    private:
+        /// Owning flow.
+        MemorySpaceStreamWriteFlow *parent_;
+    } receiveDone_ {this};
+
+    /// Request that we sent to the stream receiver.
+    BufferPtr<StreamReceiveRequest> recvRequest_;
+    /// callback to invoke when done.
+    CallbackFn doneCb_;
+    /// Memory space we are writing.
+    MemorySpace *space_;
+    /// Stream receiver we are getting the data from.
+    StreamReceiverInterface *receiver_;
+    /// Next byte to write.
+    uint32_t ofs_;
+    /// How many bytes were written so far.
+    uint32_t numBytes_ {0};
+    /// First error returned by the memory space; 0 if none.
+    uint16_t errorCode_ {0};
+};
+
 /// Handler for the stream read/write commands in the memory config protocol
 /// (server side).
 class MemoryConfigStreamHandler : public MemoryConfigHandlerBase
@@ -291,7 +455,10 @@ public:
             {
                 return call_immediately(STATE(handle_read_stream));
             }
-                /// @todo handle write stream
+            case MemoryConfigDefs::COMMAND_WRITE_STREAM:
+            {
+                return call_immediately(STATE(handle_write_stream));
+            }
         }
         return respond_reject(Defs::ERROR_UNIMPLEMENTED_SUBCMD);
     }
@@ -386,6 +553,75 @@ private:
         return respond_ok(DatagramClient::REPLY_PENDING);
     }
 
+    Action handle_write_stream()
+    {
+        size_t len = message()->data()->payload.size();
+        const uint8_t *bytes = in_bytes();
+
+        MemorySpace *space = get_space();
+        if (!space)
+        {
+            return respond_reject(MemoryConfigDefs::ERROR_SPACE_NOT_KNOWN);
+        }
+        if (space->read_only())
+        {
+            return respond_reject(MemoryConfigDefs::ERROR_WRITE_TO_RO);
+        }
+        size_t stream_data_offset = 6;
+        if (has_custom_space())
+        {
+            ++stream_data_offset;
+        }
+        if (len < stream_data_offset + 1)
+        {
+            return respond_reject(Defs::ERROR_INVALID_ARGS);
+        }
+        if (writeFlow_)
+        {
+            if (!writeFlow_->has_data())
+            {
+                // The previous client never started its stream. Frees up the
+                // receiver for the next attempt.
+                writeFlow_->cancel();
+            }
+            return respond_reject(Defs::ERROR_TEMPORARY);
+        }
+        if (!receiver_)
+        {
+            If *iface = message()->data()->dst->iface();
+            if (!iface->stream_transport())
+            {
+                return respond_reject(Defs::ERROR_UNIMPLEMENTED_SUBCMD);
+            }
+            /// @todo make this not specific to the CAN-bus interface.
+            receiver_.reset(new StreamReceiverCan(static_cast<IfCan *>(iface),
+                iface->stream_transport()->get_next_stream_receive_id()));
+        }
+        uint8_t src_stream_id = bytes[stream_data_offset];
+        // This object is self-owned, so it will run `delete this`.
+        writeFlow_ = new MemorySpaceStreamWriteFlow(receiver_.get(),
+            message()->data()->dst, space, message()->data()->src,
+            src_stream_id, get_address(),
+            std::bind(&MemoryConfigStreamHandler::write_done_cb, this,
+                std::placeholders::_1));
+
+        response_.resize(stream_data_offset + 2);
+        uint8_t *response_bytes = out_bytes();
+        response_bytes[0] = DATAGRAM_ID;
+        response_bytes[1] = MemoryConfigDefs::COMMAND_WRITE_STREAM_REPLY;
+        set_address_and_space();
+        response_bytes[stream_data_offset] = src_stream_id;
+        response_bytes[stream_data_offset + 1] =
+            writeFlow_->get_dst_stream_id();
+        return respond_ok(DatagramClient::REPLY_PENDING);
+    }
+
+    /// Callback from the stream write flow when it is done.
+    void write_done_cb(uint16_t error)
+    {
+        writeFlow_ = nullptr;
+    }
+
     /** Looks up the memory space for the current datagram. Returns NULL if no
      * space was registered (for neither the current node, nor global). */
     MemorySpace *get_space()
@@ -425,6 +661,13 @@ private:
     /// OpenLCB error code from the stream start.
     uint16_t streamErrorCode_;
 
+    /// Stream receiver for the write stream commands. Allocated upon the
+    /// first write stream request.
+    std::unique_ptr<StreamReceiverCan> receiver_;
+    /// The flow writing the incoming stream into a memory space. nullptr if
+    /// no stream write is in progress.
+    MemorySpaceStreamWriteFlow *writeFlow_ {nullptr};
+
     union
     {
         /// The flow that we created for reading the memory space into the
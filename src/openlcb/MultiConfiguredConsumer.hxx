@@ -118,6 +118,13 @@ public:
         return REINIT_NEEDED; // Causes events identify.
     }
 
+    bool config_range(unsigned *offset, unsigned *size) override
+    {
+        *offset = offset_.offset();
+        *size = size_ * config_entry_type::size();
+        return true;
+    }
+
     void factory_reset(int fd) OVERRIDE
     {
         RepeatedGroup<config_entry_type, UINT_MAX> grp_ref(offset_.offset());
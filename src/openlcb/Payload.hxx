@@ -26,8 +26,7 @@
  *
  * \file Payload.hxx
  *
- * Forward declaration of the class storing the payload value in an NMRAnet
- * message object.
+ * Class storing the payload value in an NMRAnet message object.
  *
  * @author Balazs Racz
  * @date 18 May 2014
@@ -36,11 +35,552 @@
 #ifndef _OPENLCB_PAYLOAD_HXX_
 #define _OPENLCB_PAYLOAD_HXX_
 
+#include <stdint.h>
+#include <string.h>
 #include <string>
 
-namespace openlcb {
+#include "openmrn_features.h"
+#include "utils/macros.h"
 
-typedef string Payload;
+namespace openlcb
+{
+
+/// Container that carries the data bytes in an NMRAnet message.
+///
+/// The interface mirrors the subset of std::string that the stack uses, so
+/// handlers can treat the payload as a string. Payloads up to INLINE_SIZE
+/// bytes (all event reports, datagrams, traction messages and most addressed
+/// messages) are stored in the object itself, without a heap
+/// allocation. Longer payloads (e.g. stream data or SNIP replies) spill to a
+/// heap buffer.
+///
+/// The stored data is always followed by a terminating zero, just like in
+/// std::string.
+class Payload
+{
+public:
+    typedef char value_type;
+    typedef size_t size_type;
+    typedef char &reference;
+    typedef const char &const_reference;
+    typedef char *iterator;
+    typedef const char *const_iterator;
+
+    /// Number of bytes that fit without heap allocation. On hosts this is the
+    /// maximum length of a datagram; see OPENMRN_PAYLOAD_INLINE_SIZE.
+    static constexpr size_type INLINE_SIZE = OPENMRN_PAYLOAD_INLINE_SIZE;
+    /// Same meaning as std::string::npos.
+    static constexpr size_type npos = std::string::npos;
+
+    /// Creates an empty payload.
+    Payload()
+        : data_(inline_)
+        , size_(0)
+        , capacity_(INLINE_SIZE)
+    {
+        inline_[0] = 0;
+    }
+
+    /// Creates a payload of n copies of c.
+    Payload(size_type n, char c)
+        : Payload()
+    {
+        assign(n, c);
+    }
+
+    /// Creates a payload from a zero-terminated string.
+    Payload(const char *s)
+        : Payload()
+    {
+        assign(s, strlen(s));
+    }
+
+    /// Creates a payload from a buffer.
+    Payload(const char *s, size_type n)
+        : Payload()
+    {
+        assign(s, n);
+    }
+
+    /// Creates a payload from a string.
+    Payload(const std::string &s)
+        : Payload()
+    {
+        assign(s.data(), s.size());
+    }
+
+    Payload(const Payload &o)
+        : Payload()
+    {
+        assign(o.data_, o.size_);
+    }
+
+    Payload(Payload &&o)
+        : Payload()
+    {
+        take(&o);
+    }
+
+    ~Payload()
+    {
+        if (is_heap())
+        {
+            delete[] data_;
+        }
+    }
+
+    Payload &operator=(const Payload &o)
+    {
+        return assign(o.data_, o.size_);
+    }
+
+    Payload &operator=(Payload &&o)
+    {
+        if (&o != this)
+        {
+            clear();
+            take(&o);
+        }
+        return *this;
+    }
+
+    Payload &operator=(const std::string &s)
+    {
+        return assign(s.data(), s.size());
+    }
+
+    Payload &operator=(const char *s)
+    {
+        return assign(s, strlen(s));
+    }
+
+    /// @return a copy of the contents as a std::string.
+    std::string str() const
+    {
+        return std::string(data_, size_);
+    }
+
+    /// Converts to std::string. This makes a copy, which allocates memory if
+    /// the payload is longer than the std::string inline buffer, therefore it
+    /// has to be requested explicitly.
+    explicit operator std::string() const
+    {
+        return str();
+    }
+
+    size_type size() const
+    {
+        return size_;
+    }
+
+    size_type length() const
+    {
+        return size_;
+    }
+
+    bool empty() const
+    {
+        return size_ == 0;
+    }
+
+    size_type capacity() const
+    {
+        return capacity_;
+    }
+
+    const char *data() const
+    {
+        return data_;
+    }
+
+    char *data()
+    {
+        return data_;
+    }
+
+    const char *c_str() const
+    {
+        return data_;
+    }
+
+    char &operator[](size_type pos)
+    {
+        return data_[pos];
+    }
+
+    const char &operator[](size_type pos) const
+    {
+        return data_[pos];
+    }
+
+    char &back()
+    {
+        return data_[size_ - 1];
+    }
+
+    const char &back() const
+    {
+        return data_[size_ - 1];
+    }
+
+    char &front()
+    {
+        return data_[0];
+    }
+
+    const char &front() const
+    {
+        return data_[0];
+    }
+
+    iterator begin()
+    {
+        return data_;
+    }
+
+    iterator end()
+    {
+        return data_ + size_;
+    }
+
+    const_iterator begin() const
+    {
+        return data_;
+    }
+
+    const_iterator end() const
+    {
+        return data_ + size_;
+    }
+
+    /// Removes all data. Keeps the allocated buffer (if any).
+    void clear()
+    {
+        set_size(0);
+    }
+
+    /// Ensures that at least n bytes can be stored without reallocation.
+    void reserve(size_type n)
+    {
+        if (n > capacity_)
+        {
+            grow(n);
+        }
+    }
+
+    /// Changes the size of the payload. New bytes are set to c.
+    void resize(size_type n, char c = 0)
+    {
+        reserve(n);
+        if (n > size_)
+        {
+            memset(data_ + size_, c, n - size_);
+        }
+        set_size(n);
+    }
+
+    Payload &assign(const char *s, size_type n)
+    {
+        if (n > capacity_)
+        {
+            // s cannot point into our own buffer, because it is too long.
+            grow_discard(n);
+        }
+        memmove(data_, s, n);
+        set_size(n);
+        return *this;
+    }
+
+    Payload &assign(size_type n, char c)
+    {
+        clear();
+        resize(n, c);
+        return *this;
+    }
+
+    Payload &assign(const std::string &s)
+    {
+        return assign(s.data(), s.size());
+    }
+
+    Payload &assign(const Payload &o)
+    {
+        return assign(o.data_, o.size_);
+    }
+
+    Payload &append(const char *s, size_type n)
+    {
+        if (size_ + n > capacity_)
+        {
+            if (s >= data_ && s < data_ + size_)
+            {
+                // Appending a piece of ourselves.
+                size_type ofs = s - data_;
+                grow(size_ + n);
+                s = data_ + ofs;
+            }
+            else
+            {
+                grow(size_ + n);
+            }
+        }
+        memcpy(data_ + size_, s, n);
+        set_size(size_ + n);
+        return *this;
+    }
+
+    Payload &append(const char *s)
+    {
+        return append(s, strlen(s));
+    }
+
+    Payload &append(size_type n, char c)
+    {
+        resize(size_ + n, c);
+        return *this;
+    }
+
+    Payload &append(const std::string &s)
+    {
+        return append(s.data(), s.size());
+    }
+
+    Payload &append(const Payload &o)
+    {
+        return append(o.data_, o.size_);
+    }
+
+    void push_back(char c)
+    {
+        if (size_ == capacity_)
+        {
+            grow(size_ + 1);
+        }
+        data_[size_] = c;
+        set_size(size_ + 1);
+    }
+
+    void pop_back()
+    {
+        set_size(size_ - 1);
+    }
+
+    Payload &operator+=(char c)
+    {
+        push_back(c);
+        return *this;
+    }
+
+    Payload &operator+=(const char *s)
+    {
+        return append(s);
+    }
+
+    Payload &operator+=(const std::string &s)
+    {
+        return append(s);
+    }
+
+    Payload &operator+=(const Payload &o)
+    {
+        return append(o);
+    }
+
+    /// Removes n bytes starting at pos.
+    Payload &erase(size_type pos = 0, size_type n = npos)
+    {
+        HASSERT(pos <= size_);
+        if (n > size_ - pos)
+        {
+            n = size_ - pos;
+        }
+        memmove(data_ + pos, data_ + pos + n, size_ - pos - n);
+        set_size(size_ - n);
+        return *this;
+    }
+
+    /// @return a copy of at most n bytes starting at pos.
+    Payload substr(size_type pos = 0, size_type n = npos) const
+    {
+        HASSERT(pos <= size_);
+        if (n > size_ - pos)
+        {
+            n = size_ - pos;
+        }
+        return Payload(data_ + pos, n);
+    }
+
+    /// @return the offset of the first occurrence of c at or after pos, or
+    /// npos.
+    size_type find(char c, size_type pos = 0) const
+    {
+        if (pos >= size_)
+        {
+            return npos;
+        }
+        const void *p = memchr(data_ + pos, c, size_ - pos);
+        return p ? (const char *)p - data_ : npos;
+    }
+
+    /// Exchanges the contents with another payload.
+    void swap(Payload &o)
+    {
+        if (is_heap() && o.is_heap())
+        {
+            std::swap(data_, o.data_);
+            std::swap(size_, o.size_);
+            std::swap(capacity_, o.capacity_);
+            return;
+        }
+        Payload tmp(std::move(o));
+        o = std::move(*this);
+        *this = std::move(tmp);
+    }
+
+    /// Compares the contents to a buffer.
+    /// @return true if equal.
+    bool equals(const char *s, size_type n) const
+    {
+        return n == size_ && memcmp(data_, s, n) == 0;
+    }
+
+    /// Three-way comparison in the same order as std::string::compare.
+    int compare(const Payload &o) const
+    {
+        size_type n = size_ < o.size_ ? size_ : o.size_;
+        int r = memcmp(data_, o.data_, n);
+        if (r)
+        {
+            return r;
+        }
+        return size_ < o.size_ ? -1 : (size_ > o.size_ ? 1 : 0);
+    }
+
+private:
+    /// @return true if the data is in a heap buffer.
+    bool is_heap() const
+    {
+        return data_ != inline_;
+    }
+
+    /// Updates the size and the terminating zero.
+    void set_size(size_type n)
+    {
+        size_ = n;
+        data_[n] = 0;
+    }
+
+    /// Reallocates the data to a buffer of at least n bytes, keeping the
+    /// contents.
+    void grow(size_type n)
+    {
+        if (n < 2 * capacity_)
+        {
+            n = 2 * capacity_;
+        }
+        char *d = new char[n + 1];
+        memcpy(d, data_, size_ + 1);
+        if (is_heap())
+        {
+            delete[] data_;
+        }
+        data_ = d;
+        capacity_ = n;
+    }
+
+    /// Reallocates the data to a buffer of at least n bytes, dropping the
+    /// contents.
+    void grow_discard(size_type n)
+    {
+        size_ = 0;
+        data_[0] = 0;
+        grow(n);
+    }
+
+    /// Moves the contents of o into this, leaving o empty. This must be
+    /// empty and not o.
+    void take(Payload *o)
+    {
+        if (o->is_heap())
+        {
+            if (is_heap())
+            {
+                delete[] data_;
+            }
+            data_ = o->data_;
+            size_ = o->size_;
+            capacity_ = o->capacity_;
+            o->data_ = o->inline_;
+            o->capacity_ = INLINE_SIZE;
+            o->set_size(0);
+        }
+        else
+        {
+            assign(o->data_, o->size_);
+            o->clear();
+        }
+    }
+
+    /// Points to inline_ or to a heap buffer of capacity_ + 1 bytes.
+    char *data_;
+    /// Number of valid bytes.
+    uint32_t size_;
+    /// Number of bytes that can be stored in data_ (excluding the
+    /// terminating zero).
+    uint32_t capacity_;
+    /// Storage for short payloads.
+    char inline_[INLINE_SIZE + 1];
+};
+
+inline bool operator==(const Payload &a, const Payload &b)
+{
+    return a.equals(b.data(), b.size());
+}
+
+inline bool operator==(const Payload &a, const std::string &b)
+{
+    return a.equals(b.data(), b.size());
+}
+
+inline bool operator==(const std::string &a, const Payload &b)
+{
+    return b.equals(a.data(), a.size());
+}
+
+inline bool operator==(const Payload &a, const char *b)
+{
+    return a.equals(b, strlen(b));
+}
+
+inline bool operator==(const char *a, const Payload &b)
+{
+    return b.equals(a, strlen(a));
+}
+
+template <class T> inline bool operator!=(const Payload &a, const T &b)
+{
+    return !(a == b);
+}
+
+inline bool operator!=(const std::string &a, const Payload &b)
+{
+    return !(b == a);
+}
+
+inline bool operator!=(const char *a, const Payload &b)
+{
+    return !(b == a);
+}
+
+inline bool operator<(const Payload &a, const Payload &b)
+{
+    return a.compare(b) < 0;
+}
+
+inline void swap(Payload &a, Payload &b)
+{
+    a.swap(b);
+}
 
 } // namespace openlcb
 
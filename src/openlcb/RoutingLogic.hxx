@@ -36,12 +36,17 @@
 #ifndef _OPENLCB_ROUTNGLOGIC_HXX_
 #define _OPENLCB_ROUTNGLOGIC_HXX_
 
+#include <algorithm>
+#include <atomic>
 #include <set>
 #include <map>
+#include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include "os/OS.hxx"
 #include "openlcb/EventHandler.hxx"
+#include "utils/macros.h"
 
 namespace openlcb
 {
@@ -190,8 +195,55 @@ public:
         {
             return false;
         }
-        for (auto im = ip->second.registeredConsumers_.begin();
-             im != ip->second.registeredConsumers_.end(); ++im)
+        return matches(ip->second, event);
+    }
+
+    /** Checks if any port has declared interest in a given event.
+     *
+     * @param event is the event ID from the PCER message.
+     *
+     * @return true if the given event has a consumer on at least one port. */
+    bool check_pcer_any_port(EventId event)
+    {
+        OSMutexLock l(&lock_);
+        for (const auto &ip : eventRoutingTable_)
+        {
+            if (matches(ip.second, event))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    /// Protects all internal data structures.
+    OSMutex lock_;
+
+    /// Stores all known addresses and which port they route to.
+    std::unordered_map<Address, Port *> addressRoutingTable_;
+
+    /// The per-port event information.
+    struct EventSet
+    {
+        /// key: number of bits set in the mask part. Valid values:
+        /// 0..64. Value of 0 means individual event.
+        std::map<uint8_t, std::set<EventId>> registeredConsumers_;
+    };
+
+    /// Stores per-port event information.
+    std::map<Port *, EventSet> eventRoutingTable_;
+
+    /** Checks whether an event is contained in an event set.
+     *
+     * @param es is the per-port event information.
+     * @param event is the event ID from the PCER message.
+     *
+     * @return true if any individual event or range in es matches event. */
+    static bool matches(const EventSet &es, EventId event)
+    {
+        for (auto im = es.registeredConsumers_.begin();
+             im != es.registeredConsumers_.end(); ++im)
         {
             if (im->first == 0)
             {
@@ -213,24 +265,559 @@ public:
         }
         return false;
     }
+};
+
+/** Routing table for gateways and routers in OpenLCB, with the same API as
+ * RoutingLogic, but optimized for fast event lookups.
+ *
+ * The event tables are stored per port in flat sorted arrays, grouped by the
+ * range width, with a bitmap of the populated widths. Individual events are
+ * additionally indexed in a Bloom filter, which rejects most events that are
+ * not registered on a port without searching the array. The collection of the
+ * per-port tables is an immutable snapshot that is replaced as a whole
+ * (copy-on-write, sharing the tables of the unchanged ports).
+ *
+ * Lookups (check_pcer, check_pcer_any_port) do not take the table lock; they
+ * only announce themselves in one of two reader counters while they use the
+ * current snapshot. Replaced snapshots are freed by the writers with a
+ * two-epoch scheme: a writer flips the epoch once the readers of the older
+ * epoch are gone, and frees everything that was retired before that. Lookups
+ * are short, thus at most a few replaced snapshots wait for being freed even
+ * under constant lookup traffic.
+ *
+ * New registrations are collected in a pending list and merged into a new
+ * snapshot in one step by the next lookup (or port removal). A flood of
+ * identified messages, such as when a large layout starts up, thus does not
+ * copy the tables for every single registration. Registrations that are
+ * already in the table do not copy anything.
+ *
+ * Address routing is the same as in RoutingLogic.
+ */
+template <class Port, typename Address> class FlatRoutingLogic
+{
+public:
+    FlatRoutingLogic()
+        : snapshot_(new Snapshot())
+        , epoch_(0)
+        , hasPending_(false)
+    {
+        readers_[0] = 0;
+        readers_[1] = 0;
+    }
+
+    ~FlatRoutingLogic()
+    {
+        delete snapshot_.load();
+        for (auto &l : retired_)
+        {
+            for (const Snapshot *s : l)
+            {
+                delete s;
+            }
+        }
+    }
+
+    /** Clears all entries in the routing table related to a given port, as the
+     * given port is being removed.
+     *
+     * @param port describes the target port to be removed.
+     */
+    void remove_port(Port *port)
+    {
+        OSMutexLock l(&lock_);
+        publish_locked();
+        const Snapshot *old_snap = snapshot_.load();
+        auto it = old_snap->find(port);
+        if (it != old_snap->ports_.end())
+        {
+            Snapshot *snap = new Snapshot(*old_snap);
+            snap->ports_.erase(
+                snap->ports_.begin() + (it - old_snap->ports_.begin()));
+            store_snapshot(snap);
+        }
+        for (auto &it : addressRoutingTable_)
+        {
+            if (it.second == port)
+            {
+                it.second = nullptr;
+            }
+        }
+    }
+
+    /** Declares that a given node ID is reachable via a specific port. Used
+     * with the source node IDs of all the incoming packets.
+     *
+     * @param port is where the incoming packet came from (i.e. the port on
+     * which source is reachable.
+     * @param source is the node handle where the packet came from.
+     */
+    void add_node_id_to_route(Port *port, Address source)
+    {
+        OSMutexLock l(&lock_);
+        addressRoutingTable_[source] = port;
+    }
+
+    /** Looks up which port an addressed packet should be sent to.
+     *
+     * @param dest is the address of the destination node that needs to be
+     * contacted.
+     * @returns a (live) port if the address is in the routing table, otherwise
+     * nullptr.
+     */
+    Port *lookup_port_for_address(Address dest)
+    {
+        OSMutexLock l(&lock_);
+        auto it = addressRoutingTable_.find(dest);
+        if (it == addressRoutingTable_.end())
+            return nullptr;
+        return it->second;
+    }
+
+    /** Declares that there is a consumer for the given event ID on the given
+     * port.
+     *
+     * @param port is where the consumer identified from has come from.
+     * @param event is the event ID for which there is a consumer identified on
+     * that port. */
+    void register_consumer(Port *port, EventId event)
+    {
+        add_entry(port, event, 0);
+    }
+
+    /** Declares that there is a consumer for the given event ID range on the
+     * given port.
+     *
+     * @param port is there the consumer range identified has come from.
+     * @param encoded_range is the range of consumer encoded via the OpenLCB
+     * method. */
+    void register_consumer_range(Port *port, EventId encoded_range)
+    {
+        uint8_t bit_count = event_range_to_bit_count(&encoded_range);
+        add_entry(port, encoded_range, bit_count);
+    }
+
+    /** Declares that there is a producer for the given event ID on the given
+     * port.
+     *
+     * @param port is where the producer identified from has come from.
+     * @param event is the event ID for which there is a producer identified on
+     * that port. */
+    void register_producer(Port *port, EventId event)
+    {
+        // Same as RoutingLogic: producers and consumers share the table.
+        register_consumer(port, event);
+    }
+
+    /** Declares that there is a producer for the given event ID range on the
+     * given port.
+     *
+     * @param port is there the producer range identified has come from.
+     * @param encoded_range is the range of producer encoded via the OpenLCB
+     * method. */
+    void register_producer_range(Port *port, EventId encoded_range)
+    {
+        register_consumer_range(port, encoded_range);
+    }
+
+    /** Checks if a given PCER message should be forwarded to the given port.
+     *
+     * @param port is the port to query.
+     * @param event is the event ID from the PCER message.
+     *
+     * @return true if the given event has a consumer on the given port. */
+    bool check_pcer(Port *port, EventId event)
+    {
+        ReadLock l(this);
+        auto it = l.snap->find(port);
+        if (it == l.snap->ports_.end())
+        {
+            return false;
+        }
+        return (*it)->matches(event);
+    }
+
+    /** Checks if any port has declared interest in a given event.
+     *
+     * @param event is the event ID from the PCER message.
+     *
+     * @return true if the given event has a consumer on at least one port. */
+    bool check_pcer_any_port(EventId event)
+    {
+        ReadLock l(this);
+        for (const auto &p : l.snap->ports_)
+        {
+            if (p->matches(event))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// @return how many replaced snapshots are waiting to be freed. Used for
+    /// testing.
+    size_t num_retired()
+    {
+        OSMutexLock l(&lock_);
+        return retired_[0].size() + retired_[1].size();
+    }
 
 private:
-    /// Protects all internal data structures.
+    /// Number of different range widths (0..64 inclusive).
+    static constexpr unsigned NUM_WIDTHS = 65;
+
+    /// A registration that is not in the snapshot yet.
+    struct PendingEntry
+    {
+        /// Port the registration came from.
+        Port *port_;
+        /// Range width.
+        unsigned width_;
+        /// Event ID (range base).
+        EventId key_;
+
+        /// Sort order for merging: by port, then width, then key.
+        bool operator<(const PendingEntry &o) const
+        {
+            if (port_ != o.port_)
+            {
+                return port_ < o.port_;
+            }
+            if (width_ != o.width_)
+            {
+                return width_ < o.width_;
+            }
+            return key_ < o.key_;
+        }
+    };
+
+    /// Event table for a single port.
+    struct PortEvents
+    {
+        PortEvents(Port *p)
+            : port_(p)
+        {
+            std::fill(bucketStart_, bucketStart_ + NUM_WIDTHS + 1, 0);
+        }
+
+        /// @return true if the event matches any entry in this table.
+        /// @param event the event ID from the PCER message.
+        bool matches(EventId event) const
+        {
+            if (bucketStart_[64] != bucketStart_[65])
+            {
+                // Someone is interested in all events.
+                return true;
+            }
+            uint64_t widths = widths_;
+            while (widths)
+            {
+                unsigned w = __builtin_ctzll(widths);
+                widths &= widths - 1;
+                if (w == 0 && !bloom_check(event))
+                {
+                    continue;
+                }
+                EventId key = w ? event & ~((UINT64_C(1) << w) - 1) : event;
+                if (std::binary_search(keys_.begin() + bucketStart_[w],
+                        keys_.begin() + bucketStart_[w + 1], key))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /// @return true if the given entry is present.
+        /// @param key event ID (range base) @param w range width.
+        bool contains(EventId key, unsigned w) const
+        {
+            return std::binary_search(keys_.begin() + bucketStart_[w],
+                keys_.begin() + bucketStart_[w + 1], key);
+        }
+
+        /// Merges new entries into the table.
+        /// @param b first new entry @param e end of the new entries; all of
+        /// them belong to this port, sorted by (width, key).
+        void merge(typename std::vector<PendingEntry>::const_iterator b,
+            typename std::vector<PendingEntry>::const_iterator e)
+        {
+            std::vector<EventId> keys;
+            keys.reserve(keys_.size() + (e - b));
+            widths_ = 0;
+            for (unsigned w = 0; w < NUM_WIDTHS; ++w)
+            {
+                unsigned src = bucketStart_[w];
+                unsigned src_end = bucketStart_[w + 1];
+                bucketStart_[w] = keys.size();
+                // Two-way merge of the existing bucket and the new entries of
+                // the same width, dropping duplicates.
+                while (src < src_end || (b != e && b->width_ == w))
+                {
+                    EventId next;
+                    if (src < src_end &&
+                        (b == e || b->width_ != w || keys_[src] <= b->key_))
+                    {
+                        next = keys_[src++];
+                    }
+                    else
+                    {
+                        next = (b++)->key_;
+                    }
+                    if (keys.size() == bucketStart_[w] || keys.back() != next)
+                    {
+                        keys.push_back(next);
+                    }
+                }
+                if (w < 64 && keys.size() != bucketStart_[w])
+                {
+                    widths_ |= UINT64_C(1) << w;
+                }
+            }
+            bucketStart_[NUM_WIDTHS] = keys.size();
+            keys_.swap(keys);
+            bloom_rebuild();
+        }
+
+        /// Computes the two bit positions of an event in the Bloom filter.
+        /// @param event event ID @param b1 first bit @param b2 second bit
+        void bloom_bits(EventId event, unsigned *b1, unsigned *b2) const
+        {
+            uint64_t h = event * UINT64_C(0x9E3779B97F4A7C15);
+            unsigned mask = bloom_.size() * 64 - 1;
+            *b1 = (h >> 40) & mask;
+            *b2 = (h >> 16) & mask;
+        }
+
+        /// @return false if event is definitely not among the individual
+        /// events. @param event event ID.
+        bool bloom_check(EventId event) const
+        {
+            if (bloom_.empty())
+            {
+                return true;
+            }
+            unsigned b1, b2;
+            bloom_bits(event, &b1, &b2);
+            return ((bloom_[b1 >> 6] >> (b1 & 63)) & 1) &&
+                ((bloom_[b2 >> 6] >> (b2 & 63)) & 1);
+        }
+
+        /// Recomputes the Bloom filter from the individual events, sized to
+        /// at least 32 bits per event (rounded to a power of two words).
+        void bloom_rebuild()
+        {
+            size_t count = bucketStart_[1] - bucketStart_[0];
+            size_t words = 1;
+            while (words * 4 < count * 2)
+            {
+                words <<= 1;
+            }
+            bloom_.assign(words, 0);
+            for (unsigned i = bucketStart_[0]; i < bucketStart_[1]; ++i)
+            {
+                unsigned b1, b2;
+                bloom_bits(keys_[i], &b1, &b2);
+                bloom_[b1 >> 6] |= UINT64_C(1) << (b1 & 63);
+                bloom_[b2 >> 6] |= UINT64_C(1) << (b2 & 63);
+            }
+        }
+
+        /// Which port this table belongs to.
+        Port *port_;
+        /// Bit w is set if there are entries with range width w (0..63).
+        uint64_t widths_ {0};
+        /// bucketStart_[w] is the index in keys_ of the first entry with range
+        /// width w.
+        uint32_t bucketStart_[NUM_WIDTHS + 1];
+        /// Event IDs (range base values), sorted by (width, event ID).
+        std::vector<EventId> keys_;
+        /// Bloom filter of the individual events (width 0). The size is a
+        /// power of two words.
+        std::vector<uint64_t> bloom_;
+    };
+
+    /// Reference to an immutable per-port table. Snapshots share the tables
+    /// of the ports that did not change.
+    typedef std::shared_ptr<const PortEvents> PortEventsPtr;
+    /// Container of the per-port tables.
+    typedef std::vector<PortEventsPtr> PortList;
+
+    /// Comparator for looking up a port in a PortList.
+    static bool port_less(const PortEventsPtr &e, Port *p)
+    {
+        return e->port_ < p;
+    }
+
+    /// Immutable collection of all event tables.
+    struct Snapshot
+    {
+        /// @return iterator to the table for port, or ports_.end().
+        /// @param port which port to look up.
+        typename PortList::const_iterator find(Port *port) const
+        {
+            auto it =
+                std::lower_bound(ports_.begin(), ports_.end(), port, port_less);
+            if (it != ports_.end() && (*it)->port_ == port)
+            {
+                return it;
+            }
+            return ports_.end();
+        }
+
+        /// Per-port tables, sorted by port.
+        PortList ports_;
+    };
+
+    /// Pins the current snapshot for reading while in scope. Publishes the
+    /// pending registrations first, if there are any.
+    struct ReadLock
+    {
+        ReadLock(FlatRoutingLogic *parent)
+            : parent_(parent)
+        {
+            if (parent_->hasPending_.load())
+            {
+                OSMutexLock l(&parent_->lock_);
+                parent_->publish_locked();
+            }
+            while (true)
+            {
+                epoch_ = parent_->epoch_.load();
+                parent_->readers_[epoch_].fetch_add(1);
+                if (parent_->epoch_.load() == epoch_)
+                {
+                    break;
+                }
+                // A writer flipped the epoch in the meantime; the writer might
+                // not have seen our announcement.
+                parent_->readers_[epoch_].fetch_sub(1);
+            }
+            snap = parent_->snapshot_.load();
+        }
+        ~ReadLock()
+        {
+            parent_->readers_[epoch_].fetch_sub(1);
+        }
+        /// Owning table.
+        FlatRoutingLogic *parent_;
+        /// Which reader counter we are counted in.
+        unsigned epoch_;
+        /// Snapshot that is safe to use.
+        const Snapshot *snap;
+    };
+
+    /// Replaces the current snapshot. Must be called with the lock held.
+    /// @param snap the new snapshot; ownership is transferred.
+    void store_snapshot(const Snapshot *snap)
+    {
+        unsigned cur = epoch_.load();
+        retired_[cur].push_back(snapshot_.exchange(snap));
+        // Any reader arriving after this point sees the new snapshot. Each
+        // flip of the epoch needs the readers of the other epoch to be gone.
+        // The snapshots retired before the previous flip are then not
+        // referenced by anyone.
+        for (unsigned i = 0; i < 2; ++i)
+        {
+            unsigned prev = cur ^ 1;
+            if (readers_[prev].load() != 0)
+            {
+                break;
+            }
+            for (const Snapshot *s : retired_[prev])
+            {
+                delete s;
+            }
+            retired_[prev].clear();
+            epoch_.store(prev);
+            cur = prev;
+        }
+    }
+
+    /// Adds an entry to the pending registrations of a port.
+    /// @param port the port @param key event ID (range base) @param w range
+    /// width.
+    void add_entry(Port *port, EventId key, unsigned w)
+    {
+        OSMutexLock l(&lock_);
+        const Snapshot *snap = snapshot_.load();
+        auto it = snap->find(port);
+        if (it != snap->ports_.end() && (*it)->contains(key, w))
+        {
+            return;
+        }
+        pending_.push_back({port, w, key});
+        hasPending_.store(true);
+    }
+
+    /// Merges all pending registrations into a new snapshot. Must be called
+    /// with the lock held.
+    void publish_locked()
+    {
+        if (pending_.empty())
+        {
+            return;
+        }
+        std::sort(pending_.begin(), pending_.end());
+        const Snapshot *old_snap = snapshot_.load();
+        Snapshot *snap = new Snapshot();
+        snap->ports_.reserve(old_snap->ports_.size() + 1);
+        auto old_it = old_snap->ports_.begin();
+        auto p = pending_.cbegin();
+        while (p != pending_.cend())
+        {
+            Port *port = p->port_;
+            auto p_end = p;
+            while (p_end != pending_.cend() && p_end->port_ == port)
+            {
+                ++p_end;
+            }
+            // Unchanged ports before this one are shared.
+            while (old_it != old_snap->ports_.end() && (*old_it)->port_ < port)
+            {
+                snap->ports_.push_back(*old_it++);
+            }
+            std::shared_ptr<PortEvents> pe;
+            if (old_it != old_snap->ports_.end() && (*old_it)->port_ == port)
+            {
+                pe = std::make_shared<PortEvents>(**old_it++);
+            }
+            else
+            {
+                pe = std::make_shared<PortEvents>(port);
+            }
+            pe->merge(p, p_end);
+            snap->ports_.push_back(std::move(pe));
+            p = p_end;
+        }
+        snap->ports_.insert(
+            snap->ports_.end(), old_it, old_snap->ports_.end());
+        pending_.clear();
+        hasPending_.store(false);
+        store_snapshot(snap);
+    }
+
+    /// Serializes the writers.
     OSMutex lock_;
 
     /// Stores all known addresses and which port they route to.
     std::unordered_map<Address, Port *> addressRoutingTable_;
 
-    /// The per-port event information.
-    struct EventSet
-    {
-        /// key: number of bits set in the mask part. Valid values:
-        /// 0..64. Value of 0 means individual event.
-        std::map<uint8_t, std::set<EventId>> registeredConsumers_;
-    };
+    /// Current event tables. Owned.
+    std::atomic<const Snapshot *> snapshot_;
+    /// Number of lookups in progress, by the epoch they started in.
+    std::atomic<unsigned> readers_[2];
+    /// Which reader counter new lookups use (0 or 1).
+    std::atomic<unsigned> epoch_;
+    /// Replaced snapshots that may still be in use by a reader, by the epoch
+    /// they were replaced in. Protected by lock_.
+    std::vector<const Snapshot *> retired_[2];
+    /// Registrations that are not in the snapshot yet. Protected by lock_.
+    std::vector<PendingEntry> pending_;
+    /// True if pending_ is not empty.
+    std::atomic<bool> hasPending_;
 
-    /// Stores per-port event information.
-    std::map<Port *, EventSet> eventRoutingTable_;
+    DISALLOW_COPY_AND_ASSIGN(FlatRoutingLogic);
 };
 
 } // namespace openlcb
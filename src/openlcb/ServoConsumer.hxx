@@ -82,6 +82,13 @@ public:
         return UPDATED;
     }
 
+    bool config_range(unsigned *offset, unsigned *size) override
+    {
+        *offset = cfg_.offset();
+        *size = cfg_.size();
+        return true;
+    }
+
     void factory_reset(int fd) OVERRIDE
     {
         cfg_.description().write(fd, "");
@@ -73,7 +73,8 @@ static size_t find_string_at(const openlcb::Payload& payload, size_t start_pos,
         return start_pos;
     }
     size_t epos = payload.find('\0', start_pos);
-    output->assign(payload.substr(start_pos, epos - start_pos));
+    output->assign(payload.data() + start_pos,
+        (epos == string::npos ? payload.size() : epos) - start_pos);
     if (epos == string::npos) {
         return epos;
     } else {
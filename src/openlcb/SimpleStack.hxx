@@ -250,7 +250,7 @@ public:
     /// @param dst is the node to send message to.
     /// @param payload is the contents of the message
     void send_message_to(
-        Defs::MTI mti, NodeHandle dst, const string &payload = EMPTY_PAYLOAD)
+        Defs::MTI mti, NodeHandle dst, const Payload &payload = EMPTY_PAYLOAD)
     {
         auto *b = node()->iface()->addressed_message_write_flow()->alloc();
         b->data()->reset(mti, node()->node_id(), dst, payload);
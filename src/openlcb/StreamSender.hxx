@@ -289,7 +289,7 @@ private:
     void stream_initiate_replied(Buffer<GenMessage> *message)
     {
         LOG(VERBOSE, "stream init reply: %s",
-            string_to_hex(message->data()->payload).c_str());
+            string_to_hex(message->data()->payload.str()).c_str());
         auto rb = get_buffer_deleter(message);
         if (message->data()->dstNode != node_ ||
             !node_->iface()->matching_node(dst_, message->data()->src))
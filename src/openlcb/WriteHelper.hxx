@@ -52,6 +52,8 @@ class WriteHelper : public Executable
 {
 public:
     typedef Node *node_type;
+    /// The last payload is kept in a string, which is smaller than a Payload
+    /// for the short (event report) messages that are typical here.
     typedef string payload_type;
 
     static NodeHandle global()
@@ -89,7 +91,7 @@ public:
      * physical layer. If done == nullptr, the sending is invoked synchronously.
      */
     void WriteAsync(Node *node, Defs::MTI mti, NodeHandle dst,
-                    const payload_type &buffer, Notifiable *done)
+                    const Payload &buffer, Notifiable *done)
     {
         if (done)
         {
@@ -109,7 +111,7 @@ public:
         node_ = node;
         mti_ = mti;
         dst_ = dst;
-        buffer_ = buffer;
+        buffer_.assign(buffer.data(), buffer.size());
         if (dst == global())
         {
             node->iface()->global_message_write_flow()->alloc_async(this);
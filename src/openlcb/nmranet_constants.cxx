@@ -39,6 +39,14 @@ DEFAULT_CONST(remote_alias_cache_size, 10);
 /** Number of entries in the local alias cache */
 DEFAULT_CONST(local_alias_cache_size, 3);
 
+#ifdef __FreeRTOS__
+/** Minimum size of an alias cache to use hash tables for the lookups. */
+DEFAULT_CONST(alias_cache_hash_min_entries, 0);
+#else
+/** Minimum size of an alias cache to use hash tables for the lookups. */
+DEFAULT_CONST(alias_cache_hash_min_entries, 64);
+#endif
+
 /** Keep this many allocated but unused aliases around. */
 DEFAULT_CONST(reserve_unused_alias_count, 0);
 
@@ -71,6 +79,19 @@ DEFAULT_CONST_FALSE(enable_all_memory_space);
  * standard. */
 DEFAULT_CONST_TRUE(node_init_identify);
 
+/** Set to CONSTANT_TRUE to keep the configuration file in RAM. */
+DEFAULT_CONST_FALSE(enable_config_cache);
+
+/** Set to CONSTANT_TRUE to use the flat array-based event registry
+ * (FlatEventHandlers) instead of the tree-based one in the EventService. */
+DEFAULT_CONST_FALSE(flat_event_registry);
+
+/** Set to a positive number to call the event handlers for the global and
+ * addressed identify events messages in batches of this size in a single
+ * executor turn, instead of sending each call through the EventCallerFlow. 0
+ * disables batching. */
+DEFAULT_CONST(event_handler_batch_size, 0);
+
 /** How many CAN frames should the bulk alias allocator be sending at the same
  * time. */
 DEFAULT_CONST(bulk_alias_num_can_frames, 20);
@@ -78,3 +99,11 @@ DEFAULT_CONST(bulk_alias_num_can_frames, 20);
 /** Default number of bytes in maximum stream window size for { @ref
  * StreamReceiver }. */
 DEFAULT_CONST(stream_receiver_default_window_size, 2 * 1024);
+
+#ifdef __FreeRTOS__
+/** Read-ahead buffer of FileMemorySpace for stream reads. */
+DEFAULT_CONST(file_memory_space_read_ahead, 0);
+#else
+/** Read-ahead buffer of FileMemorySpace for stream reads. */
+DEFAULT_CONST(file_memory_space_read_ahead, 8 * 1024);
+#endif
@@ -41,6 +41,70 @@ void empty_signal_handler(int)
 {
 }
 
+#if OPENMRN_FEATURE_EXECUTOR_EPOLL
+#include <algorithm>
+#include <atomic>
+#include <errno.h>
+#include <sys/eventfd.h>
+
+void OSSelectWakeup::create_wakeup_fd()
+{
+    wakeupFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    HASSERT(wakeupFd_ >= 0);
+}
+
+int OSSelectWakeup::wait_epoll(int epfd, struct epoll_event *events,
+    int maxevents, long long deadline_nsec)
+{
+    {
+        AtomicHolder l(this);
+        inSelect_ = true;
+        if (pendingWakeup_)
+        {
+            deadline_nsec = 0;
+        }
+    }
+    int ret = -1;
+#if defined(__GLIBC__)
+#if __GLIBC_PREREQ(2, 35)
+#define OSSELECTWAKEUP_HAVE_PWAIT2
+#endif
+#endif
+#ifdef OSSELECTWAKEUP_HAVE_PWAIT2
+    // epoll_pwait2 has nanosecond resolution for the timeout. It needs Linux
+    // 5.11; older kernels fall back to the millisecond resolution call. Every
+    // executor thread comes here, so the probe result is atomic.
+    static std::atomic<bool> have_pwait2 {true};
+    if (have_pwait2.load(std::memory_order_relaxed))
+    {
+        struct timespec timeout;
+        timeout.tv_sec = deadline_nsec / 1000000000;
+        timeout.tv_nsec = deadline_nsec % 1000000000;
+        ret = ::epoll_pwait2(epfd, events, maxevents,
+            deadline_nsec < 0 ? nullptr : &timeout, nullptr);
+        if (ret < 0 && errno == ENOSYS)
+        {
+            have_pwait2.store(false, std::memory_order_relaxed);
+        }
+    }
+    if (!have_pwait2.load(std::memory_order_relaxed))
+#endif
+    {
+        // Rounds up so that we do not spin while waiting for a timer.
+        int timeout_msec = deadline_nsec < 0
+            ? -1
+            : (int)std::min((deadline_nsec + 999999) / 1000000, 0x7fffffffLL);
+        ret = ::epoll_wait(epfd, events, maxevents, timeout_msec);
+    }
+    {
+        AtomicHolder l(this);
+        pendingWakeup_ = false;
+        inSelect_ = false;
+    }
+    return ret;
+}
+#endif // OPENMRN_FEATURE_EXECUTOR_EPOLL
+
 int OSSelectWakeup::select(int nfds, fd_set *readfds,
                            fd_set *writefds, fd_set *exceptfds,
                            long long deadline_nsec)
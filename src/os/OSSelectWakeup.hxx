@@ -48,6 +48,10 @@
 #include <signal.h>
 #endif
 
+#if OPENMRN_FEATURE_EXECUTOR_EPOLL
+#include <sys/epoll.h>
+#endif
+
 #ifdef __WINNT__
 #include <winsock2.h>
 #elif OPENMRN_HAVE_SELECT
@@ -79,12 +83,18 @@ public:
         : pendingWakeup_(false)
         , inSelect_(false)
     {
+#if OPENMRN_FEATURE_EXECUTOR_EPOLL
+        create_wakeup_fd();
+#endif
     }
 
     ~OSSelectWakeup()
     {
 #ifdef ESP_PLATFORM
         esp_deallocate_vfs_fd();
+#endif
+#if OPENMRN_FEATURE_EXECUTOR_EPOLL
+        ::close(wakeupFd_);
 #endif
     }
 
@@ -105,6 +115,8 @@ public:
 #endif
 #if OPENMRN_FEATURE_DEVICE_SELECT
         Device::select_insert(&selectInfo_);
+#elif OPENMRN_FEATURE_EXECUTOR_EPOLL
+        // Wakeups go through the eventfd, no signal handling is needed.
 #elif OPENMRN_HAVE_PSELECT
         // Blocks SIGUSR1 in the signal mask of the current thread.
         sigset_t usrmask;
@@ -139,6 +151,10 @@ public:
             // We cannot destroy the thread ID in the local object.
             Device::SelectInfo copy(selectInfo_);
             Device::select_wakeup(&copy);
+#elif OPENMRN_FEATURE_EXECUTOR_EPOLL
+            uint64_t one = 1;
+            ssize_t ret = ::write(wakeupFd_, &one, sizeof(one));
+            (void)ret; // EAGAIN means there is already a wakeup pending.
 #elif OPENMRN_HAVE_PSELECT
             pthread_kill(thread_, WAKEUP_SIG);
 #elif defined(ESP_PLATFORM)
@@ -201,7 +217,46 @@ public:
     int select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds,
                long long deadline_nsec);
 
+#if OPENMRN_FEATURE_EXECUTOR_EPOLL
+    /** Waits on an epoll set, allowing the wait to be woken up asynchronously
+     * from a different thread. The caller must have added wakeup_fd() to the
+     * epoll set (for EPOLLIN) and call drain_wakeup() when it is reported.
+     *
+     * @param epfd the epoll file descriptor.
+     * @param events output array for the ready events.
+     * @param maxevents number of entries in the events array.
+     * @param deadline_nsec is the maximum time to sleep if no fd activity and
+     * no wakeup happens. -1 to sleep indefinitely, 0 to return immediately.
+     *
+     * @return what epoll_wait would return (number of events, 0 in case of
+     * timeout, -1 on error).
+     */
+    int wait_epoll(int epfd, struct epoll_event *events, int maxevents,
+        long long deadline_nsec);
+
+    /// @return the eventfd that becomes readable when wakeup() is called.
+    int wakeup_fd()
+    {
+        return wakeupFd_;
+    }
+
+    /// Consumes the pending wakeups from the eventfd.
+    void drain_wakeup()
+    {
+        uint64_t count;
+        ssize_t ret = ::read(wakeupFd_, &count, sizeof(count));
+        (void)ret;
+    }
+#endif
+
 private:
+#if OPENMRN_FEATURE_EXECUTOR_EPOLL
+    /// Allocates wakeupFd_.
+    void create_wakeup_fd();
+    /// eventfd used for waking up the epoll wait.
+    int wakeupFd_;
+#endif
+
 #ifdef ESP_PLATFORM
     void esp_allocate_vfs_fd();
     void esp_deallocate_vfs_fd();
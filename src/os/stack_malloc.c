@@ -59,3 +59,10 @@ void *buffer_malloc(size_t length)
     void *volatile v = malloc(length);
     return v;
 }
+
+void buffer_free(void *buffer) __attribute__((weak));
+
+void buffer_free(void *buffer)
+{
+    free(buffer);
+}
@@ -34,6 +34,11 @@
 #include "utils/Buffer.hxx"
 #include "utils/ByteBuffer.hxx"
 
+#include <string.h>
+
+#include "nmranet_config.h"
+#include "utils/logging.h"
+
 DynamicPool *mainBufferPool = nullptr;
 Pool *rawBufferPool = nullptr;
 
@@ -47,10 +52,403 @@ Pool* init_main_buffer_pool()
     {
         mainBufferPool =
             new DynamicPool(Bucket::init(32, 48, LARGEST_BUFFERPOOL_BUCKET, 0));
+        if (config_main_buffer_pool_trim_watermark() > 0)
+        {
+            mainBufferPool->set_trim_watermark(
+                config_main_buffer_pool_trim_watermark());
+        }
+#if OPENMRN_FEATURE_BUFFER_THREAD_CACHE
+        if (config_main_buffer_pool_thread_cache() > 0)
+        {
+            mainBufferPool->enable_thread_cache(
+                config_main_buffer_pool_thread_cache());
+        }
+#endif
     }
     return mainBufferPool;
 }
 
+extern "C" {
+/// malloc implementation used for allocating buffer space. Override the weak
+/// definition if the buffer space should be allocated from some other place
+/// than the heap. Useful for MCUs with multiple memory banks.
+/// @param length how much memory to allocate (in bytes)
+/// @return pointer to allcoated memory
+extern void *buffer_malloc(size_t length);
+/// Frees memory allocated by buffer_malloc. Used only when a DynamicPool is
+/// trimmed, or when a thread cache outlives its DynamicPool. Override the
+/// weak definition together with buffer_malloc.
+/// @param buffer is the memory to free.
+extern void buffer_free(void *buffer);
+}
+
+#if OPENMRN_FEATURE_BUFFER_THREAD_CACHE
+
+/// @return the lock guarding the list of thread caches of every
+/// DynamicPool. Never destroyed, because threads may exit during the static
+/// destruction.
+static Atomic *thread_cache_lock()
+{
+    static Atomic *lock = new Atomic();
+    return lock;
+}
+
+/// Free buffers of one DynamicPool kept by one thread. Only the owning thread
+/// touches the magazines. Other threads (enable_thread_cache(), the pool
+/// destructor) only set drainRequested_ or clear pool_; the owning thread
+/// then empties the cache on its next use of the pool or when it exits.
+class DynamicPoolThreadCache
+{
+public:
+    /// Constructor.
+    /// @param pool is the pool whose buffers are cached.
+    /// @param magazine_size is the capacity of each magazine.
+    /// @param num_buckets is the number of buckets of the pool.
+    DynamicPoolThreadCache(
+        DynamicPool *pool, unsigned magazine_size, unsigned num_buckets)
+        : pool_(pool)
+        , magazineSize_(magazine_size)
+        , numBuckets_(num_buckets)
+        , items_(new BufferBase *[numBuckets_ * magazineSize_])
+        , counts_(new unsigned[numBuckets_])
+    {
+        for (unsigned i = 0; i < numBuckets_; ++i)
+        {
+            counts_[i] = 0;
+        }
+    }
+
+    ~DynamicPoolThreadCache()
+    {
+        delete[] items_;
+        delete[] counts_;
+    }
+
+    /// @param idx is a bucket index. @return the magazine of that bucket.
+    BufferBase **magazine(unsigned idx)
+    {
+        return items_ + idx * magazineSize_;
+    }
+
+    /// Moves every cached buffer back to the shared buckets of the pool.
+    /// Called on the owning thread.
+    /// @param pool is the pool of this cache.
+    void flush(DynamicPool *pool)
+    {
+        for (unsigned i = 0; i < numBuckets_; ++i)
+        {
+            BufferBase **m = magazine(i);
+            Bucket *bucket = pool->buckets + i;
+            AtomicHolder h(bucket->lock());
+            for (unsigned j = 0; j < counts_[i]; ++j)
+            {
+                bucket->insert_locked(m[j]);
+            }
+            counts_[i] = 0;
+        }
+    }
+
+    /// Empties the cache and unregisters it from the pool. If the pool was
+    /// destroyed already, returns the cached buffers to the heap. Called on
+    /// the owning thread, when the thread exits or when a drain was
+    /// requested; the caller deletes the cache afterwards.
+    void retire()
+    {
+        {
+            // Holding the lock keeps the pool from being destroyed while we
+            // put the buffers back into its buckets.
+            AtomicHolder h(thread_cache_lock());
+            DynamicPool *pool = pool_.load(std::memory_order_relaxed);
+            if (pool)
+            {
+                flush(pool);
+                add_stats(&pool->retiredStats_);
+                if (drainRequested_.load(std::memory_order_relaxed))
+                {
+                    --pool->pendingDrains_;
+                }
+                for (DynamicPoolThreadCache **pp = &pool->caches_; *pp;
+                     pp = &(*pp)->nextInPool_)
+                {
+                    if (*pp == this)
+                    {
+                        *pp = nextInPool_;
+                        break;
+                    }
+                }
+                return;
+            }
+        }
+        for (unsigned i = 0; i < numBuckets_; ++i)
+        {
+            BufferBase **m = magazine(i);
+            for (unsigned j = 0; j < counts_[i]; ++j)
+            {
+                buffer_free(m[j]);
+            }
+            counts_[i] = 0;
+        }
+    }
+
+    /// Adds the statistics of this cache to an accumulator.
+    /// @param stats is the accumulator.
+    void add_stats(DynamicPoolCacheStats *stats)
+    {
+        stats->allocHits += allocHits_.load(std::memory_order_relaxed);
+        stats->allocMisses += allocMisses_.load(std::memory_order_relaxed);
+        stats->freeHits += freeHits_.load(std::memory_order_relaxed);
+        stats->freeMisses += freeMisses_.load(std::memory_order_relaxed);
+        stats->sharedLocks += sharedLocks_.load(std::memory_order_relaxed);
+    }
+
+    /// Increments a statistics counter. Only the owning thread writes the
+    /// counters, so this needs no read-modify-write instruction.
+    /// @param c is the counter to increment.
+    static void inc(std::atomic<uint32_t> *c)
+    {
+        c->store(c->load(std::memory_order_relaxed) + 1,
+            std::memory_order_relaxed);
+    }
+
+    /// Pool whose buffers we cache. Set to nullptr when the pool is
+    /// destroyed.
+    std::atomic<DynamicPool *> pool_;
+    /// Set by other threads to ask the owning thread to empty and drop this
+    /// cache. Written under the thread_cache_lock().
+    std::atomic<bool> drainRequested_ {false};
+    /// Next cache of the same thread.
+    DynamicPoolThreadCache *nextInThread_ {nullptr};
+    /// Next cache of the same pool. Guarded by the thread_cache_lock().
+    DynamicPoolThreadCache *nextInPool_ {nullptr};
+    /// Capacity of each magazine.
+    unsigned magazineSize_;
+    /// Number of magazines (one per bucket).
+    unsigned numBuckets_;
+    /// Storage of the magazines, each magazineSize_ long.
+    BufferBase **items_;
+    /// Number of buffers in each magazine.
+    unsigned *counts_;
+
+    /// @{ Statistics counters. See DynamicPoolCacheStats.
+    std::atomic<uint32_t> allocHits_ {0};
+    std::atomic<uint32_t> allocMisses_ {0};
+    std::atomic<uint32_t> freeHits_ {0};
+    std::atomic<uint32_t> freeMisses_ {0};
+    std::atomic<uint32_t> sharedLocks_ {0};
+    /// @}
+};
+
+/// Owns the caches of the current thread; returns them to their pools when
+/// the thread exits.
+struct ThreadCacheList
+{
+    ~ThreadCacheList()
+    {
+        while (head_)
+        {
+            DynamicPoolThreadCache *c = head_;
+            head_ = c->nextInThread_;
+            c->retire();
+            delete c;
+        }
+    }
+
+    /// Caches of this thread, one per pool.
+    DynamicPoolThreadCache *head_ {nullptr};
+};
+
+/// Caches of the current thread.
+static thread_local ThreadCacheList t_caches;
+
+void DynamicPool::enable_thread_cache(unsigned magazine_size)
+{
+    if (!numBuckets_)
+    {
+        unsigned num = 0;
+        while (buckets[num].size() != 0)
+        {
+            ++num;
+        }
+        numBuckets_ = num;
+    }
+    {
+        AtomicHolder h(thread_cache_lock());
+        magazineSize_.store(magazine_size, std::memory_order_release);
+        // The existing caches have the old magazine size. Their owners drop
+        // them on the next use of the pool.
+        for (DynamicPoolThreadCache *c = caches_; c; c = c->nextInPool_)
+        {
+            if (!c->drainRequested_.load(std::memory_order_relaxed))
+            {
+                c->drainRequested_.store(true, std::memory_order_release);
+                ++pendingDrains_;
+            }
+        }
+    }
+    drain_own_cache();
+}
+
+void DynamicPool::get_cache_stats(DynamicPoolCacheStats *stats)
+{
+    AtomicHolder h(thread_cache_lock());
+    *stats = retiredStats_;
+    for (DynamicPoolThreadCache *c = caches_; c; c = c->nextInPool_)
+    {
+        c->add_stats(stats);
+        ++stats->threads;
+    }
+}
+
+DynamicPoolThreadCache *DynamicPool::thread_cache()
+{
+    DynamicPoolThreadCache **pp = &t_caches.head_;
+    while (*pp)
+    {
+        DynamicPoolThreadCache *c = *pp;
+        DynamicPool *pool = c->pool_.load(std::memory_order_acquire);
+        if (pool == this &&
+            !c->drainRequested_.load(std::memory_order_acquire))
+        {
+            return c;
+        }
+        if (pool == this || !pool)
+        {
+            // A drain was requested, or the pool was destroyed.
+            *pp = c->nextInThread_;
+            c->retire();
+            delete c;
+            continue;
+        }
+        pp = &c->nextInThread_;
+    }
+    unsigned magazine_size = magazineSize_.load(std::memory_order_acquire);
+    if (!magazine_size)
+    {
+        return nullptr;
+    }
+    DynamicPoolThreadCache *c =
+        new DynamicPoolThreadCache(this, magazine_size, numBuckets_);
+    c->nextInThread_ = t_caches.head_;
+    t_caches.head_ = c;
+    AtomicHolder h(thread_cache_lock());
+    c->nextInPool_ = caches_;
+    caches_ = c;
+    return c;
+}
+
+BufferBase *DynamicPool::cache_alloc(Bucket *bucket)
+{
+    DynamicPoolThreadCache *c = thread_cache();
+    if (!c)
+    {
+        return static_cast<BufferBase *>(bucket->next().item);
+    }
+    unsigned idx = bucket - buckets;
+    BufferBase **m = c->magazine(idx);
+    unsigned &count = c->counts_[idx];
+    if (count)
+    {
+        c->inc(&c->allocHits_);
+        return m[--count];
+    }
+    c->inc(&c->allocMisses_);
+    c->inc(&c->sharedLocks_);
+    unsigned want = (c->magazineSize_ + 1) / 2;
+    {
+        AtomicHolder h(bucket->lock());
+        while (count < want)
+        {
+            QMember *qm = bucket->next_locked().item;
+            if (!qm)
+            {
+                break;
+            }
+            m[count++] = static_cast<BufferBase *>(qm);
+        }
+    }
+    if (!count)
+    {
+        return nullptr;
+    }
+    return m[--count];
+}
+
+bool DynamicPool::cache_free(Bucket *bucket, BufferBase *item)
+{
+    DynamicPoolThreadCache *c = thread_cache();
+    if (!c)
+    {
+        return false;
+    }
+    unsigned idx = bucket - buckets;
+    BufferBase **m = c->magazine(idx);
+    unsigned &count = c->counts_[idx];
+    if (count < c->magazineSize_)
+    {
+        c->inc(&c->freeHits_);
+        m[count++] = item;
+        return true;
+    }
+    c->inc(&c->freeMisses_);
+    c->inc(&c->sharedLocks_);
+    // Spills the oldest half of the magazine; the most recently freed
+    // buffers are the most likely to be still in the CPU cache.
+    unsigned spill = (c->magazineSize_ + 1) / 2;
+    unsigned i = 0;
+    {
+        AtomicHolder h(bucket->lock());
+        for (; i < spill; ++i)
+        {
+            if (trimWatermark_ && bucket->pending() >= trimWatermark_)
+            {
+                break;
+            }
+            bucket->insert_locked(m[i]);
+        }
+    }
+    for (; i < spill; ++i)
+    {
+        release(bucket, m[i]);
+    }
+    memmove(m, m + spill, (count - spill) * sizeof(m[0]));
+    count -= spill;
+    m[count++] = item;
+    return true;
+}
+
+void DynamicPool::drain_own_cache()
+{
+    for (DynamicPoolThreadCache **pp = &t_caches.head_; *pp;
+         pp = &(*pp)->nextInThread_)
+    {
+        DynamicPoolThreadCache *c = *pp;
+        if (c->pool_.load(std::memory_order_relaxed) == this)
+        {
+            *pp = c->nextInThread_;
+            c->retire();
+            delete c;
+            return;
+        }
+    }
+}
+
+void DynamicPool::drop_thread_caches()
+{
+    drain_own_cache();
+    AtomicHolder h(thread_cache_lock());
+    while (caches_)
+    {
+        DynamicPoolThreadCache *c = caches_;
+        caches_ = c->nextInPool_;
+        c->add_stats(&retiredStats_);
+        c->nextInPool_ = nullptr;
+        // The owning thread will return the cached buffers to the heap.
+        c->pool_.store(nullptr, std::memory_order_release);
+    }
+}
+
+#endif // OPENMRN_FEATURE_BUFFER_THREAD_CACHE
+
 /** Number of free items in the pool.
  * @return number of free items in the pool
  */
@@ -87,15 +485,6 @@ Atomic g_alloc_atomic;
 void* g_current_alloc;
 #endif
 
-extern "C" {
-/// malloc implementation used for allocating buffer space. Override the weak
-/// definition if the buffer space should be allocated from some other place
-/// than the heap. Useful for MCUs with multiple memory banks.
-/// @param length how much memory to allocate (in bytes)
-/// @return pointer to allcoated memory
-extern void *buffer_malloc(size_t length);
-}
-
 /** Get a free item out of the pool.
  * @param size tells how much to allocate (in bytes)
  * @param flow if !NULL, then the alloc call is considered async and will
@@ -110,7 +499,13 @@ BufferBase *DynamicPool::alloc_untyped(size_t size, Executable *flow)
     {
         if (size <= current->size())
         {
+#if OPENMRN_FEATURE_BUFFER_THREAD_CACHE
+            result = use_thread_cache()
+                ? cache_alloc(current)
+                : static_cast<BufferBase *>(current->next().item);
+#else
             result = static_cast<BufferBase*>(current->next().item);
+#endif
             if (result == NULL)
             {
                 result = (BufferBase*)buffer_malloc(current->size());
@@ -119,7 +514,10 @@ BufferBase *DynamicPool::alloc_untyped(size_t size, Executable *flow)
                     if (0 && totalSize < 5000 && totalSize + current->size() >= 5000) {
                         HASSERT(0);
                     }
-                    current->allocCount_++;
+                    if (++current->allocCount_ > current->highWater_)
+                    {
+                        current->highWater_ = current->allocCount_;
+                    }
                     totalSize += current->size();
                 }
             }
@@ -136,6 +534,11 @@ BufferBase *DynamicPool::alloc_untyped(size_t size, Executable *flow)
         {
             AtomicHolder h(this);
             totalSize += size;
+            largeSize_ += size;
+            if (largeSize_ > largeHighWater_)
+            {
+                largeHighWater_ = largeSize_;
+            }
         }
     }
 #ifdef DEBUG_BUFFER_MEMORY
@@ -174,6 +577,17 @@ void DynamicPool::free(BufferBase *item)
     {
         if (item->size() <= current->size())
         {
+#if OPENMRN_FEATURE_BUFFER_THREAD_CACHE
+            if (use_thread_cache() && cache_free(current, item))
+            {
+                return;
+            }
+#endif
+            if (trimWatermark_ && current->pending() >= trimWatermark_)
+            {
+                release(current, item);
+                return;
+            }
             current->insert(item);
             return;
         }
@@ -182,10 +596,96 @@ void DynamicPool::free(BufferBase *item)
     {
         AtomicHolder h(this);
         totalSize -= item->size();
+        largeSize_ -= item->size();
     }
     free_large(item);
 }
 
+void DynamicPool::release(Bucket *bucket, BufferBase *item)
+{
+    {
+        AtomicHolder h(this);
+        --bucket->allocCount_;
+        ++bucket->releasedCount_;
+        totalSize -= bucket->size();
+    }
+    buffer_free(item);
+}
+
+size_t DynamicPool::trim(unsigned keep_free)
+{
+    size_t released = 0;
+    for (Bucket *current = buckets; current->size() != 0; ++current)
+    {
+        while (true)
+        {
+            QMember *item;
+            {
+                AtomicHolder h(current->lock());
+                if (current->pending() <= keep_free)
+                {
+                    break;
+                }
+                item = current->next_locked().item;
+            }
+            release(current, static_cast<BufferBase *>(item));
+            released += current->size();
+        }
+    }
+    return released;
+}
+
+bool DynamicPool::get_bucket_stats(unsigned index, DynamicPoolBucketStats *stats)
+{
+    Bucket *current = buckets;
+    for (unsigned i = 0; i < index; ++i, ++current)
+    {
+        if (current->size() == 0)
+        {
+            return false;
+        }
+    }
+    AtomicHolder h(this);
+    if (current->size() == 0)
+    {
+        stats->size = 0;
+        stats->allocated = largeSize_;
+        stats->free = 0;
+        stats->highWater = largeHighWater_;
+        stats->released = 0;
+        return true;
+    }
+    stats->size = current->size();
+    stats->allocated = current->allocCount_;
+    stats->free = current->pending();
+    stats->highWater = current->highWater_;
+    stats->released = current->releasedCount_;
+    return true;
+}
+
+void DynamicPool::dump_usage()
+{
+    DynamicPoolBucketStats s;
+    LOG(ALWAYS, "Buffer pool %p: %u bytes", this, (unsigned)total_size());
+    for (unsigned i = 0; get_bucket_stats(i, &s); ++i)
+    {
+        if (s.size)
+        {
+            LOG(ALWAYS,
+                "  bucket %4u: %5u allocated, %5u in use, %5u free, "
+                "%5u peak, %5u released",
+                (unsigned)s.size, (unsigned)s.allocated,
+                (unsigned)(s.allocated - s.free), (unsigned)s.free,
+                (unsigned)s.highWater, (unsigned)s.released);
+        }
+        else
+        {
+            LOG(ALWAYS, "  large: %u bytes in use, %u bytes peak",
+                (unsigned)s.allocated, (unsigned)s.highWater);
+        }
+    }
+}
+
 /** Get a free item out of the pool.
  * @param size how many payload bytes should he allocated buffer have. Usually
  * sizeof<T> for Buffer<T>.
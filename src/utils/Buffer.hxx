@@ -479,11 +479,53 @@ private:
     size_t size_; /**< size of entry */
 public:
     size_t allocCount_{0}; /**< total entries allocated */
+    size_t highWater_{0}; /**< largest value allocCount_ ever had */
+    size_t releasedCount_{0}; /**< entries returned to the heap by trimming */
 private:
     /** list of anyone waiting for an item in the bucket */
     Q pending_;
 };
 
+/// Memory usage of one bucket of a DynamicPool.
+struct DynamicPoolBucketStats
+{
+    /// Size of the entries in this bucket, in bytes. 0 for the entries that
+    /// are larger than every bucket and are allocated directly from the heap;
+    /// for those the counters below are in bytes instead of entries.
+    size_t size;
+    /// Entries currently allocated from the heap.
+    size_t allocated;
+    /// Entries on the free list of the bucket. The entries in use are
+    /// allocated - free (including the ones in thread caches).
+    size_t free;
+    /// Largest number of entries ever allocated at the same time. Without
+    /// thread caches this is the peak number of entries in use.
+    size_t highWater;
+    /// Entries returned to the heap by trimming.
+    size_t released;
+};
+
+/// Statistics of the thread-local caches of a DynamicPool. Summed over all
+/// threads, including those that have already exited.
+struct DynamicPoolCacheStats
+{
+    /// Number of allocations served from a thread cache.
+    uint32_t allocHits;
+    /// Number of allocations that had to go to the shared buckets.
+    uint32_t allocMisses;
+    /// Number of frees that were kept in a thread cache.
+    uint32_t freeHits;
+    /// Number of frees that had to spill to the shared buckets.
+    uint32_t freeMisses;
+    /// Number of times a thread cache took a shared bucket lock. Without
+    /// the caches every allocation and every free takes a bucket lock.
+    uint32_t sharedLocks;
+    /// Number of threads that currently have a cache.
+    uint32_t threads;
+};
+
+class DynamicPoolThreadCache;
+
 /** A specialization of a pool which can allocate new elements dynamically
  * upon request.
  */
@@ -502,6 +544,9 @@ public:
     /** default destructor */
     ~DynamicPool()
     {
+#if OPENMRN_FEATURE_BUFFER_THREAD_CACHE
+        drop_thread_caches();
+#endif
 #ifdef GTEST
         for (unsigned i = 0; buckets[i].size() != 0; ++i)
         {
@@ -531,6 +576,52 @@ public:
      */
     size_t free_items(size_t size) override;
 
+    /** Sets a limit on the number of free entries each bucket keeps. Entries
+     * freed above this limit are returned to the heap. Only usable if
+     * buffer_free() can free the memory returned by buffer_malloc().
+     * @param max_free is the number of free entries to keep per bucket; 0
+     * keeps every entry (the default). */
+    void set_trim_watermark(unsigned max_free)
+    {
+        trimWatermark_ = max_free;
+    }
+
+    /** Returns free entries to the heap. Entries in thread caches are not
+     * touched.
+     * @param keep_free is the number of free entries to keep in each bucket.
+     * @return the number of bytes returned to the heap. */
+    size_t trim(unsigned keep_free);
+
+    /** Reports the memory usage of one bucket.
+     * @param index is the index of the bucket. The index after the last
+     * bucket reports the large entries.
+     * @param stats will be filled in.
+     * @return false if index is past the large entries. */
+    bool get_bucket_stats(unsigned index, DynamicPoolBucketStats *stats);
+
+    /** Prints the memory usage of every bucket to the log. Useful for
+     * choosing the bucket sizes. */
+    void dump_usage();
+
+#if OPENMRN_FEATURE_BUFFER_THREAD_CACHE
+    /** Puts a cache of free buffers in front of the shared buckets for every
+     * thread that uses this pool. Allocations and frees then take a bucket
+     * lock only when the cache of the thread runs empty or full, and then
+     * move half a cache worth of buffers at once. Buffers in the thread
+     * caches are not counted by free_items(). The first call must happen
+     * before the pool is used from multiple threads. A later call empties the
+     * cache of the calling thread right away; other threads empty their own
+     * cache on their next allocation or free from this pool, or when they
+     * exit.
+     * @param magazine_size is the maximum number of free buffers a thread
+     * keeps per bucket. 0 turns the caches off. */
+    void enable_thread_cache(unsigned magazine_size);
+
+    /** Sums the statistics of the thread caches.
+     * @param stats will be filled in. */
+    void get_cache_stats(DynamicPoolCacheStats *stats);
+#endif
+
 protected:
     /** Free buffer queue */
     Bucket *buckets;
@@ -558,6 +649,72 @@ private:
      */
     void free(BufferBase *item) override;
 
+    /** Returns a bucket entry to the heap.
+     * @param bucket is the bucket the entry belongs to.
+     * @param item is the entry (not on the free list). */
+    void release(Bucket *bucket, BufferBase *item);
+
+    /// Number of free entries kept per bucket; 0 for no limit.
+    unsigned trimWatermark_ {0};
+    /// Bytes currently allocated in large entries.
+    size_t largeSize_ {0};
+    /// Largest value of largeSize_.
+    size_t largeHighWater_ {0};
+
+#if OPENMRN_FEATURE_BUFFER_THREAD_CACHE
+    /** @return the cache of the current thread for this pool, creating it if
+     * needed. */
+    DynamicPoolThreadCache *thread_cache();
+
+    /** Takes a buffer from the cache of the current thread, refilling the
+     * cache from the shared bucket if needed.
+     * @param bucket is the bucket to allocate from.
+     * @return a free buffer, or nullptr if the bucket is empty. */
+    BufferBase *cache_alloc(Bucket *bucket);
+
+    /** Puts a buffer into the cache of the current thread, spilling half the
+     * cache to the shared bucket if it is full.
+     * @param bucket is the bucket the buffer belongs to.
+     * @param item is the buffer to free.
+     * @return false if the current thread has no cache, because the caches
+     * are off; the caller then frees to the bucket. */
+    bool cache_free(Bucket *bucket, BufferBase *item);
+
+    /** @return true if allocations and frees have to go through the cache of
+     * the current thread. That is also the case after the caches were turned
+     * off, until every thread emptied its cache. */
+    bool use_thread_cache()
+    {
+        return magazineSize_.load(std::memory_order_relaxed) ||
+            pendingDrains_.load(std::memory_order_relaxed);
+    }
+
+    /** Returns the buffers of the current thread's cache to the buckets and
+     * drops that cache. */
+    void drain_own_cache();
+
+    /** Drains the cache of the current thread and detaches the caches of the
+     * other threads from this pool. Those threads return their cached
+     * buffers to the heap. Called from the destructor. */
+    void drop_thread_caches();
+
+    /// Maximum number of buffers per bucket in a thread cache; 0 if the
+    /// caches are off.
+    std::atomic<unsigned> magazineSize_ {0};
+    /// Number of caches that were asked to drain and did not do so yet.
+    /// Written under the global cache lock.
+    std::atomic<unsigned> pendingDrains_ {0};
+    /// Number of buckets in the pool. Written before magazineSize_ is first
+    /// set.
+    unsigned numBuckets_ {0};
+    /// All thread caches of this pool. Guarded by the global cache lock.
+    DynamicPoolThreadCache *caches_ {nullptr};
+    /// Statistics of the caches of threads that already exited.
+    DynamicPoolCacheStats retiredStats_ {0, 0, 0, 0, 0, 0};
+
+    friend class DynamicPoolThreadCache;
+#endif
+
     /** Default constructor.
      */
     DynamicPool();
@@ -96,6 +96,20 @@ public:
     /// @param fd is the file descriptor for the EEPROM file. The current
     /// offset in this file is unspecified, callees must do lseek.
     virtual void factory_reset(int fd) = 0;
+
+    /// Reports which part of the configuration file apply_configuration()
+    /// depends on. When the configuration file is cached, a configuration
+    /// update that does not touch this range will skip calling this listener.
+    ///
+    /// @param offset will be set to the first byte of the range.
+    /// @param size will be set to the length of the range in bytes.
+    ///
+    /// @return false if the listener may depend on any part of the file (this
+    /// is the default).
+    virtual bool config_range(unsigned *offset, unsigned *size)
+    {
+        return false;
+    }
 };
 
 
@@ -33,10 +33,21 @@
  */
 
 #include <stdint.h>
+#include <utility>
 
 #include "utils/Crc.hxx"
 #include "utils/macros.h"
 
+#if CRC_SLICE_BY > 1 && defined(__GNUC__) &&                                   \
+    (defined(__x86_64__) || defined(__i386__))
+/// Compiles the carry-less multiplication (PCLMULQDQ) folding path for the
+/// single-stream bulk CRC-16 functions. It is used only when the CPU
+/// supports it.
+#define CRC_HAVE_PCLMUL 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
 /// Initialization value for the CRC-16-IBM calculator.
 static const uint16_t crc_16_ibm_init_value = 0x0000; // TODO: check
 /// Polynomial for the CRC-16-IBM calculator.
@@ -137,6 +148,275 @@ void crc_16_ibm_add_basic(uint16_t &state, uint8_t data)
     }
 }
 
+#if CRC_SLICE_BY > 1
+
+static_assert(CRC_SLICE_BY == 4 || CRC_SLICE_BY == 8,
+    "Invalid value for CRC_SLICE_BY");
+
+/// Lookup tables for slicing-by-N computation of a 16-bit CRC, generated at
+/// compile time. table_[0] is the usual byte-at-a-time table; table_[k][b] is
+/// the CRC contribution of byte b followed by k zero bytes.
+/// @param REFLECTED true for LSB-first CRCs (like CRC-16-IBM), false for
+/// MSB-first CRCs (like CRC-16-CCITT).
+/// @param N number of tables (bytes processed in one step).
+template <bool REFLECTED, unsigned N> struct Crc16SliceTables
+{
+    /// Generates the tables.
+    /// @param poly the polynomial; for reflected CRCs in reflected form.
+    constexpr Crc16SliceTables(uint16_t poly)
+    {
+        for (unsigned b = 0; b < 256; ++b)
+        {
+            uint16_t state = REFLECTED ? b : b << 8;
+            for (int i = 0; i < 8; ++i)
+            {
+                if (REFLECTED)
+                {
+                    state = (state & 1) ? (state >> 1) ^ poly : state >> 1;
+                }
+                else
+                {
+                    state = (state & 0x8000) ? (state << 1) ^ poly
+                                             : state << 1;
+                }
+            }
+            table_[0][b] = state;
+        }
+        for (unsigned k = 1; k < N; ++k)
+        {
+            for (unsigned b = 0; b < 256; ++b)
+            {
+                uint16_t prev = table_[k - 1][b];
+                table_[k][b] = REFLECTED
+                    ? (prev >> 8) ^ table_[0][prev & 0xff]
+                    : (prev << 8) ^ table_[0][prev >> 8];
+            }
+        }
+    }
+
+    /// Adds one byte to a CRC state.
+    /// @param state current CRC state
+    /// @param b next byte of the message
+    /// @return new CRC state
+    uint16_t update1(uint16_t state, uint8_t b) const
+    {
+        if (REFLECTED)
+        {
+            return (state >> 8) ^ table_[0][(state ^ b) & 0xff];
+        }
+        else
+        {
+            return (state << 8) ^ table_[0][(state >> 8) ^ b];
+        }
+    }
+
+    /// Adds M bytes to a CRC state in one step.
+    /// @param M number of bytes; 2 <= M <= N.
+    /// @param STRIDE distance of the bytes in memory; 2 adds every second
+    /// byte.
+    /// @param state current CRC state
+    /// @param b the next M * STRIDE bytes of the message
+    /// @return new CRC state
+    template <unsigned M, unsigned STRIDE = 1>
+    uint16_t update(uint16_t state, const uint8_t *b) const
+    {
+        static_assert(M >= 2 && M <= N, "invalid slice length");
+        uint8_t b0 = b[0] ^ (REFLECTED ? state & 0xff : state >> 8);
+        uint8_t b1 = b[STRIDE] ^ (REFLECTED ? state >> 8 : state & 0xff);
+        return table_[M - 1][b0] ^ table_[M - 2][b1] ^
+            xor_rest<M, STRIDE>(b, std::make_index_sequence<M - 2>());
+    }
+
+    /// Helper for update<M>: looks up bytes 2..M-1 of a slice. Expanded at
+    /// compile time, since the loop would not get unrolled at -O2.
+    /// @param b the next M * STRIDE bytes of the message
+    /// @return XOR of the table entries of bytes 2..M-1.
+    template <unsigned M, unsigned STRIDE, size_t... K>
+    uint16_t xor_rest(const uint8_t *b, std::index_sequence<K...>) const
+    {
+        uint16_t ret = 0;
+        using expand = int[];
+        (void)expand {
+            0, (ret ^= table_[M - 3 - K][b[(K + 2) * STRIDE]], 0)...};
+        return ret;
+    }
+
+    /// Adds a block of bytes to a CRC state.
+    /// @param state current CRC state
+    /// @param data message bytes
+    /// @param len number of bytes in data
+    /// @return new CRC state
+    uint16_t update(uint16_t state, const uint8_t *data, size_t len) const
+    {
+        for (; len >= N; len -= N, data += N)
+        {
+            state = update<N>(state, data);
+        }
+        for (; len; --len, ++data)
+        {
+            state = update1(state, *data);
+        }
+        return state;
+    }
+
+    /// Computes the triple CRC (all bytes, even index bytes, odd index
+    /// bytes) of a block of data.
+    /// @param data message bytes
+    /// @param len number of bytes in data
+    /// @param states CRC states to update: all, even, odd.
+    void update3(const uint8_t *data, size_t len, uint16_t states[3]) const
+    {
+        for (; len >= N; len -= N, data += N)
+        {
+            states[0] = update<N>(states[0], data);
+            states[1] = update<N / 2, 2>(states[1], data);
+            states[2] = update<N / 2, 2>(states[2], data + 1);
+        }
+        for (size_t i = 0; i < len; ++i)
+        {
+            states[0] = update1(states[0], data[i]);
+            states[1 + (i & 1)] = update1(states[1 + (i & 1)], data[i]);
+        }
+    }
+
+    /// The lookup tables.
+    uint16_t table_[N][256] {};
+};
+
+/// Slicing tables for CRC-16-IBM.
+static constexpr Crc16SliceTables<true, CRC_SLICE_BY> crc16IbmTables {
+    crc_16_ibm_poly};
+
+/// Slicing tables for CRC-16-CCITT.
+static constexpr Crc16SliceTables<false, CRC_SLICE_BY> crc16CcittTables {
+    0x1021};
+
+#ifdef CRC_HAVE_PCLMUL
+
+/// Buffers shorter than this are left to the slicing tables.
+static constexpr size_t CRC_PCLMUL_MIN_LENGTH = 64;
+
+/// @param n exponent
+/// @param poly CRC polynomial in normal (MSB-first) form, without the x^16
+/// term.
+/// @return x^n mod poly, in normal form.
+static constexpr uint16_t crc16_xpow_mod(unsigned n, uint16_t poly)
+{
+    uint32_t r = 1;
+    for (unsigned i = 0; i < n; ++i)
+    {
+        r <<= 1;
+        if (r & 0x10000)
+        {
+            r ^= 0x10000 | poly;
+        }
+    }
+    return r;
+}
+
+/// @param k a polynomial of degree < 16 in normal form.
+/// @return k bit-reflected into a 64-bit word, coefficient of x^e at bit
+/// 63 - e.
+static constexpr uint64_t crc16_reflect64(uint16_t k)
+{
+    uint64_t r = 0;
+    for (unsigned e = 0; e < 16; ++e)
+    {
+        if ((k >> e) & 1)
+        {
+            r |= 1ULL << (63 - e);
+        }
+    }
+    return r;
+}
+
+/// @return true if the CPU has the PCLMULQDQ and SSSE3 instructions.
+static bool crc_have_pclmul()
+{
+    static const bool have = []() {
+        unsigned a, b, c, d;
+        return __get_cpuid(1, &a, &b, &c, &d) && (c & bit_PCLMUL) &&
+            (c & bit_SSSE3);
+    }();
+    return have;
+}
+
+/// Adds a block of bytes to a 16-bit CRC state by folding 16-byte chunks
+/// with carry-less multiplication. The 128-bit accumulator is kept
+/// congruent (mod the polynomial) to the processed prefix of the message;
+/// multiplying its two halves by x^192 and x^128 mod P moves it past the
+/// next chunk. The final accumulator and the tail go through the tables.
+/// This works for any polynomial; only the folding constants differ.
+/// @param REFLECTED true for LSB-first CRCs (like CRC-16-IBM), false for
+/// MSB-first CRCs (like CRC-16-CCITT).
+/// @param tables slicing tables of the same CRC
+/// @param k_lo folding constant for the low 64 bits of the accumulator
+/// @param k_hi folding constant for the high 64 bits of the accumulator
+/// @param state current CRC state
+/// @param data message bytes
+/// @param len number of bytes in data, at least 32.
+/// @return new CRC state
+template <bool REFLECTED>
+__attribute__((target("pclmul,ssse3"))) static uint16_t crc16_pclmul(
+    const Crc16SliceTables<REFLECTED, CRC_SLICE_BY> &tables, uint64_t k_lo,
+    uint64_t k_hi, uint16_t state, const uint8_t *data, size_t len)
+{
+    // MSB-first CRCs need the first byte in the most significant position.
+    const __m128i bswap =
+        _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m128i k = _mm_set_epi64x(k_hi, k_lo);
+    __m128i acc = _mm_loadu_si128((const __m128i *)data);
+    if (REFLECTED)
+    {
+        acc = _mm_xor_si128(acc, _mm_cvtsi32_si128(state));
+    }
+    else
+    {
+        acc = _mm_shuffle_epi8(acc, bswap);
+        acc = _mm_xor_si128(acc, _mm_set_epi64x((uint64_t)state << 48, 0));
+    }
+    data += 16;
+    len -= 16;
+    for (; len >= 16; len -= 16, data += 16)
+    {
+        __m128i d = _mm_loadu_si128((const __m128i *)data);
+        if (!REFLECTED)
+        {
+            d = _mm_shuffle_epi8(d, bswap);
+        }
+        acc = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(acc, k, 0x00),
+                                _mm_clmulepi64_si128(acc, k, 0x11)),
+            d);
+    }
+    if (!REFLECTED)
+    {
+        acc = _mm_shuffle_epi8(acc, bswap);
+    }
+    uint8_t rest[16];
+    _mm_storeu_si128((__m128i *)rest, acc);
+    state = tables.update(0, rest, 16);
+    return tables.update(state, data, len);
+}
+
+// In the reflected form a carry-less product lands one bit lower than the
+// reflected 128-bit result, which the exponents one less make up for.
+
+/// Folding constant for the low half (the earlier bytes) for CRC-16-IBM.
+static constexpr uint64_t CRC16_IBM_K_LO =
+    crc16_reflect64(crc16_xpow_mod(191, 0x8005));
+/// Folding constant for the high half (the later bytes) for CRC-16-IBM.
+static constexpr uint64_t CRC16_IBM_K_HI =
+    crc16_reflect64(crc16_xpow_mod(127, 0x8005));
+/// Folding constant for the low half (the later bytes) for CRC-16-CCITT.
+static constexpr uint64_t CRC16_CCITT_K_LO = crc16_xpow_mod(128, 0x1021);
+/// Folding constant for the high half (the earlier bytes) for
+/// CRC-16-CCITT.
+static constexpr uint64_t CRC16_CCITT_K_HI = crc16_xpow_mod(192, 0x1021);
+
+#endif // CRC_HAVE_PCLMUL
+
+#endif // CRC_SLICE_BY > 1
+
 /// Finalizes the state machine of a CRC16-IBM calculator.
 ///
 /// @param state internal state of the machine.
@@ -157,10 +437,21 @@ uint16_t crc_16_ibm(const void* data, size_t length)
 {
     const uint8_t *payload = static_cast<const uint8_t*>(data);
     uint16_t state = crc_16_ibm_init_value;
+#if CRC_SLICE_BY > 1
+#ifdef CRC_HAVE_PCLMUL
+    if (length >= CRC_PCLMUL_MIN_LENGTH && crc_have_pclmul())
+    {
+        return crc_16_ibm_finish(crc16_pclmul(crc16IbmTables, CRC16_IBM_K_LO,
+            CRC16_IBM_K_HI, state, payload, length));
+    }
+#endif
+    state = crc16IbmTables.update(state, payload, length);
+#else
     for (size_t i = 0; i < length; ++i)
     {
         crc_16_ibm_add(state, payload[i]);
     }
+#endif
     return crc_16_ibm_finish(state);
 }
 
@@ -198,6 +489,13 @@ void crc3_crc16_ibm(const void* data, size_t length_bytes, uint16_t* checksum)
             crc_16_ibm_add(state3, cbyte);
         }
     }
+#elif CRC_SLICE_BY > 1
+    uint16_t states[3] = {state1, state2, state3};
+    crc16IbmTables.update3(
+        static_cast<const uint8_t *>(data), length_bytes, states);
+    state1 = states[0];
+    state2 = states[1];
+    state3 = states[2];
 #else
     const uint8_t *payload = static_cast<const uint8_t*>(data);
     for (size_t i = 1; i <= length_bytes; ++i)
@@ -221,6 +519,60 @@ void crc3_crc16_ibm(const void* data, size_t length_bytes, uint16_t* checksum)
     checksum[2] = crc_16_ibm_finish(state3);
 }
 
+void Crc16CCITT::update(const void *data, size_t length_bytes)
+{
+    const uint8_t *payload = static_cast<const uint8_t *>(data);
+#if CRC_SLICE_BY > 1
+#ifdef CRC_HAVE_PCLMUL
+    if (length_bytes >= CRC_PCLMUL_MIN_LENGTH && crc_have_pclmul())
+    {
+        state_ = crc16_pclmul(crc16CcittTables, CRC16_CCITT_K_LO,
+            CRC16_CCITT_K_HI, state_, payload, length_bytes);
+        return;
+    }
+#endif
+    state_ = crc16CcittTables.update(state_, payload, length_bytes);
+#else
+    for (size_t i = 0; i < length_bytes; ++i)
+    {
+        update(payload[i]);
+    }
+#endif
+}
+
+void crc3_crc16_ccitt(
+    const void *data, size_t length_bytes, uint16_t checksum[3])
+{
+    const uint8_t *payload = static_cast<const uint8_t *>(data);
+#if CRC_SLICE_BY > 1
+    checksum[0] = checksum[1] = checksum[2] = 0xFFFF;
+    crc16CcittTables.update3(payload, length_bytes, checksum);
+#else
+    Crc16CCITT crc_all;
+    Crc16CCITT crc_even;
+    Crc16CCITT crc_odd;
+
+    for (size_t i = 0; i < length_bytes; ++i)
+    {
+        crc_all.update(payload[i]);
+        if (i & 0x1)
+        {
+            // odd index bytes
+            crc_odd.update(payload[i]);
+        }
+        else
+        {
+            // even index byte
+            crc_even.update(payload[i]);
+        }
+    }
+
+    checksum[0] = crc_all.get();
+    checksum[1] = crc_even.get();
+    checksum[2] = crc_odd.get();
+#endif
+}
+
 // static
 const uint8_t Crc8DallasMaxim::table256[256] =
 {
@@ -46,6 +46,22 @@
 /// Use the larger (faster) table by default.
 #define CRC16CCITT_TABLE_SIZE 256
 #endif
+#ifndef CRC_SLICE_BY
+#if (defined(__linux__) || defined(__MACH__) || defined(__WINNT__)) &&       \
+    __cplusplus >= 201402L
+/// How many bytes the bulk CRC-16 functions (crc_16_ibm, crc3_crc16_ibm,
+/// Crc16CCITT::crc, crc3_crc16_ccitt) process in one step. 4 or 8 uses
+/// slicing-by-N lookup tables (N * 512 bytes each, generated at compile
+/// time, needs C++14); 1 uses the byte-by-byte code and small tables. Hosts
+/// default to 8. On x86 CPUs with PCLMULQDQ, crc_16_ibm and
+/// Crc16CCITT::update fold long buffers with carry-less multiplication
+/// instead (detected at runtime).
+#define CRC_SLICE_BY 8
+#else
+/// Microcontrollers default to the small byte-by-byte implementation.
+#define CRC_SLICE_BY 1
+#endif
+#endif
 
 
 /** Computes the 16-bit CRC value over data using the CRC16-ANSI (aka
@@ -280,17 +296,19 @@ public:
 #endif
     }
 
+    /// Processes a block of the incoming message. Uses the slicing-by-N
+    /// tables if CRC_SLICE_BY is larger than 1.
+    /// @param data next bytes in the message.
+    /// @param length_bytes how long data is
+    void update(const void *data, size_t length_bytes);
+
     /// Computes the 16-bit CRC value over data
     /// @param data what to compute the checksum over
     /// @param length_bytes how long data is
     void crc(const void* data, size_t length_bytes)
     {
-        const uint8_t *payload = static_cast<const uint8_t*>(data);
         init();
-        for (size_t i = 0; i < length_bytes; ++i)
-        {
-            update(payload[i]);
-        }
+        update(data, length_bytes);
     }
 
 private:
@@ -322,33 +340,7 @@ private:
 /// @param data what to compute the checksum over
 /// @param length_bytes how long data is
 /// @param checksum is the output buffer where to store the 48-bit checksum.
-static inline void crc3_crc16_ccitt(
-    const void* data, size_t length_bytes, uint16_t checksum[3])
-{
-    const uint8_t* payload = static_cast<const uint8_t*>(data);
-
-    Crc16CCITT crc_all;
-    Crc16CCITT crc_even;
-    Crc16CCITT crc_odd;
-
-    for (size_t i = 0; i < length_bytes; ++i)
-    {
-        crc_all.update(payload[i]);
-        if (i & 0x1)
-        {
-            // odd index bytes
-            crc_odd.update(payload[i]);
-        }
-        else
-        {
-            // even index byte
-            crc_even.update(payload[i]);
-        }
-    }
-
-    checksum[0] = crc_all.get();
-    checksum[1] = crc_even.get();
-    checksum[2] = crc_odd.get();
-}
+void crc3_crc16_ccitt(
+    const void *data, size_t length_bytes, uint16_t checksum[3]);
 
 #endif // _UTILS_CRC_HXX_
\ No newline at end of file
@@ -41,11 +41,13 @@
 #if OPENMRN_FEATURE_BSD_SOCKETS
 
 #include "utils/DirectHub.hxx"
+#include "utils/DirectHubPorts.hxx"
 
 #include <algorithm>
 #include <vector>
 
 #include <fcntl.h>
+#include <string.h>
 
 #if OPENMRN_FEATURE_BSD_SOCKETS
 #include <sys/socket.h>
@@ -55,6 +57,8 @@
 #include "executor/AsyncNotifiableBlock.hxx"
 #include "executor/StateFlow.hxx"
 #include "nmranet_config.h"
+#include "os/OS.hxx"
+#include "utils/Hub.hxx"
 #include "utils/logging.h"
 #include "utils/socket_listener.hxx"
 
@@ -71,79 +75,459 @@ DataBufferPool g_direct_hub_kbyte_pool(1024);
 /// A single service class that is shared between all interconnected DirectHub
 /// instances. It is the responsibility of this Service to perform the locking
 /// of the individual flows.
+///
+/// The service is also the admission stage of the hub. Callers that cannot
+/// run right away are queued per traffic source, and the sources are served
+/// by deficit round-robin: each source has a credit (in bytes) that is charged
+/// after every message it sent, and refilled by
+/// config_directhub_admission_quantum() when the source gets its turn in the
+/// round. A source that ran out of credit is queued even if the hub is idle;
+/// this makes a flooding source yield the executor to the other sources
+/// without holding back anyone else.
+///
+/// All admission state is allocated in the constructor: there is a fixed
+/// table of config_directhub_admission_max_sources() source slots, and each
+/// slot has a ring of config_directhub_admission_source_backlog() waiting
+/// callers. A slot is released when its source was forgotten and its queue
+/// drained, or reused for a new source when it is the least recently active
+/// idle slot. When every slot has callers waiting, further sources share the
+/// anonymous slot.
 class DirectHubService : public Service
 {
 public:
-    typedef Q QueueType;
-
     DirectHubService(ExecutorBase *e)
         : Service(e)
         , busy_(0)
+        , sources_(config_directhub_admission_max_sources() + 1)
     {
-    }
-
-    /// @return lock object for the busy_ flag.
-    Atomic *lock()
-    {
-        return pendingSend_.lock();
+        // Slot 0 is the anonymous source, which is never released.
+        sources_[0].reset(nullptr);
     }
 
     /// Adds a caller to the waiting list of who wants to send traffic to the
     /// hub. If there is no waiting list, the caller will be executed inline.
     /// @param caller represents an entry point to the hub. It is required that
     /// caller finishes its run() by invoking on_done().
-    void enqueue_caller(Executable *caller)
+    /// @param source the traffic source on whose behalf the caller sends.
+    void enqueue_caller(Executable *caller, HubSource *source)
     {
+        long long now = os_get_time_monotonic();
+        bool schedule = false;
         {
-            AtomicHolder h(lock());
+            OSMutexLock h(&lock_);
+            SourceState *s = claim_source_locked(source, now);
             if (busy_)
             {
-                /// @todo there is a short period of priority inversion here,
-                /// because we insert an executable into a separate queue here
-                /// than the Executor. We dequeue the highest priority in
-                /// on_done(), but if that happens to be a low priority, that
-                /// might get stuck in the Executor for a long time, even if in
-                /// the meantime a higher priority message arrives here. A
-                /// better strategy would be to enqueue the Executable's in the
-                /// Service's executor directly instead of queueing them and
-                /// pushing them one by one to the Service's executor. In that
-                /// case we'd need a third state between busy and not busy:
-                /// whether we're queueing executable's or whether we're
-                /// dumping them into the executor. We would also need to keep
-                /// track of how many went to the Executor already, such that
-                /// we know when busy_ gets back to false.
-                pendingSend_.insert_locked(caller);
+                enqueue_locked(s, caller, now);
                 return;
             }
             busy_ = 1;
+            if (s->credit_ > 0)
+            {
+                current_ = s;
+                s->add_latency(0);
+            }
+            else
+            {
+                // Pushes back on this source: the caller gets scheduled on
+                // the executor, which lets other sources get in line.
+                ++s->numPushbacks_;
+                enqueue_locked(s, caller, now);
+                caller = take_next_locked(now);
+                schedule = true;
+            }
+        }
+        if (schedule)
+        {
+            executor()->add(caller, 0);
+        }
+        else
+        {
+            caller->run();
         }
-        caller->run();
     }
 
     /// This function must be called at the end of the enqueued functions in
     /// order to properly clear the busy flag or take out the next enqueued
     /// executable.
-    void on_done()
+    /// @param cost how many bytes the message just sent had.
+    void on_done(unsigned cost)
     {
         // De-queues the next entry.
-        Result deq;
+        Executable *next;
         {
-            AtomicHolder h(lock());
-            if (pendingSend_.empty())
+            OSMutexLock h(&lock_);
+            if (current_)
+            {
+                SourceState *s = current_;
+                current_ = nullptr;
+                s->credit_ -= cost;
+                release_if_done_locked(s);
+            }
+            if (!activeHead_)
             {
                 busy_ = 0;
                 return;
             }
-            deq = pendingSend_.next();
+            next = take_next_locked(os_get_time_monotonic());
         }
         // Schedules it on the executor.
-        executor()->add(static_cast<Executable *>(deq.item), deq.index);
+        executor()->add(next, 0);
+    }
+
+    /// Drops the state of a traffic source. If the source still has callers
+    /// waiting, its slot is released when the last of them is done.
+    /// @param source the traffic source that will not send anything anymore.
+    void forget_source(HubSource *source)
+    {
+        OSMutexLock h(&lock_);
+        SourceState *s = find_source_locked(source);
+        if (s && s != &sources_[0])
+        {
+            s->forgotten_ = true;
+            release_if_done_locked(s);
+        }
+    }
+
+    /// Fills in the statistics of a traffic source.
+    /// @param source the traffic source.
+    /// @param stats output argument.
+    /// @return false if the source is not known.
+    bool get_stats(HubSource *source, DirectHubSourceStats *stats)
+    {
+        OSMutexLock h(&lock_);
+        SourceState *s = find_source_locked(source);
+        if (!s)
+        {
+            return false;
+        }
+        s->fill_stats(stats);
+        return true;
+    }
+
+private:
+    /// Number of buckets in the latency histogram.
+    static constexpr unsigned LATENCY_BUCKETS = 32;
+
+    /// @return how many bytes of credit a source gets in every round. At
+    /// least one, otherwise take_next_locked() would never find a source
+    /// with credit.
+    static int32_t admission_quantum()
+    {
+        return std::max(config_directhub_admission_quantum(), 1);
+    }
+
+    /// A caller waiting for its turn, with the time it arrived.
+    struct PendingEntry
+    {
+        Executable *caller_;
+        long long time_;
+    };
+
+    /// Admission and queueing state of a single traffic source.
+    struct SourceState
+    {
+        SourceState()
+            : ring_(config_directhub_admission_source_backlog())
+        {
+        }
+
+        /// Puts this slot into use for a given source.
+        /// @param source the traffic source.
+        void reset(HubSource *source)
+        {
+            HASSERT(ringCount_ == 0);
+            source_ = source;
+            used_ = true;
+            forgotten_ = false;
+            credit_ = admission_quantum();
+            numSends_ = 0;
+            numPushbacks_ = 0;
+            maxLatencyUsec_ = 0;
+            memset(latencyBuckets_, 0, sizeof(latencyBuckets_));
+        }
+
+        /// Adds a caller to the end of the waiting list. Callers that do not
+        /// fit in the ring are parked in the overflow queue.
+        /// @param caller the caller
+        /// @param now current time (nsec)
+        void push(Executable *caller, long long now)
+        {
+            if (ringCount_ < ring_.size())
+            {
+                ring_[(ringHead_ + ringCount_) % ring_.size()] = {caller, now};
+                ++ringCount_;
+            }
+            else
+            {
+                if (overflow_.empty())
+                {
+                    overflowTime_ = now;
+                }
+                overflow_.insert(caller);
+            }
+        }
+
+        /// Takes out the first waiting caller. Must not be called when
+        /// ringCount_ is zero.
+        /// @return the first caller and the time it arrived.
+        PendingEntry pop()
+        {
+            PendingEntry ret = ring_[ringHead_];
+            ringHead_ = (ringHead_ + 1) % ring_.size();
+            --ringCount_;
+            if (!overflow_.empty())
+            {
+                push(static_cast<Executable *>(overflow_.next(0)),
+                    overflowTime_);
+            }
+            return ret;
+        }
+
+        /// Records the queueing latency of one message.
+        /// @param nsec how long the caller was waiting.
+        void add_latency(long long nsec)
+        {
+            uint32_t usec = nsec / 1000;
+            unsigned bucket = usec ? 32 - __builtin_clz(usec) : 0;
+            if (bucket >= LATENCY_BUCKETS)
+            {
+                bucket = LATENCY_BUCKETS - 1;
+            }
+            ++latencyBuckets_[bucket];
+            maxLatencyUsec_ = std::max(maxLatencyUsec_, usec);
+            ++numSends_;
+        }
+
+        /// @return the upper bound of the latency histogram bucket (in usec)
+        /// that contains the given percentile.
+        /// @param pct percentile, 0..100.
+        uint32_t percentile(unsigned pct)
+        {
+            uint64_t needed = ((uint64_t)numSends_ * pct + 99) / 100;
+            uint64_t seen = 0;
+            for (unsigned i = 0; i < LATENCY_BUCKETS; ++i)
+            {
+                seen += latencyBuckets_[i];
+                if (seen >= needed && seen > 0)
+                {
+                    return std::min(1u << i, maxLatencyUsec_);
+                }
+            }
+            return maxLatencyUsec_;
+        }
+
+        /// Exports the statistics.
+        /// @param stats output argument.
+        void fill_stats(DirectHubSourceStats *stats)
+        {
+            stats->numSends = numSends_;
+            stats->numPushbacks = numPushbacks_;
+            stats->latencyP50Usec = percentile(50);
+            stats->latencyP90Usec = percentile(90);
+            stats->latencyP99Usec = percentile(99);
+            stats->latencyMaxUsec = maxLatencyUsec_;
+        }
+
+        /// Callers waiting for their turn. Allocated in the constructor.
+        std::vector<PendingEntry> ring_;
+        /// Callers that did not fit in ring_. These are linked through their
+        /// QMember, so this needs no memory from the hub.
+        Q overflow_;
+        /// Arrival time (nsec) of the first caller that went to overflow_.
+        /// There is no room to store the arrival time of each caller in
+        /// overflow_, so all of them are charged from this time when they
+        /// move to the ring. Their latency may be overestimated by the time
+        /// between arrivals, but it is never undercounted.
+        long long overflowTime_ = 0;
+        /// Index of the first waiting caller in ring_.
+        unsigned ringHead_ = 0;
+        /// Number of waiting callers in ring_.
+        unsigned ringCount_ = 0;
+        /// Next source in the round-robin list.
+        SourceState *nextActive_ = nullptr;
+        /// The traffic source this slot belongs to.
+        HubSource *source_ = nullptr;
+        /// When this source last tried to send (nsec).
+        long long lastActive_ = 0;
+        /// How many bytes this source may still send before yielding to
+        /// other sources.
+        int32_t credit_ = 0;
+        /// True if this slot belongs to a source.
+        bool used_ = false;
+        /// True if the slot shall be released once the queue drained.
+        bool forgotten_ = false;
+        /// True if this source is in the round-robin list.
+        bool active_ = false;
+        /// Number of messages sent.
+        uint32_t numSends_ = 0;
+        /// Number of times this source was queued for running out of credit.
+        uint32_t numPushbacks_ = 0;
+        /// Largest queueing latency in usec.
+        uint32_t maxLatencyUsec_ = 0;
+        /// Bucket i counts the latencies in [2^(i-1), 2^i) usec.
+        uint32_t latencyBuckets_[LATENCY_BUCKETS] = {0};
+    };
+
+    /// Looks up the slot of a source. Must be called with the lock held.
+    /// @param source the traffic source, nullptr for the anonymous source.
+    /// @return the slot of this source or nullptr if it has none.
+    SourceState *find_source_locked(HubSource *source)
+    {
+        if (!source)
+        {
+            return &sources_[0];
+        }
+        for (unsigned i = 1; i < sources_.size(); ++i)
+        {
+            if (sources_[i].used_ && sources_[i].source_ == source)
+            {
+                return &sources_[i];
+            }
+        }
+        return nullptr;
+    }
+
+    /// Looks up the slot of a source, and assigns one if the source has none
+    /// yet. Must be called with the lock held.
+    /// @param source the traffic source, nullptr for the anonymous source.
+    /// @param now current time (nsec).
+    /// @return the slot to queue the caller of this source on.
+    SourceState *claim_source_locked(HubSource *source, long long now)
+    {
+        SourceState *s = find_source_locked(source);
+        if (!s)
+        {
+            // Takes a free slot, or else the least recently active idle one.
+            for (unsigned i = 1; i < sources_.size(); ++i)
+            {
+                SourceState *c = &sources_[i];
+                if (!c->used_)
+                {
+                    s = c;
+                    break;
+                }
+                if (c->ringCount_ == 0 && c != current_ &&
+                    (!s || c->lastActive_ < s->lastActive_))
+                {
+                    s = c;
+                }
+            }
+            if (s)
+            {
+                s->reset(source);
+            }
+            else
+            {
+                // All slots have callers waiting.
+                s = &sources_[0];
+            }
+        }
+        s->lastActive_ = now;
+        return s;
+    }
+
+    /// Adds a caller to the waiting list of a source, and puts the source
+    /// into the round-robin if it was not there yet. Must be called with the
+    /// lock held.
+    /// @param s the source slot.
+    /// @param caller the caller.
+    /// @param now current time (nsec).
+    void enqueue_locked(SourceState *s, Executable *caller, long long now)
+    {
+        s->push(caller, now);
+        if (!s->active_)
+        {
+            s->active_ = true;
+            append_active_locked(s);
+        }
+    }
+
+    /// Adds a source to the end of the round-robin list. Must be called with
+    /// the lock held.
+    /// @param s the source slot.
+    void append_active_locked(SourceState *s)
+    {
+        s->nextActive_ = nullptr;
+        if (activeTail_)
+        {
+            activeTail_->nextActive_ = s;
+        }
+        else
+        {
+            activeHead_ = s;
+        }
+        activeTail_ = s;
+    }
+
+    /// Removes the first source from the round-robin list. Must be called
+    /// with the lock held.
+    /// @return the removed source.
+    SourceState *pop_active_locked()
+    {
+        SourceState *s = activeHead_;
+        activeHead_ = s->nextActive_;
+        if (!activeHead_)
+        {
+            activeTail_ = nullptr;
+        }
+        s->nextActive_ = nullptr;
+        return s;
     }
 
+    /// Releases the slot of a forgotten source if nothing of it is queued or
+    /// running anymore. Must be called with the lock held.
+    /// @param s the source slot.
+    void release_if_done_locked(SourceState *s)
+    {
+        if (s->forgotten_ && s->ringCount_ == 0 && s != current_)
+        {
+            s->used_ = false;
+            s->source_ = nullptr;
+        }
+    }
+
+    /// Takes out the next waiting caller according to the round-robin. Must
+    /// be called with the lock held and at least one source waiting.
+    /// @param now current time (nsec)
+    /// @return the caller to schedule on the executor.
+    Executable *take_next_locked(long long now)
+    {
+        const int32_t quantum = admission_quantum();
+        while (true)
+        {
+            SourceState *s = activeHead_;
+            if (s->credit_ <= 0)
+            {
+                // This source has used up its share for this round.
+                s->credit_ = std::min(s->credit_ + quantum, quantum);
+                append_active_locked(pop_active_locked());
+                continue;
+            }
+            PendingEntry next = s->pop();
+            if (s->ringCount_ == 0)
+            {
+                pop_active_locked();
+                s->active_ = false;
+            }
+            s->add_latency(now - next.time_);
+            current_ = s;
+            return next.caller_;
+        }
+    }
+
+    /// Protects all admission state below.
+    OSMutex lock_;
     /// 1 if there is any message being processed right now.
     unsigned busy_ : 1;
-    /// List of callers that are waiting for the busy_ lock.
-    QueueType pendingSend_;
+    /// The source whose message is being processed right now.
+    SourceState *current_ = nullptr;
+    /// First source in the round-robin list of sources with callers waiting.
+    SourceState *activeHead_ = nullptr;
+    /// Last source in the round-robin list.
+    SourceState *activeTail_ = nullptr;
+    /// Fixed table of source slots. Slot 0 is the anonymous source.
+    std::vector<SourceState> sources_;
 };
 
 template <class T>
@@ -188,20 +572,48 @@ public:
     {
         // By enqueueing on the service we ensure that the state flow is not
         // processing any packets while the code below is running.
-        service()->enqueue_caller(new CallbackExecutable([this, port, done]() {
-            {
-                AtomicHolder h(this);
-                ports_.erase(std::remove(ports_.begin(), ports_.end(), port),
-                    ports_.end());
-            }
-            done->notify();
-            service()->on_done();
-        }));
+        service()->enqueue_caller(
+            new CallbackExecutable([this, port, done]() {
+                {
+                    AtomicHolder h(this);
+                    ports_.erase(
+                        std::remove(ports_.begin(), ports_.end(), port),
+                        ports_.end());
+                }
+                service()->forget_source(port);
+                done->notify();
+                service()->on_done(0);
+            }),
+            nullptr);
     }
 
     void enqueue_send(Executable *caller) override
     {
-        service()->enqueue_caller(caller);
+        service()->enqueue_caller(caller, nullptr);
+    }
+
+    void enqueue_send(Executable *caller, HubSource *source) override
+    {
+        service()->enqueue_caller(caller, source);
+    }
+
+    bool get_source_stats(
+        HubSource *source, DirectHubSourceStats *stats) override
+    {
+        return service()->get_stats(source, stats);
+    }
+
+    bool has_recipients(HubSource *source) override
+    {
+        AtomicHolder h(this);
+        for (auto *p : ports_)
+        {
+            if (static_cast<HubSource *>(p) != source)
+            {
+                return true;
+            }
+        }
+        return false;
     }
 
     MessageAccessor<T> *mutable_message() override
@@ -230,8 +642,9 @@ public:
                 p->send(&msg_);
             }
         }
+        unsigned cost = message_cost(&msg_);
         msg_.clear();
-        service()->on_done();
+        service()->on_done(cost);
     }
 
     /// Filters a message going towards a specific output port.
@@ -248,6 +661,24 @@ private:
         return static_cast<DirectHubService *>(StateFlowBase::service());
     }
 
+    /// @return how much admission credit a message costs; for typed messages
+    /// this is the size of the payload object. The credit is counted in
+    /// bytes for every hub type, so that config_directhub_admission_quantum()
+    /// means about the same amount of traffic on a CAN frame hub (16 to 21
+    /// frames, depending on the pointer size) as on a gridconnect hub (about
+    /// 18 packets).
+    template <class U> static unsigned message_cost(MessageAccessor<U> *msg)
+    {
+        return sizeof(U);
+    }
+
+    /// @return how much admission credit a message costs; for byte streams
+    /// this is the number of bytes.
+    static unsigned message_cost(MessageAccessor<uint8_t[]> *msg)
+    {
+        return msg->buf_.size();
+    }
+
     /// Stores the registered output ports. Protected by Atomic *this.
     std::vector<DirectHubPort<T> *> ports_;
 
@@ -263,21 +694,28 @@ DirectHubInterface<uint8_t[]> *create_hub(ExecutorBase *e)
     return dh;
 }
 
+CanDirectHubInterface *create_can_hub(ExecutorBase *e)
+{
+    auto *s = new DirectHubService(e);
+    return new DirectHubImpl<CanHubData>(s);
+}
+
 /// Connects a (bytes typed) hub to an FD. This state flow is the write flow;
 /// i.e., it waits for messages coming from the hub and writes them into the fd.
 /// The object is self-owning, i.e. will delete itself when the input goes dead
 /// or when the port is shutdown (eventually).
 class DirectHubPortSelect : public DirectHubPort<uint8_t[]>,
+                            public DirectHubSelectPortBase,
                             private StateFlowBase
 {
 private:
     /// State flow that reads the FD and sends the read data to the direct hub.
-    class DirectHubReadFlow : public StateFlowBase
+    class DirectHubReadFlow : public DirectHubSelectReadFlowBase
     {
     public:
         DirectHubReadFlow(DirectHubPortSelect *parent,
             std::unique_ptr<MessageSegmenter> segmenter)
-            : StateFlowBase(parent->service())
+            : DirectHubSelectReadFlowBase(parent->service())
             , parent_(parent)
             , segmenter_(std::move(segmenter))
         {
@@ -290,57 +728,20 @@ private:
             start_flow(STATE(alloc_for_read));
         }
 
-        /// Requests the read port to shut down. Must be called on the main
-        /// executor. Causes the flow to notify the parent via the
-        /// read_flow_exit() function then terminate, either inline or not.
-        void read_shutdown()
-        {
-            auto *e = this->service()->executor();
-            if (e->is_selected(&helper_))
-            {
-                // We're waiting in select on reads, we can cancel right now.
-                e->unselect(&helper_);
-                set_terminated();
-                buf_.reset();
-                /// @todo We should first clean up the async notifiable block
-                /// and only signal the exit afterwards.
-                parent_->read_flow_exit();
-            }
-            // Else we're waiting for the regular progress to wake up the
-            // flow. It will check fd_ < 0 to exit.
-        }
-
     private:
-        /// Root of the read flow. Starts with getting the barrier notifiable,
-        /// either synchronously if one is available, or asynchronously.
-        Action alloc_for_read()
+        /// Called by read_shutdown() when the pending read was cancelled.
+        /// Notifies the parent via the read_flow_exit() function.
+        void read_cancelled() override
         {
-            QMember *bn = pendingLimiterPool_.next().item;
-            if (bn)
-            {
-                bufferNotifiable_ = pendingLimiterPool_.initialize(bn);
-                return get_read_buffer();
-            }
-            else
-            {
-                pendingLimiterPool_.next_async(this);
-                return wait_and_call(STATE(barrier_allocated));
-            }
-        }
-
-        /// Intermediate step if asynchronous allocation was necessary for the
-        /// read barrier.
-        Action barrier_allocated()
-        {
-            QMember *bn;
-            cast_allocation_result(&bn);
-            HASSERT(bn);
-            bufferNotifiable_ = pendingLimiterPool_.initialize(bn);
-            return get_read_buffer();
+            set_terminated();
+            buf_.reset();
+            /// @todo We should first clean up the async notifiable block
+            /// and only signal the exit afterwards.
+            parent_->read_flow_exit();
         }
 
         /// Invoked when we have a bufferNotifiable_ from the barrier pool.
-        Action get_read_buffer()
+        Action barrier_ready() override
         {
             DataBuffer *p;
             LOG(VERBOSE, "read flow %p (fd %d): notif %p alloc() %u", this,
@@ -448,7 +849,7 @@ private:
             wait_and_call(STATE(send_callback));
             inlineCall_ = 1;
             sendComplete_ = 0;
-            parent_->hub_->enqueue_send(this); // causes the callback
+            parent_->hub_->enqueue_send(this, parent_); // causes the callback
             inlineCall_ = 0;
             if (sendComplete_)
             {
@@ -511,20 +912,12 @@ private:
 
         /// Current buffer that we are filling.
         LinkedDataBufferPtr buf_;
-        /// Barrier notifiable to keep track of the buffer's contents.
-        BarrierNotifiable *bufferNotifiable_;
         /// Output of the last segmenter call.
         ssize_t segmentSize_;
         /// 1 if we got the send callback inline from the read_done.
         uint16_t inlineCall_ : 1;
         /// 1 if the run callback actually happened inline.
         uint16_t sendComplete_ : 1;
-        /// Pool of BarrierNotifiables that limit the amount of inflight bytes
-        /// we have.
-        AsyncNotifiableBlock pendingLimiterPool_ {
-            (unsigned)config_directhub_port_max_incoming_packets()};
-        /// Helper object for Select.
-        StateFlowSelectHelper helper_ {this};
         /// Pointer to the owninng port.
         DirectHubPortSelect *parent_;
         /// Implementation (and state) of the business logic that segments
@@ -538,21 +931,11 @@ public:
     DirectHubPortSelect(DirectHubInterface<uint8_t[]> *hub, int fd,
         std::unique_ptr<MessageSegmenter> segmenter,
         Notifiable *on_error = nullptr)
-        : StateFlowBase(hub->get_service())
+        : DirectHubSelectPortBase(fd, on_error)
+        , StateFlowBase(hub->get_service())
         , readFlow_(this, std::move(segmenter))
-        , readFlowPending_(1)
-        , writeFlowPending_(1)
         , hub_(hub)
-        , fd_(fd)
-        , onError_(on_error)
-    {
-#ifdef __WINNT__
-        unsigned long par = 1;
-        ioctlsocket(fd_, FIONBIO, &par);
-#else
-        ::fcntl(fd, F_SETFL, O_RDWR | O_NONBLOCK);
-#endif
-
+    {
         // Sets the initial state of the write flow to the stage where we read
         // the next entry from the queue.
         wait_and_call(STATE(read_queue));
@@ -738,18 +1121,7 @@ private:
     /// flow needs to exit separately.
     void report_write_error()
     {
-        int close_fd = -1;
-        {
-            AtomicHolder h(lock());
-            if (fd_ >= 0)
-            {
-                std::swap(fd_, close_fd);
-            }
-        }
-        if (close_fd >= 0)
-        {
-            ::close(close_fd);
-        }
+        close_fd();
         readFlow_.read_shutdown();
     }
 
@@ -759,18 +1131,7 @@ private:
     /// Called on the main executor.
     void report_read_error()
     {
-        int close_fd = -1;
-        {
-            AtomicHolder h(lock());
-            if (fd_ >= 0)
-            {
-                std::swap(fd_, close_fd);
-            }
-        }
-        if (close_fd >= 0)
-        {
-            ::close(close_fd);
-        }
+        close_fd();
         // take read barrier
         read_flow_exit();
         // kill write flow
@@ -792,44 +1153,6 @@ private:
         flow_exit(false);
     }
 
-    /// Marks a flow to be exited, and once both are exited, notifies done and
-    /// deletes this.
-    /// @param read if true, marks the read flow done, if false, marks the write
-    /// flow done.
-    void flow_exit(bool read)
-    {
-        bool del = false;
-        {
-            AtomicHolder h(lock());
-            if (read)
-            {
-                readFlowPending_ = 0;
-            }
-            else
-            {
-                writeFlowPending_ = 0;
-            }
-            if (writeFlowPending_ == 0 && readFlowPending_ == 0)
-            {
-                del = true;
-            }
-        }
-        if (del)
-        {
-            if (onError_)
-            {
-                onError_->notify();
-            }
-            delete this;
-        }
-    }
-
-    /// @return lock usable for the write flow and the port altogether.
-    Atomic *lock()
-    {
-        return pendingQueue_.lock();
-    }
-
     /// Holds the necessary information we need to keep in the queue about a
     /// single output entry. Automatically unrefs the buffer whose pointer we
     /// are holding when released.
@@ -842,8 +1165,6 @@ private:
 
     /// Type of buffers we are enqueuing for output.
     typedef Buffer<OutputDataEntry> BufferType;
-    /// Type of the queue used to keep the output buffer queue.
-    typedef Q QueueType;
 
     /// total number of bytes written to the port.
     size_t totalWritten_ {0};
@@ -861,8 +1182,6 @@ private:
     /// Time when the last buffer flush has happened. Not used yet.
     // long long lastWriteTimeNsec_ = 0;
 
-    /// Contains buffers of OutputDataEntries to write.
-    QueueType pendingQueue_;
     /// Last tail pointer in the pendingQueue. If queue is empty,
     /// nullptr. Protected by pendingQueue_.lock().
     OutputDataEntry *pendingTail_ = nullptr;
@@ -870,16 +1189,8 @@ private:
     size_t totalPendingSize_ = 0;
     /// 1 if the state flow is paused, waiting for the notification.
     uint8_t notRunning_ : 1;
-    /// 1 if the read flow is still running.
-    uint8_t readFlowPending_;
-    /// 1 if the write flow is still running.
-    uint8_t writeFlowPending_;
     /// Parent hub where output data is coming from.
     DirectHubInterface<uint8_t[]> *hub_;
-    /// File descriptor for input/output.
-    int fd_;
-    /// This notifiable will be called before exiting.
-    Notifiable *onError_ = nullptr;
 };
 
 extern DirectHubPortSelect *g_last_direct_hub_port;
@@ -161,6 +161,27 @@ public:
     virtual void send(MessageAccessor<T> *msg) = 0;
 };
 
+/// Queueing statistics of a single traffic source of a hub. Latencies are
+/// measured from the enqueue_send() call until the hub starts executing the
+/// caller. They come from a histogram with power-of-two buckets; the reported
+/// value is the upper bound of the bucket.
+struct DirectHubSourceStats
+{
+    /// How many messages this source has sent to the hub.
+    uint32_t numSends;
+    /// How many times this source was queued because it ran out of credit,
+    /// even though the hub was otherwise idle.
+    uint32_t numPushbacks;
+    /// Median queueing latency in microseconds.
+    uint32_t latencyP50Usec;
+    /// 90th percentile queueing latency in microseconds.
+    uint32_t latencyP90Usec;
+    /// 99th percentile queueing latency in microseconds.
+    uint32_t latencyP99Usec;
+    /// Largest queueing latency seen in microseconds.
+    uint32_t latencyMaxUsec;
+};
+
 /// Interface for a the central part of a hub.
 template <class T> class DirectHubInterface : public Destructable
 {
@@ -189,6 +210,18 @@ public:
     /// to call do_send() inline.
     virtual void enqueue_send(Executable *caller) = 0;
 
+    /// Signals that the caller wants to send a message to the hub on behalf
+    /// of a given traffic source. Callers of the same source are executed in
+    /// the order of the calls. Between different sources the hub performs
+    /// fair queueing: each source may send a limited number of bytes
+    /// (config_directhub_admission_quantum()) before other waiting sources
+    /// get their turn. A source that ran out of credit is queued even if the
+    /// hub is idle, which makes it yield the executor to other sources.
+    /// @param caller callback that actually sends the message. It is required
+    /// to call do_send() inline.
+    /// @param source identifies the traffic source, typically the input port.
+    virtual void enqueue_send(Executable *caller, HubSource *source) = 0;
+
     /// Accessor to fill in the message payload. Must be called only from
     /// within the callback as invoked by enqueue_send.
     /// @return mutable structure to fill in the message. This structure was
@@ -198,6 +231,20 @@ public:
     /// Sends a message to the hub. Before this is called, the message has to
     /// be filled in via mutable_message().
     virtual void do_send() = 0;
+
+    /// Fetches the queueing statistics of a traffic source.
+    /// @param source the traffic source, as given to enqueue_send().
+    /// @param stats will be filled in with the statistics.
+    /// @return false if this source has not sent anything to the hub.
+    virtual bool get_source_stats(
+        HubSource *source, DirectHubSourceStats *stats) = 0;
+
+    /// Checks whether a message would be delivered anywhere. Bridges use this
+    /// to skip converting messages that nobody would receive.
+    /// @param source the port that would be sending the message.
+    /// @return true if there is at least one port registered other than
+    /// source.
+    virtual bool has_recipients(HubSource *source) = 0;
 };
 
 typedef DirectHubInterface<uint8_t[]> ByteDirectHubInterface;
@@ -234,6 +281,12 @@ MessageSegmenter *create_gc_message_segmenter();
 /// @return a newly allocated message segmenter.
 MessageSegmenter *create_trivial_message_segmenter();
 
+/// Creates a message segmenter for the native OpenLCB-TCP protocol. The
+/// implementation is in openlcb/DirectHubTcp.cxx.
+/// @return a newly allocated message segmenter that chops binary OpenLCB-TCP
+/// messages off of a data stream.
+MessageSegmenter *create_tcp_message_segmenter();
+
 // Forward declarations to avoid needing to include Hub.hxx here.
 template <class T> class GenericHubFlow;
 template <class T> class HubContainer;
@@ -249,4 +302,46 @@ typedef GenericHubFlow<CanHubData> CanHubFlow;
 Destructable *create_gc_to_legacy_can_bridge(
     DirectHubInterface<uint8_t[]> *gc_hub, CanHubFlow *can_hub);
 
+/// DirectHub carrying binary CAN frames. Each message is a Buffer<CanHubData>
+/// that is shared between all output ports.
+typedef DirectHubInterface<CanHubData> CanDirectHubInterface;
+
+/// Creates a new CAN frame typed hub.
+CanDirectHubInterface *create_can_hub(ExecutorBase *e);
+
+/// Creates a hub port of CAN frame type reading/writing a given fd. The fd has
+/// to transfer whole struct can_frame objects, such as a SocketCAN socket or
+/// an OpenMRN CAN device. This port will be automatically deleted upon any
+/// error reading/writing the fd (unregistered and memory released).
+/// @param hub hub instance on which to register the new port. Ownership
+/// retained by caller.
+/// @param fd where to read and write CAN frames.
+/// @param on_error this will be notified if the port closes due to an error.
+void create_port_for_can_fd(
+    CanDirectHubInterface *hub, int fd, Notifiable *on_error = nullptr);
+
+/// Creates a bridge between a gridconnect-based DirectHub and a CAN frame
+/// typed DirectHub. Packets are converted only when the other hub has a port
+/// to receive them, and the conversion happens once per packet; all ports of
+/// the other hub share the converted packet.
+/// @param gc_hub the gridconnect hub.
+/// @param can_hub the CAN frame hub.
+/// @return an object that can be deleted (only outside the main executor).
+Destructable *create_gc_to_can_bridge(
+    ByteDirectHubInterface *gc_hub, CanDirectHubInterface *can_hub);
+
+/// Creates a bridge between a DirectHub carrying native OpenLCB-TCP messages
+/// (see create_tcp_message_segmenter()) and a CAN frame typed DirectHub. The
+/// bridge contains an OpenLCB CAN interface that allocates aliases for the
+/// nodes on the TCP side, and splits and reassembles the multi-frame
+/// messages. Stream messages are not bridged. The implementation is in
+/// openlcb/DirectHubTcp.cxx.
+/// @param tcp_hub the OpenLCB-TCP hub.
+/// @param can_hub the CAN frame hub. The bridge runs on its executor.
+/// @param gateway_node_id node ID of the bridge. It is put into the gateway
+/// field of the TCP messages, and used as the source of alias lookups.
+/// @return an object that can be deleted (only outside the main executor).
+Destructable *create_tcp_to_can_bridge(ByteDirectHubInterface *tcp_hub,
+    CanDirectHubInterface *can_hub, uint64_t gateway_node_id);
+
 #endif // _UTILS_DIRECTHUB_HXX_
@@ -0,0 +1,330 @@
+/** \copyright
+ * Copyright (c) 2026, OpenMRN contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file DirectHubBridge.cxx
+ *
+ * Bridge between a gridconnect typed DirectHub and a CAN frame typed
+ * DirectHub.
+ *
+ * @author OpenMRN contributors
+ * @date 17 Oct 2026
+ */
+
+#include "utils/DirectHub.hxx"
+
+#include "executor/StateFlow.hxx"
+#include "utils/DirectHubPorts.hxx"
+#include "utils/Hub.hxx"
+#include "utils/gc_format.h"
+
+extern DataBufferPool g_direct_hub_kbyte_pool;
+
+/// Bridge between a gridconnect DirectHub and a CAN frame DirectHub. The
+/// bridge registers one port on each hub. A packet arriving from one hub is
+/// converted only if the other hub has any port besides the bridge, and it is
+/// converted exactly once; the other hub then shares the converted buffer
+/// between all of its output ports.
+///
+/// Sending into the other hub happens through a queue in this object, so
+/// that the two hubs never have to wait for each other.
+class GcCanBridge : public Destructable
+{
+public:
+    /// Constructor.
+    /// @param gc_hub the gridconnect hub.
+    /// @param can_hub the CAN frame hub.
+    GcCanBridge(ByteDirectHubInterface *gc_hub, CanDirectHubInterface *can_hub)
+        : gcHub_(gc_hub)
+        , canHub_(can_hub)
+        , gcPort_(this)
+        , canPort_(this)
+        , toGc_(this)
+        , toCan_(this)
+    {
+        gcHub_->register_port(&gcPort_);
+        canHub_->register_port(&canPort_);
+    }
+
+    ~GcCanBridge()
+    {
+        gcHub_->unregister_port(&gcPort_);
+        canHub_->unregister_port(&canPort_);
+    }
+
+private:
+    /// Port on the gridconnect hub. Parses the text packets into CAN frames.
+    class GcPort : public DirectHubPort<uint8_t[]>
+    {
+    public:
+        /// @param parent the owning bridge.
+        GcPort(GcCanBridge *parent)
+            : parent_(parent)
+        {
+        }
+
+        /// GC to binary path. Called by the gridconnect hub with a text packet
+        /// or a garbage packet.
+        void send(MessageAccessor<uint8_t[]> *msg) override
+        {
+            if (!parent_->canHub_->has_recipients(&parent_->canPort_))
+            {
+                // Nobody would receive the converted packet.
+                return;
+            }
+            auto &buf = msg->buf_;
+            uint8_t *p;
+            unsigned available;
+            buf.head()->get_read_pointer(buf.skip(), &p, &available);
+            if (buf.size() == 0 || *p != ':')
+            {
+                // Not a gridconnect packet. Do not do anything.
+                return;
+            }
+            const char *text_packet = nullptr;
+            string assembled_packet;
+            if (available >= buf.size())
+            {
+                // One block of data. Convert in place.
+                text_packet = (const char *)p;
+            }
+            else
+            {
+                buf.append_to(&assembled_packet);
+                text_packet = assembled_packet.c_str();
+            }
+            Buffer<CanHubData> *can_buf;
+            mainBufferPool->alloc(&can_buf);
+            if (gc_format_parse(text_packet, can_buf->data()) < 0)
+            {
+                string debug(text_packet, buf.size());
+                LOG(INFO, "Failed to parse gridconnect packet: '%s'",
+                    debug.c_str());
+                can_buf->unref();
+                return;
+            }
+            if (msg->done_)
+            {
+                can_buf->set_done(msg->done_->new_child());
+            }
+            parent_->toCan_.send(can_buf);
+        }
+
+    private:
+        /// Owning bridge.
+        GcCanBridge *parent_;
+    };
+
+    /// Port on the CAN frame hub. Hands the frames to the rendering flow.
+    class CanPort : public DirectHubPort<CanHubData>
+    {
+    public:
+        /// @param parent the owning bridge.
+        CanPort(GcCanBridge *parent)
+            : parent_(parent)
+        {
+        }
+
+        /// Binary to GC path. Called by the CAN hub with a frame.
+        void send(MessageAccessor<CanHubData> *msg) override
+        {
+            if (!parent_->gcHub_->has_recipients(&parent_->gcPort_))
+            {
+                // Nobody would receive the rendered packet.
+                return;
+            }
+            parent_->toGc_.send(CanFrameRef::create(msg));
+        }
+
+    private:
+        /// Owning bridge.
+        GcCanBridge *parent_;
+    };
+
+    /// Flow that renders CAN frames into gridconnect format and sends them to
+    /// the gridconnect hub.
+    class ToGcFlow : public StateFlow<Buffer<CanFrameRef>, QList<1>>
+    {
+    public:
+        /// @param parent the owning bridge.
+        ToGcFlow(GcCanBridge *parent)
+            : StateFlow<Buffer<CanFrameRef>, QList<1>>(
+                  parent->gcHub_->get_service())
+            , parent_(parent)
+        {
+        }
+
+        /// Handles the next CAN frame that we need to send.
+        Action entry() override
+        {
+            // Allocates output buffer if needed.
+            if (buf_.free() < MIN_GC_FREE)
+            {
+                // Need more output buffer.
+                DataBuffer *b;
+                g_direct_hub_kbyte_pool.alloc(&b);
+                buf_.append_empty_buffer(b);
+            }
+            // Generates gridconnect message and commits to buffer.
+            char *start = (char *)buf_.data_write_pointer();
+            char *end =
+                gc_format_generate(&message()->data()->frame(), start, 0);
+            packetSize_ = end - start;
+            buf_.data_write_advance(packetSize_);
+            pktDone_ = message()->new_child();
+            release();
+            // Sends off output message.
+            wait_and_call(STATE(do_send));
+            inlineRun_ = true;
+            inlineComplete_ = false;
+            parent_->gcHub_->enqueue_send(this, &parent_->gcPort_);
+            inlineRun_ = false;
+            if (inlineComplete_)
+            {
+                return exit();
+            }
+            else
+            {
+                return wait();
+            }
+        }
+
+        /// Handles the callback from the gridconnect hub when it is ready for
+        /// us to send the message.
+        Action do_send()
+        {
+            auto *m = parent_->gcHub_->mutable_message();
+            m->buf_ = buf_.transfer_head(packetSize_);
+            m->source_ = &parent_->gcPort_;
+            m->done_ = pktDone_;
+            parent_->gcHub_->do_send();
+            if (inlineRun_)
+            {
+                inlineComplete_ = true;
+                return wait();
+            }
+            else
+            {
+                return exit();
+            }
+        }
+
+    private:
+        /// Minimum amount of free bytes in the current send buffer in order to
+        /// use it for gridconnect rendering.
+        static constexpr unsigned MIN_GC_FREE = 29;
+        /// Owning bridge.
+        GcCanBridge *parent_;
+        /// Output buffer of gridconnect bytes.
+        LinkedDataBufferPtr buf_;
+        /// Done notifiable from the source packet.
+        BarrierNotifiable *pktDone_ = nullptr;
+        /// True while we are calling the target hub send method.
+        bool inlineRun_ : 1;
+        /// True if the send completed inline.
+        bool inlineComplete_ : 1;
+        /// Number of bytes this gridconnect packet is.
+        uint16_t packetSize_;
+    };
+
+    /// Flow that sends parsed CAN frames to the CAN hub.
+    class ToCanFlow : public StateFlow<Buffer<CanHubData>, QList<1>>
+    {
+    public:
+        /// @param parent the owning bridge.
+        ToCanFlow(GcCanBridge *parent)
+            : StateFlow<Buffer<CanHubData>, QList<1>>(
+                  parent->canHub_->get_service())
+            , parent_(parent)
+        {
+        }
+
+        /// Handles the next CAN frame that we need to send.
+        Action entry() override
+        {
+            wait_and_call(STATE(do_send));
+            inlineRun_ = true;
+            inlineComplete_ = false;
+            parent_->canHub_->enqueue_send(this, &parent_->canPort_);
+            inlineRun_ = false;
+            if (inlineComplete_)
+            {
+                return exit();
+            }
+            else
+            {
+                return wait();
+            }
+        }
+
+        /// Handles the callback from the CAN hub when it is ready for us to
+        /// send the message.
+        Action do_send()
+        {
+            auto *m = parent_->canHub_->mutable_message();
+            // The reference of the queue entry goes to the hub, which will
+            // share it with the output ports.
+            m->payload_.reset(transfer_message());
+            m->source_ = &parent_->canPort_;
+            parent_->canHub_->do_send();
+            if (inlineRun_)
+            {
+                inlineComplete_ = true;
+                return wait();
+            }
+            else
+            {
+                return exit();
+            }
+        }
+
+    private:
+        /// Owning bridge.
+        GcCanBridge *parent_;
+        /// True while we are calling the target hub send method.
+        bool inlineRun_ : 1;
+        /// True if the send completed inline.
+        bool inlineComplete_ : 1;
+    };
+
+    /// Gridconnect hub.
+    ByteDirectHubInterface *gcHub_;
+    /// CAN frame hub.
+    CanDirectHubInterface *canHub_;
+    /// Our port on the gridconnect hub.
+    GcPort gcPort_;
+    /// Our port on the CAN frame hub.
+    CanPort canPort_;
+    /// Sends rendered packets to the gridconnect hub.
+    ToGcFlow toGc_;
+    /// Sends parsed frames to the CAN hub.
+    ToCanFlow toCan_;
+};
+
+Destructable *create_gc_to_can_bridge(
+    ByteDirectHubInterface *gc_hub, CanDirectHubInterface *can_hub)
+{
+    return new GcCanBridge(gc_hub, can_hub);
+}
@@ -0,0 +1,382 @@
+/** \copyright
+ * Copyright (c) 2026, OpenMRN contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file DirectHubCan.cxx
+ *
+ * DirectHub port that reads and writes binary CAN frames on an fd.
+ *
+ * @author OpenMRN contributors
+ * @date 17 Oct 2026
+ */
+
+#include "openmrn_features.h"
+
+#if OPENMRN_FEATURE_BSD_SOCKETS
+
+#include "utils/DirectHub.hxx"
+
+#include "executor/StateFlow.hxx"
+#include "utils/DirectHubPorts.hxx"
+#include "utils/Hub.hxx"
+#include "utils/logging.h"
+
+/// Connects a CAN frame typed hub to an fd. The fd has to transfer whole
+/// struct can_frame objects in every read and write call (SocketCAN raw
+/// sockets behave this way). The object is self-owning, i.e. will delete
+/// itself when the fd reports an error.
+class DirectHubCanPortSelect final : public DirectHubPort<CanHubData>,
+                                     public DirectHubSelectPortBase
+{
+public:
+    /// Constructor.
+    /// @param hub the hub to register with.
+    /// @param fd the device to read and write.
+    /// @param on_error will be notified when the port exits due to an error.
+    DirectHubCanPortSelect(
+        CanDirectHubInterface *hub, int fd, Notifiable *on_error)
+        : DirectHubSelectPortBase(fd, on_error)
+        , hub_(hub)
+        , readFlow_(this)
+        , writeFlow_(this)
+    {
+        hub_->register_port(this);
+        readFlow_.start();
+    }
+
+    /// Synchronous output routine called by the hub. Queues a reference to
+    /// the hub's message for the write flow.
+    void send(MessageAccessor<CanHubData> *msg) override
+    {
+        if (fd_ < 0)
+        {
+            // Port already closed. Ignore data to send.
+            return;
+        }
+        Buffer<CanFrameRef> *b = CanFrameRef::create(msg);
+        {
+            AtomicHolder h(lock());
+            if (fd_ < 0)
+            {
+                // Catch race condition when port is already closed.
+                b = nullptr;
+            }
+            else
+            {
+                pendingQueue_.insert_locked(b);
+                if (writeActive_)
+                {
+                    // flow already running. Skip notify.
+                    return;
+                }
+                writeActive_ = true;
+            }
+        }
+        if (!b)
+        {
+            return;
+        }
+        writeFlow_.notify();
+    }
+
+private:
+    /// Maximum number of frames we take out of the output queue at once.
+    static constexpr unsigned MAX_BATCH = 8;
+
+    /// State flow that reads frames from the fd and sends them to the hub.
+    class ReadFlow : public DirectHubSelectReadFlowBase
+    {
+    public:
+        /// @param parent the owning port.
+        ReadFlow(DirectHubCanPortSelect *parent)
+            : DirectHubSelectReadFlowBase(parent->hub_->get_service())
+            , parent_(parent)
+        {
+        }
+
+        /// Starts the current flow.
+        void start()
+        {
+            start_flow(STATE(alloc_for_read));
+        }
+
+    private:
+        void read_cancelled() override
+        {
+            read_exit();
+        }
+
+        Action barrier_ready() override
+        {
+            return do_some_read();
+        }
+
+        Action do_some_read()
+        {
+            if (parent_->fd_ < 0)
+            {
+                // Socket closed, terminate and exit.
+                return read_exit();
+            }
+            return read_single(&helper_, parent_->fd_, readBuf_ + readFill_,
+                sizeof(readBuf_) - readFill_, STATE(read_done));
+        }
+
+        Action read_done()
+        {
+            if (helper_.hasError_)
+            {
+                LOG(INFO, "%p: Error reading from fd %d: (%d) %s", parent_,
+                    parent_->fd_, errno, strerror(errno));
+                parent_->report_error();
+                return read_exit();
+            }
+            readFill_ += sizeof(readBuf_) - readFill_ - helper_.remaining_;
+            sendOfs_ = 0;
+            return call_immediately(STATE(send_next));
+        }
+
+        /// Sends the next complete frame from the read buffer to the hub.
+        Action send_next()
+        {
+            if (readFill_ - sendOfs_ < sizeof(struct can_frame))
+            {
+                // Keeps the partial frame for the next read.
+                memmove(readBuf_, readBuf_ + sendOfs_, readFill_ - sendOfs_);
+                readFill_ -= sendOfs_;
+                // Frames still in flight hold a child of the barrier.
+                bufferNotifiable_->notify();
+                bufferNotifiable_ = nullptr;
+                return call_immediately(STATE(alloc_for_read));
+            }
+            // We expect either an inline call to our run() method or
+            // later a callback on the executor.
+            wait_and_call(STATE(send_callback));
+            inlineCall_ = 1;
+            sendComplete_ = 0;
+            parent_->hub_->enqueue_send(this, parent_);
+            inlineCall_ = 0;
+            if (sendComplete_)
+            {
+                return call_immediately(STATE(send_next));
+            }
+            return wait();
+        }
+
+        /// Callback from the hub when we may send the next frame.
+        Action send_callback()
+        {
+            Buffer<CanHubData> *b;
+            mainBufferPool->alloc(&b);
+            memcpy(b->data()->mutable_frame(), readBuf_ + sendOfs_,
+                sizeof(struct can_frame));
+            b->set_done(bufferNotifiable_->new_child());
+            sendOfs_ += sizeof(struct can_frame);
+            auto *m = parent_->hub_->mutable_message();
+            m->payload_.reset(b);
+            m->source_ = parent_;
+            parent_->hub_->do_send();
+            sendComplete_ = 1;
+            if (inlineCall_)
+            {
+                // do not disturb current state.
+                return wait();
+            }
+            return yield_and_call(STATE(send_next));
+        }
+
+        /// Terminates the flow and reports to the parent.
+        Action read_exit()
+        {
+            set_terminated();
+            if (bufferNotifiable_)
+            {
+                bufferNotifiable_->notify();
+                bufferNotifiable_ = nullptr;
+            }
+            parent_->flow_exit(true);
+            return wait();
+        }
+
+        /// Frames that were read but not sent to the hub yet.
+        alignas(struct can_frame) uint8_t
+            readBuf_[MAX_BATCH * sizeof(struct can_frame)];
+        /// Number of bytes filled in readBuf_.
+        unsigned readFill_ {0};
+        /// Offset of the next frame to send in readBuf_.
+        unsigned sendOfs_ {0};
+        /// 1 if we got the send callback inline from send_next.
+        uint16_t inlineCall_ : 1;
+        /// 1 if the run callback actually happened inline.
+        uint16_t sendComplete_ : 1;
+        /// Pointer to the owning port.
+        DirectHubCanPortSelect *parent_;
+    };
+
+    /// State flow that writes the output queue to the fd.
+    class WriteFlow : public StateFlowBase
+    {
+    public:
+        /// @param parent the owning port.
+        WriteFlow(DirectHubCanPortSelect *parent)
+            : StateFlowBase(parent->hub_->get_service())
+            , parent_(parent)
+        {
+            // Waits for the first notification from send().
+            wait_and_call(STATE(take_frames));
+        }
+
+    private:
+        /// Takes a batch of frames out of the output queue.
+        Action take_frames()
+        {
+            {
+                AtomicHolder h(parent_->lock());
+                if (parent_->pendingQueue_.empty())
+                {
+                    if (parent_->fd_ < 0)
+                    {
+                        // No more frames will come.
+                        return call_immediately(STATE(unregister));
+                    }
+                    parent_->writeActive_ = false;
+                    return wait_and_call(STATE(take_frames));
+                }
+                count_ = 0;
+                while (count_ < MAX_BATCH && !parent_->pendingQueue_.empty())
+                {
+                    entries_[count_] = static_cast<Buffer<CanFrameRef> *>(
+                        parent_->pendingQueue_.next_locked().item);
+                    ++count_;
+                }
+            }
+            next_ = 0;
+            return call_immediately(STATE(write_next));
+        }
+
+        /// Writes one frame; some devices accept only one frame per write.
+        Action write_next()
+        {
+            if (next_ >= count_ || parent_->fd_ < 0)
+            {
+                // Done, or the fd is closed and the frames are dropped.
+                // Releasing the entries notifies the done barriers.
+                for (unsigned i = 0; i < count_; ++i)
+                {
+                    entries_[i]->unref();
+                }
+                count_ = 0;
+                return call_immediately(STATE(take_frames));
+            }
+            return write_repeated(&helper_, parent_->fd_,
+                &entries_[next_]->data()->frame(), sizeof(struct can_frame),
+                STATE(write_done));
+        }
+
+        Action write_done()
+        {
+            if (helper_.hasError_)
+            {
+                LOG(INFO, "%p: Error writing to fd %d: (%d) %s", parent_,
+                    parent_->fd_, errno, strerror(errno));
+                parent_->report_error();
+            }
+            ++next_;
+            return call_immediately(STATE(write_next));
+        }
+
+        /// Removes the port from the hub after the fd was closed.
+        Action unregister()
+        {
+            parent_->hub_->unregister_port(parent_, this);
+            return wait_and_call(STATE(write_exit));
+        }
+
+        /// Terminates the flow and reports to the parent.
+        Action write_exit()
+        {
+            set_terminated();
+            parent_->flow_exit(false);
+            return wait();
+        }
+
+        /// Queue entries being written.
+        Buffer<CanFrameRef> *entries_[MAX_BATCH];
+        /// Number of entries in entries_.
+        unsigned count_ {0};
+        /// Index of the next frame to write.
+        unsigned next_ {0};
+        /// Helper object for Select.
+        StateFlowSelectHelper helper_ {this};
+        /// Pointer to the owning port.
+        DirectHubCanPortSelect *parent_;
+    };
+
+    friend class ReadFlow;
+    friend class WriteFlow;
+
+    /// Called on the main executor when either flow saw an error. Closes the
+    /// fd, stops the read flow and wakes up the write flow to unregister.
+    void report_error()
+    {
+        if (close_fd())
+        {
+            readFlow_.read_shutdown();
+        }
+        // The write flow checks fd_ under the lock before going idle, so
+        // after the fd is closed it either sees that, or we wake it here.
+        bool wake = false;
+        {
+            AtomicHolder h(lock());
+            if (!writeActive_)
+            {
+                writeActive_ = true;
+                wake = true;
+            }
+        }
+        if (wake)
+        {
+            writeFlow_.notify();
+        }
+    }
+
+    /// Hub we are registered to.
+    CanDirectHubInterface *hub_;
+    /// True if the write flow is working on the queue (or scheduled to).
+    /// Protected by lock().
+    bool writeActive_ {false};
+    /// Reads the fd.
+    ReadFlow readFlow_;
+    /// Writes the fd.
+    WriteFlow writeFlow_;
+};
+
+void create_port_for_can_fd(
+    CanDirectHubInterface *hub, int fd, Notifiable *on_error)
+{
+    new DirectHubCanPortSelect(hub, fd, on_error);
+}
+
+#endif // OPENMRN_FEATURE_BSD_SOCKETS
@@ -32,6 +32,8 @@
  * @date 1 Mar 2020
  */
 
+#include <string.h>
+
 #include "utils/DirectHub.hxx"
 
 /// Message segmenter that chops incoming byte stream into gridconnect packets.
@@ -59,19 +61,13 @@ public:
         if (isGcPacket_)
         {
             // looking for terminating ;
-            while ((ofs < size) && (data[ofs] != ';'))
-            {
-                ++ofs;
-            }
+            ofs = find(data, 0, size, ';');
             if (ofs < size)
             {
                 // found the terminating ;
                 ++ofs;
                 // append any garbage we still have.
-                while ((ofs < size) && (data[ofs] != ':'))
-                {
-                    ++ofs;
-                }
+                ofs = find(data, ofs, size, ':');
                 packetLen_ += ofs;
                 return packetLen_;
             }
@@ -85,10 +81,7 @@ public:
         else
         {
             // Looking for starting ':'
-            while ((ofs < size) && (data[ofs] != ':'))
-            {
-                ++ofs;
-            }
+            ofs = find(data, 0, size, ':');
             packetLen_ += ofs;
             if (ofs < size)
             {
@@ -111,6 +104,19 @@ public:
     }
 
 private:
+    /// Finds a character in the data.
+    /// @param data input bytes
+    /// @param ofs where to start looking
+    /// @param size length of data
+    /// @param c which character to look for
+    /// @return offset of the first occurrence of c at or after ofs, or size
+    /// if not found.
+    static size_t find(const char *data, size_t ofs, size_t size, char c)
+    {
+        const void *p = memchr(data + ofs, c, size - ofs);
+        return p ? static_cast<const char *>(p) - data : size;
+    }
+
     /// True if the current packet is a gridconnect packet; false if it is
     /// garbage.
     uint32_t isGcPacket_ : 1;
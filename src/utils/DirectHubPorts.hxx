@@ -0,0 +1,251 @@
+/** \copyright
+ * Copyright (c) 2026, OpenMRN contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file DirectHubPorts.hxx
+ *
+ * Building blocks shared by the DirectHub port implementations. Not part of
+ * the public DirectHub API.
+ *
+ * @author OpenMRN contributors
+ * @date 17 Oct 2026
+ */
+
+#ifndef _UTILS_DIRECTHUBPORTS_HXX_
+#define _UTILS_DIRECTHUBPORTS_HXX_
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "executor/AsyncNotifiableBlock.hxx"
+#include "executor/StateFlow.hxx"
+#include "nmranet_config.h"
+#include "utils/DirectHub.hxx"
+#include "utils/Hub.hxx"
+
+/// Output queue entry for a message of a CAN frame typed hub. The message
+/// buffer of the hub is shared between all output ports, so it cannot be
+/// linked into the queue of a port. This entry holds a reference to it
+/// instead of a copy of the frame.
+struct CanFrameRef
+{
+    /// Creates a queue entry for a hub message. Allocates memory, so it must
+    /// not be called with a lock held.
+    /// @param msg the hub message. If it has a done notifiable, the entry
+    /// holds a child of it until the entry is released.
+    /// @return a new queue entry with one reference.
+    static Buffer<CanFrameRef> *create(MessageAccessor<CanHubData> *msg)
+    {
+        Buffer<CanFrameRef> *b;
+        mainBufferPool->alloc(&b);
+        b->data()->payload_.reset(msg->payload_->ref());
+        if (msg->done_)
+        {
+            b->set_done(msg->done_->new_child());
+        }
+        return b;
+    }
+
+    /// @return the referenced frame.
+    const struct can_frame &frame()
+    {
+        return payload_->data()->frame();
+    }
+
+    /// Reference to the hub message that holds the frame.
+    BufferPtr<CanHubData> payload_;
+};
+
+/// Shared part of the DirectHub ports that read and write an fd with the
+/// executor's select. Owns the fd, the output queue and the lock, and deletes
+/// the port once both its read flow and its write flow have exited.
+class DirectHubSelectPortBase
+{
+protected:
+    /// Constructor.
+    /// @param fd the device to read and write. Will be set to non-blocking.
+    /// @param on_error will be notified when the port exits due to an error.
+    DirectHubSelectPortBase(int fd, Notifiable *on_error)
+        : fd_(fd)
+        , onError_(on_error)
+        , readFlowPending_(1)
+        , writeFlowPending_(1)
+    {
+#ifdef __WINNT__
+        unsigned long par = 1;
+        ioctlsocket(fd_, FIONBIO, &par);
+#else
+        ::fcntl(fd, F_SETFL, O_RDWR | O_NONBLOCK);
+#endif
+    }
+
+    virtual ~DirectHubSelectPortBase()
+    {
+    }
+
+    /// @return lock usable for the output queue and the port altogether.
+    Atomic *lock()
+    {
+        return pendingQueue_.lock();
+    }
+
+    /// Closes the fd unless it was closed already. Afterwards fd_ is -1.
+    /// @return true if this call closed the fd.
+    bool close_fd()
+    {
+        int close_fd = -1;
+        {
+            AtomicHolder h(lock());
+            std::swap(fd_, close_fd);
+        }
+        if (close_fd >= 0)
+        {
+            ::close(close_fd);
+            return true;
+        }
+        return false;
+    }
+
+    /// Marks a flow to be exited, and once both are exited, notifies done and
+    /// deletes this.
+    /// @param read if true, marks the read flow done, if false, marks the write
+    /// flow done.
+    void flow_exit(bool read)
+    {
+        bool del = false;
+        {
+            AtomicHolder h(lock());
+            if (read)
+            {
+                readFlowPending_ = 0;
+            }
+            else
+            {
+                writeFlowPending_ = 0;
+            }
+            if (writeFlowPending_ == 0 && readFlowPending_ == 0)
+            {
+                del = true;
+            }
+        }
+        if (del)
+        {
+            if (onError_)
+            {
+                onError_->notify();
+            }
+            delete this;
+        }
+    }
+
+    /// Output entries waiting to be written. The entry type depends on the
+    /// port.
+    Q pendingQueue_;
+    /// File descriptor for input/output, or -1 after it was closed.
+    int fd_;
+    /// This notifiable will be called before exiting.
+    Notifiable *onError_;
+    /// 1 if the read flow is still running.
+    uint8_t readFlowPending_ : 1;
+    /// 1 if the write flow is still running.
+    uint8_t writeFlowPending_ : 1;
+};
+
+/// Shared part of the read flows of the select ports. Limits the number of
+/// input buffers a port has in flight with a pool of barriers, and cancels a
+/// pending read when the port shuts down.
+class DirectHubSelectReadFlowBase : public StateFlowBase
+{
+public:
+    /// Requests the read flow to shut down. Must be called on the main
+    /// executor, after the port's fd was closed. If the flow is waiting in
+    /// select, calls read_cancelled(); otherwise the flow exits when it next
+    /// checks the fd.
+    void read_shutdown()
+    {
+        auto *e = this->service()->executor();
+        if (e->is_selected(&helper_))
+        {
+            // We're waiting in select on reads, we can cancel right now.
+            e->unselect(&helper_);
+            read_cancelled();
+        }
+        // Else we're waiting for the regular progress to wake up the
+        // flow. It will check fd_ < 0 to exit.
+    }
+
+protected:
+    /// @param service the service of the hub.
+    DirectHubSelectReadFlowBase(Service *service)
+        : StateFlowBase(service)
+    {
+    }
+
+    /// Called by read_shutdown() after a pending read was cancelled. Has to
+    /// terminate the flow and report the exit to the port.
+    virtual void read_cancelled() = 0;
+
+    /// Invoked when we have a bufferNotifiable_ from the barrier pool.
+    virtual Action barrier_ready() = 0;
+
+    /// Root of the read flow. Starts with getting the barrier notifiable,
+    /// either synchronously if one is available, or asynchronously.
+    Action alloc_for_read()
+    {
+        QMember *bn = pendingLimiterPool_.next().item;
+        if (bn)
+        {
+            bufferNotifiable_ = pendingLimiterPool_.initialize(bn);
+            return barrier_ready();
+        }
+        else
+        {
+            pendingLimiterPool_.next_async(this);
+            return wait_and_call(STATE(barrier_allocated));
+        }
+    }
+
+    /// Intermediate step if asynchronous allocation was necessary for the
+    /// read barrier.
+    Action barrier_allocated()
+    {
+        QMember *bn;
+        cast_allocation_result(&bn);
+        HASSERT(bn);
+        bufferNotifiable_ = pendingLimiterPool_.initialize(bn);
+        return barrier_ready();
+    }
+
+    /// Barrier notifiable to keep track of the buffer's contents.
+    BarrierNotifiable *bufferNotifiable_ {nullptr};
+    /// Pool of BarrierNotifiables that limit the amount of inflight bytes
+    /// we have.
+    AsyncNotifiableBlock pendingLimiterPool_ {
+        (unsigned)config_directhub_port_max_incoming_packets()};
+    /// Helper object for Select.
+    StateFlowSelectHelper helper_ {this};
+};
+
+#endif // _UTILS_DIRECTHUBPORTS_HXX_
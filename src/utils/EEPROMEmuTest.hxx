@@ -293,3 +293,70 @@ TEST_F(EepromTest, many_overflow) {
     EXPECT_AT(13, "abcd");
     EXPECT_EQ(s, e->activeSector_);
 }
+
+TEST_F(EepromTest, index) {
+    create();
+    EXPECT_EQ(EEPROMEmulation::INDEX_IN_RAM, e->index_ != nullptr);
+    write_to(13, "abcd");
+    if (e->index_) {
+        EXPECT_EQ(0u, e->index_[5]);
+        EXPECT_EQ(3u, e->index_[6]);
+        EXPECT_EQ(4u, e->index_[7]);
+        EXPECT_EQ(5u, e->index_[8]);
+        EXPECT_EQ(0u, e->index_[9]);
+    }
+    write_to(14, "x");
+    if (e->index_) {
+        EXPECT_EQ(6u, e->index_[7]);
+    }
+    EXPECT_AT(12, "\xFF""axcd\xFF");
+}
+
+TEST_F(EepromTest, random_model) {
+    create();
+    string model(eeprom_size, '\xFF');
+    unsigned seed = 42;
+    for (int i = 0; i < 20000; ++i) {
+        seed = seed * 1103515245 + 12345;
+        unsigned ofs = (seed >> 8) % (eeprom_size - 8);
+        unsigned len = 1 + (seed >> 20) % 8;
+        string payload(len, 'a' + (i % 26));
+        write_to(ofs, payload);
+        model.replace(ofs, len, payload);
+        if (i % 1000 == 0) {
+            EXPECT_AT(0, model);
+        }
+        if (i % 7000 == 0) {
+            create(false);
+            EXPECT_AT(0, model);
+        }
+    }
+    EXPECT_AT(0, model);
+    create(false);
+    EXPECT_AT(0, model);
+}
+
+TEST_F(EepromTest, read_benchmark) {
+    create();
+    // Fills the eeprom and the current sector's journal with data.
+    for (unsigned i = 0; i < eeprom_size; i += 10) {
+        write_to(i, "0123456789");
+    }
+    for (unsigned i = 0; i < 500; ++i) {
+        write_to((i * 37) % (eeprom_size - 4), "abcd");
+    }
+    static constexpr unsigned N = 200;
+    string ret(eeprom_size, 0);
+    long long start = os_get_time_monotonic();
+    for (unsigned i = 0; i < N; ++i) {
+        // A config group sized read.
+        for (unsigned ofs = 0; ofs + 64 <= eeprom_size; ofs += 64) {
+            ee()->read(ofs, &ret[ofs], 64);
+        }
+    }
+    long long end = os_get_time_monotonic();
+    printf("shadow %d index %d: %u slots in use, %.1f kbytes/sec read\n",
+        EEPROMEmulation::SHADOW_IN_RAM, EEPROMEmulation::INDEX_IN_RAM,
+        e->slot_count() - e->avail(),
+        (eeprom_size / 64 * 64) * N * 1e6 / (end - start));
+}
@@ -32,6 +32,7 @@
  * @date 26 May 2016
  */
 
+#include <string.h>
 #include <string>
 
 #include "utils/GcStreamParser.hxx"
@@ -75,6 +76,34 @@ bool GcStreamParser::consume_byte(char c)
     return false;
 }
 
+size_t GcStreamParser::consume_data(
+    const char *data, size_t len, bool *has_frame)
+{
+    const char *end = data + len;
+    const char *d = gc_find_delimiter(data, end);
+    size_t n = d - data;
+    if (offset_ >= 0)
+    {
+        if (offset_ + n > sizeof(cbuf_) - 1)
+        {
+            // We overran the buffer, so this can't be a valid frame.
+            offset_ = -1;
+        }
+        else
+        {
+            memcpy(cbuf_ + offset_, data, n);
+            offset_ += n;
+        }
+    }
+    if (d == end)
+    {
+        *has_frame = false;
+        return n;
+    }
+    *has_frame = consume_byte(*d);
+    return n + 1;
+}
+
 void GcStreamParser::frame_buffer(std::string* payload) {
     if (offset_ >= 0) {
         payload->assign(cbuf_, offset_);
@@ -56,6 +56,17 @@ public:
      * internal buffer contains a complete frame. @param c next character. */
     bool consume_byte(char c);
 
+    /** Adds characters from the source stream, up to the end of the next
+     * frame. Equivalent to calling consume_byte for each character, stopping
+     * after the first one that returns true.
+     *
+     * @param data next characters.
+     * @param len number of characters in data.
+     * @param has_frame will be set to true if the internal buffer contains a
+     * complete frame.
+     * @return the number of characters consumed. */
+    size_t consume_data(const char *data, size_t len, bool *has_frame);
+
     /** Parses the current contents of the frame buffer to a can_frame
      * struct. Should be called if and inly if the previous consume_char call
      * returned true.
@@ -69,6 +80,13 @@ public:
     /** @param payload fills with the current contents of the frame buffer. */
     void frame_buffer(std::string *payload);
 
+    /** @return true if the internal buffer holds the beginning of a frame,
+     * i.e. the next characters of the stream continue that frame. */
+    bool has_partial_frame()
+    {
+        return offset_ >= 0;
+    }
+
 private:
     /// Collects data from a partial GC packet.
     char cbuf_[32];
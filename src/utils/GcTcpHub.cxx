@@ -49,7 +49,13 @@ void GcTcpHub::on_new_connection(int fd)
     FdUtils::optimize_socket_fd(fd);
     // Create new notification object for tracking the fd.
     OnErrorNotify *n = new OnErrorNotify(this, fd);
-    create_gc_port_for_can_hub(canHub_, fd, n, use_select);
+    Service *port_service = nullptr;
+    if (!portServices_.empty())
+    {
+        port_service = portServices_[nextService_];
+        nextService_ = (nextService_ + 1) % portServices_.size();
+    }
+    create_gc_port_for_can_hub(canHub_, fd, n, use_select, port_service);
 
     if (onConnectCallback_)
     {
@@ -67,6 +73,19 @@ GcTcpHub::GcTcpHub(CanHubFlow *can_hub, int port,
 {
 }
 
+GcTcpHub::GcTcpHub(CanHubFlow *can_hub, int port,
+    std::vector<Service *> port_services,
+    std::function<void()> on_connect_callback)
+    : onConnectCallback_(on_connect_callback)
+    , canHub_(can_hub)
+    , portServices_(std::move(port_services))
+    , tcpListener_(port,
+          std::bind(&GcTcpHub::on_new_connection, this, std::placeholders::_1),
+          "GcTcpHub")
+{
+    HASSERT(!portServices_.empty());
+}
+
 GcTcpHub::~GcTcpHub()
 {
     // Since shutdown is a blocking call, we cannot get delivered any
@@ -58,6 +58,21 @@ public:
     GcTcpHub(CanHubFlow *can_hub, int port,
         std::function<void()> on_connect_callback = nullptr);
 
+    /// Constructor for a sharded hub. The per-connection work (select,
+    /// gridconnect parsing and formatting) of the incoming connections is
+    /// distributed round-robin among the given services, and only the binary
+    /// frames are routed on the executor of can_hub.
+    ///
+    /// @param can_hub Which CAN-hub should we attach the TCP gridconnect hub
+    ///        onto.
+    /// @param port TCP port number to listen on.
+    /// @param port_services services to run the connections on. Must not be
+    ///        empty. Must outlive all connections.
+    /// @param on_connect_callback hook for the application "on connect".
+    GcTcpHub(CanHubFlow *can_hub, int port,
+        std::vector<Service *> port_services,
+        std::function<void()> on_connect_callback = nullptr);
+
     /// Destructor
     ~GcTcpHub();
 
@@ -152,6 +167,13 @@ private:
     /// Which CAN-hub should we attach the TCP gridconnect hub onto.
     CanHubFlow *canHub_;
 
+    /// Services to run the client connections on. If empty, the connections
+    /// run on canHub_'s service.
+    std::vector<Service *> portServices_;
+
+    /// Index into portServices_ for the next incoming connection.
+    unsigned nextService_ {0};
+
     /// Helper object representing the listening on the socket.
     SocketListener tcpListener_;
 
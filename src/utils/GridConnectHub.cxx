@@ -47,6 +47,7 @@
 #include "utils/HubDeviceSelect.hxx"
 #endif
 #include "utils/Hub.hxx"
+#include "utils/HubHandoff.hxx"
 #include "utils/GcStreamParser.hxx"
 #include "utils/gc_format.h"
 
@@ -70,6 +71,27 @@ public:
         isRegistered_ = 1;
     }
 
+    /// Constructor for a bridge that runs on the executor of the gridconnect
+    /// side.
+    ///
+    /// @param gc_side A hub of type string, the gridconnect side. The bridge
+    /// will run on the service of this hub.
+    /// @param can_side A hub of type struct can_frame, the binary side.
+    /// @param can_input the parsed packets will be sent here. This must be
+    /// safe to call from gc_side's executor and eventually forward the packets
+    /// to can_side.
+    /// @param double_bytes if true, upon rendering data each byte will be
+    /// doubled. This is an anciant workaround.
+    GCAdapter(HubFlow *gc_side, CanHubFlow *can_side,
+        CanHubPortInterface *can_input, bool double_bytes)
+        : parser_(gc_side->service(), can_side, &formatter_, can_input)
+        , formatter_(gc_side->service(), gc_side, &parser_, double_bytes)
+    {
+        gc_side->register_port(&parser_);
+        can_side->register_port(&formatter_);
+        isRegistered_ = 1;
+    }
+
     /// Constructor
     ///
     /// @param gc_side_read A hub of type string to read packets from. The read
@@ -242,10 +264,13 @@ public:
         /// @param destination Where to write converted binary packets.
         /// @param skip_member what to set skipMember_ of the outgoing packets
         /// to.
-        GCToBinaryMember(
-            Service *service, CanHubFlow *destination, CanHubPort *skip_member)
+        /// @param output if not null, the converted packets will be sent here
+        /// instead of destination.
+        GCToBinaryMember(Service *service, CanHubFlow *destination,
+            CanHubPort *skip_member, CanHubPortInterface *output = nullptr)
             : HubPort(service)
             , destination_(destination)
+            , output_(output ? output : destination)
             , skipMember_(skip_member)
         {
             int max_frames_to_parse =
@@ -284,6 +309,7 @@ public:
         {
             inBuf_ = message()->data()->data();
             inBufSize_ = message()->data()->size();
+            nextFrame_ = numFrames_ = 0;
             return call_immediately(STATE(parse_more_data));
         }
 
@@ -291,14 +317,40 @@ public:
         /// frames. @return next state.
         Action parse_more_data()
         {
-            while (inBufSize_--)
+            if (nextFrame_ < numFrames_)
             {
-                char c = *inBuf_++;
-                if (streamSegmenter_.consume_byte(c))
+                return allocate_and_call(output_,
+                    STATE(send_parsed_frame), frameAllocator_.get());
+            }
+            while (inBufSize_)
+            {
+                if (!streamSegmenter_.has_partial_frame())
+                {
+                    // Parses the complete frames in place.
+                    size_t consumed;
+                    numFrames_ = gc_format_parse_batch(
+                        inBuf_, inBufSize_, frames_, BATCH_SIZE, &consumed);
+                    nextFrame_ = 0;
+                    inBuf_ += consumed;
+                    inBufSize_ -= consumed;
+                    if (numFrames_)
+                    {
+                        return allocate_and_call(output_,
+                            STATE(send_parsed_frame), frameAllocator_.get());
+                    }
+                    // What is left is the beginning of a frame; the
+                    // segmenter will collect it.
+                }
+                bool has_frame;
+                size_t n =
+                    streamSegmenter_.consume_data(inBuf_, inBufSize_, &has_frame);
+                inBuf_ += n;
+                inBufSize_ -= n;
+                if (has_frame)
                 {
                     // End of frame. Allocate an output buffer and parse the
                     // frame.
-                    return allocate_and_call(destination_, STATE(parse_to_output_frame), frameAllocator_.get());
+                    return allocate_and_call(output_, STATE(parse_to_output_frame), frameAllocator_.get());
                 }
             }
             // Will notify the caller.
@@ -310,11 +362,11 @@ public:
          * process buffer. @return next state. */
         Action parse_to_output_frame()
         {
-            auto* b = get_allocation_result(destination_);
+            auto* b = get_allocation_result(output_);
             if (streamSegmenter_.parse_frame_to_output(b->data()))
             {
                 b->data()->skipMember_ = skipMember_;
-                destination_->send(b);
+                output_->send(b);
             }
             else
             {
@@ -324,9 +376,30 @@ public:
             return call_immediately(STATE(parse_more_data));
         }
 
+        /// Sends off the next frame parsed by the batch parser. Then comes
+        /// back to process the buffer. @return next state.
+        Action send_parsed_frame()
+        {
+            auto *b = get_allocation_result(output_);
+            *b->data()->mutable_frame() = frames_[nextFrame_++];
+            b->data()->skipMember_ = skipMember_;
+            output_->send(b);
+            return call_immediately(STATE(parse_more_data));
+        }
+
     private:
+        /// How many frames we parse at once.
+        static constexpr unsigned BATCH_SIZE = 8;
+
         /// Holds the state of the incoming characters and the boundary.
         GcStreamParser streamSegmenter_;
+
+        /// Frames parsed from the incoming characters, not sent yet.
+        struct can_frame frames_[BATCH_SIZE];
+        /// Number of valid entries in frames_.
+        uint8_t numFrames_;
+        /// Index of the next entry in frames_ to send.
+        uint8_t nextFrame_;
         
         /// The incoming characters.
         const char *inBuf_;
@@ -341,6 +414,9 @@ public:
 
         /// Pipe to send data to.
         CanHubFlow *destination_;
+        /// Where the outgoing packets are actually sent; usually the same as
+        /// destination_.
+        CanHubPortInterface *output_;
         /// The pipe member that should be sent as "source".
         CanHubPortInterface *skipMember_;
     };
@@ -369,6 +445,12 @@ GCAdapterBase *GCAdapterBase::CreateGridConnectAdapter(HubFlow *gc_side_read,
     return new GCAdapter(gc_side_read, gc_side_write, can_side, double_bytes);
 }
 
+GCAdapterBase *GCAdapterBase::CreateGridConnectAdapter(HubFlow *gc_side,
+    CanHubFlow *can_side, CanHubPortInterface *can_input, bool double_bytes)
+{
+    return new GCAdapter(gc_side, can_side, can_input, double_bytes);
+}
+
 /// Implementation for the gridconnect bridge. Owns all necessary structures,
 /// and is responsible for the initialization, registering, unregistering and
 /// destruction of these structures.
@@ -454,10 +536,18 @@ struct GcHubPort : public Executable
     /// experiences an error (typically upon device closed or connection lost).
     /// @param use_select true if fd can be used with select, false if threads
     /// are needed.
-    GcHubPort(CanHubFlow *can_hub, int fd, Notifiable *on_exit, bool use_select)
-        : gcHub_(can_hub->service())
-        , bridge_(
-              GCAdapterBase::CreateGridConnectAdapter(&gcHub_, can_hub, false))
+    /// @param port_service if not null, the port's flows will run on this
+    /// service instead of the service of the can_hub.
+    GcHubPort(CanHubFlow *can_hub, int fd, Notifiable *on_exit,
+        bool use_select, Service *port_service)
+        : gcHub_(port_service ? port_service : can_hub->service())
+        , handoff_(port_service ? new HubHandoffPort<CanHubFlow>(can_hub)
+                                : nullptr)
+        , bridge_(handoff_
+                  ? GCAdapterBase::CreateGridConnectAdapter(
+                        &gcHub_, can_hub, handoff_.get(), false)
+                  : GCAdapterBase::CreateGridConnectAdapter(
+                        &gcHub_, can_hub, false))
         , onExit_(on_exit)
     {
         LOG(VERBOSE, "gchub port %p", (Executable *)this);
@@ -482,6 +572,12 @@ struct GcHubPort : public Executable
      * disconnection of the bridge (write side) and the FdHubport (read side)
      * we need to wait for the executor until this flow drains. */
     HubFlow gcHub_;
+    /** When the port runs on a different executor than the can hub, carries
+     * the parsed packets over to the can hub's executor. Null otherwise.
+     *
+     * Destruction requirement: is_idle() has to be checked on the can-side
+     * executor after the bridge is shut down. */
+    std::unique_ptr<HubHandoffPort<CanHubFlow>> handoff_;
     /** Translates packets between the can-hub of the device and the char-hub
      * of this port.
      *
@@ -495,6 +591,9 @@ struct GcHubPort : public Executable
     /** If not null, this notifiable will be called when the device is
      * closed. */
     Notifiable* onExit_;
+    /** True if the handoff was verified to be idle on the can-side executor
+     * since the last time we saw the bridge not yet shut down. */
+    bool handoffIdle_{false};
 
     /** Callback in case the connection is closed due to error. */
     void notify() OVERRIDE
@@ -510,10 +609,24 @@ struct GcHubPort : public Executable
     {
         if (!bridge_->shutdown() || !gcHub_.is_waiting())
         {
+            handoffIdle_ = false;
             // Yield.
             gcHub_.service()->executor()->add(this);
             return;
         }
+        if (handoff_ && !handoffIdle_)
+        {
+            // The handoff can only be inspected on the can hub's executor.
+            // The round trip also ensures that the can hub is not in the
+            // middle of sending a packet to the (already unregistered)
+            // bridge; we check the bridge again when we get back.
+            handoff_->hub()->service()->executor()->add(
+                new CallbackExecutable([this]() {
+                    handoffIdle_ = handoff_->is_idle();
+                    gcHub_.service()->executor()->add(this);
+                }));
+            return;
+        }
         LOG(INFO, "GCHubPort: Shutting down gridconnect port %d. (%p)",
             gcWrite_->fd(), bridge_.get());
         if (onExit_) {
@@ -528,8 +641,8 @@ struct GcHubPort : public Executable
     }
 };
 
-void create_gc_port_for_can_hub(
-    CanHubFlow *can_hub, int fd, Notifiable *on_exit, bool use_select)
+void create_gc_port_for_can_hub(CanHubFlow *can_hub, int fd,
+    Notifiable *on_exit, bool use_select, Service *port_service)
 {
-    new GcHubPort(can_hub, fd, on_exit, use_select);
+    new GcHubPort(can_hub, fd, on_exit, use_select, port_service);
 }
@@ -101,6 +101,27 @@ public:
     ///
     static GCAdapterBase *CreateGridConnectAdapter(HubFlow *gc_side_read,
         HubFlow *gc_side_write, CanHubFlow *can_side, bool double_bytes);
+
+    /// Creates a gridconnect-CAN bridge that runs on the executor of the
+    /// gridconnect side instead of the executor of the CAN side. This allows
+    /// the parsing and formatting for many ports to be spread over multiple
+    /// threads.
+    ///
+    /// @param gc_side is the Hub that has the ASCII GridConnect traffic. The
+    /// bridge will use this hub's service.
+    /// @param can_side is the Hub that has the binary CAN traffic. The
+    /// bridge's formatter gets registered to this hub.
+    /// @param can_input the parsed binary frames will be sent to this port
+    /// (from the executor of gc_side). Typically a HubHandoffPort forwarding
+    /// to can_side.
+    /// @param double_bytes  if true, any frame rendered into the GC protocol
+    ///   will have their characters doubled.
+    ///
+    /// @return a pointer to the created object. The shutdown() call may be
+    /// made on the executor of gc_side.
+    static GCAdapterBase *CreateGridConnectAdapter(HubFlow *gc_side,
+        CanHubFlow *can_side, CanHubPortInterface *can_input,
+        bool double_bytes);
 };
 
 /** Create this port for a CAN hub and all packets will be written to stdout in
@@ -139,8 +160,14 @@ private:
  * @param on_exit is a notifiable (may be null) which will be called in case
  * an error is encountered on this port and the port is subsequently closed.
  * @param use_select when true, the FD will be used with select, when false,
- * separate threads will be started with blocking read and write calls. */
+ * separate threads will be started with blocking read and write calls.
+ * @param port_service if not null, the parsing and formatting of the
+ * gridconnect data (and the select calls, if use_select) will run on this
+ * service's executor, and the parsed frames are handed off to can_hub's
+ * executor via a lock-free queue. Packets from the same port keep their
+ * order. */
 void create_gc_port_for_can_hub(CanHubFlow *can_hub, int fd,
-    Notifiable *on_exit = nullptr, bool use_select = false);
+    Notifiable *on_exit = nullptr, bool use_select = false,
+    Service *port_service = nullptr);
 
 #endif //_UTILS_GRIDCONNECTHUB_HXX_
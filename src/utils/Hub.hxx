@@ -145,6 +145,58 @@ typedef StateFlow<Buffer<CanHubData>, QList<1>> CanHubPort;
 /// This should work for both 32 and 64-bit architectures.
 static const uintptr_t POINTER_MASK = UINTPTR_MAX;
 
+/// How many messages a shared hub port can hold by reference. Further
+/// messages are copied while the port's queue is full.
+static constexpr unsigned SHARED_HUB_PORT_QUEUE_SIZE = 16;
+
+/// Base class for a hub port that is implemented as a stateflow and receives
+/// the messages from the hub without copying. When registered with
+/// GenericHubFlow::register_shared_port (or register_device_port on a hub
+/// with shared delivery turned on), every such port gets a new reference
+/// to the same buffer, and holds it in its own QPointerRing queue. The port
+/// must not modify the message. When the queue is full, the port gets a copy
+/// of the message instead. It can be used as a regular port as well
+/// (register_port or a direct send()), in which case it gets a copy.
+template <class D>
+class GenericSharedHubPort
+    : public StateFlow<Buffer<D>, QPointerRing<SHARED_HUB_PORT_QUEUE_SIZE>>,
+      public SharedMessageHandler<Buffer<D>>
+{
+public:
+    /// Constructor. @param service defines which executor the port runs on.
+    GenericSharedHubPort(Service *service)
+        : StateFlow<Buffer<D>, QPointerRing<SHARED_HUB_PORT_QUEUE_SIZE>>(
+              service)
+    {
+    }
+
+    /// Called by the hub with a new reference to a message. @param message
+    /// is the shared buffer.
+    void handle_shared_message(BufferPtr<D> message) override
+    {
+        {
+            AtomicHolder h(this);
+            if (this->queue()->has_room_locked())
+            {
+                this->send(message.release());
+                return;
+            }
+        }
+        // The queue is full, so the message would have to be linked through
+        // its QMember. That needs a buffer of our own.
+        Buffer<D> *copy;
+        this->pool()->alloc(&copy);
+        *copy->data() = *message->data();
+        copy->set_done(message->new_child());
+        message.reset();
+        this->send(copy);
+    }
+};
+/// Base class for a port to an ascii hub that receives shared messages.
+typedef GenericSharedHubPort<HubData> SharedHubPort;
+/// Base class for a port to a CAN hub that receives shared messages.
+typedef GenericSharedHubPort<CanHubData> SharedCanHubPort;
+
 /// Templated implementation of the HubFlow.
 template<class D> class GenericHubFlow : public DispatchFlow<Buffer<D>, 1>
 {
@@ -155,6 +207,8 @@ public:
     typedef Buffer<value_type> buffer_type;
     /// Base type of an individual port.
     typedef FlowInterface<buffer_type> port_type;
+    /// Base type of a port that receives messages without copying.
+    typedef GenericSharedHubPort<value_type> shared_port_type;
 
     /// Constructor. @param s defines which executor to run this on.
     GenericHubFlow(Service *s) : DispatchFlow<Buffer<D>, 1>(s)
@@ -176,6 +230,84 @@ public:
         this->unregister_handler(port, reinterpret_cast<uintptr_t>(port),
                                  POINTER_MASK);
     }
+
+    /// Adds a new port that receives the messages without copying. All such
+    /// ports share one reference-counted buffer per message; only regular
+    /// ports get a copy. Messages with skipMember_ == port are not sent to
+    /// it. @param port is the object to add.
+    void register_shared_port(shared_port_type *port)
+    {
+        this->register_shared_handler(port, port_id(port), POINTER_MASK);
+    }
+
+    /// Removes a port added with register_shared_port. @param port is the
+    /// port to remove.
+    virtual void unregister_shared_port(shared_port_type *port)
+    {
+        this->unregister_shared_handler(port, port_id(port), POINTER_MASK);
+    }
+
+    /// Turns on shared delivery for the ports added with
+    /// register_device_port(). Only allowed if no port of this hub modifies
+    /// the messages it gets, since those ports would see each other's
+    /// changes. Off by default. Call before adding ports.
+    /// @param enable true to share the messages with device ports.
+    void set_shared_delivery(bool enable)
+    {
+        sharedDelivery_ = enable;
+    }
+
+    /// @return true if device ports get the messages without copying.
+    bool shared_delivery()
+    {
+        return sharedDelivery_;
+    }
+
+    /// Adds a port that is able to receive the messages without copying (like
+    /// the write flow of a device). It is added with register_shared_port()
+    /// if shared delivery is turned on for this hub, otherwise with
+    /// register_port().
+    /// @param port is the object to add.
+    /// @return true if the port was added as a shared port; pass this to
+    /// unregister_device_port().
+    bool register_device_port(shared_port_type *port)
+    {
+        if (sharedDelivery_)
+        {
+            register_shared_port(port);
+            return true;
+        }
+        register_port(port);
+        return false;
+    }
+
+    /// Removes a port added with register_device_port().
+    /// @param port is the port to remove.
+    /// @param shared is what register_device_port() returned.
+    void unregister_device_port(shared_port_type *port, bool shared)
+    {
+        if (shared)
+        {
+            unregister_shared_port(port);
+        }
+        else
+        {
+            unregister_port(port);
+        }
+    }
+
+protected:
+    /// @return the identifier of a shared port in the dispatcher, which is
+    /// the value a message's skipMember_ has when it came from this port.
+    /// @param port the port.
+    static uintptr_t port_id(shared_port_type *port)
+    {
+        return reinterpret_cast<uintptr_t>(static_cast<port_type *>(port));
+    }
+
+private:
+    /// True if register_device_port() adds shared ports.
+    bool sharedDelivery_ {false};
 };
 
 /** A generic hub that proxies packets of untyped (aka string) data. */
@@ -312,7 +312,7 @@ public:
         barrier_.reset(
             on_error ? on_error : EmptyNotifiable::DefaultInstance());
         barrier_.new_child();
-        hub_->register_port(write_port());
+        isShared_ = hub_->register_device_port(&writeFlow_);
         isRegistered_ = true;
     }
 #endif
@@ -325,7 +325,7 @@ public:
     /// @param on_error notifiable that will be called when a write or read
     /// error is encountered.
     HubDeviceSelect(HFlow *hub, int fd, Notifiable *on_error = nullptr)
-        : FdHubPortService(hub->service()->executor(), fd)
+        : FdHubPortService(hub->service()->executor(), set_nonblocking(fd))
         , hub_(hub)
         , readFlow_(this, hub, &writeFlow_)
         , writeFlow_(this)
@@ -334,13 +334,7 @@ public:
         barrier_.reset(
             on_error ? on_error : EmptyNotifiable::DefaultInstance());
         barrier_.new_child();
-#ifdef __WINNT__
-        unsigned long par = 1;
-        ioctlsocket(fd_, FIONBIO, &par);
-#else
-        ::fcntl(fd, F_SETFL, O_RDWR | O_NONBLOCK);
-#endif
-        hub_->register_port(write_port());
+        isShared_ = hub_->register_device_port(&writeFlow_);
         isRegistered_ = true;
     }
 
@@ -392,7 +386,7 @@ public:
             }
             isRegistered_ = false;
         }
-        hub_->unregister_port(&writeFlow_);
+        hub_->unregister_device_port(&writeFlow_, isShared_);
         /* We put an empty message at the end of the queue. This will cause
          * wait until all pending messages are dealt with, and then ping the
          * barrier notifiable, commencing the shutdown. */
@@ -409,8 +403,10 @@ public:
     }
 
 protected:
-    /// Base stateflow for the WriteFlow.
-    typedef StateFlow<typename HFlow::buffer_type, QList<1>> WriteFlowBase;
+    /// Base stateflow for the WriteFlow. If the hub has shared delivery
+    /// turned on, it gives it a reference to the incoming buffers instead of
+    /// a copy.
+    typedef typename HFlow::shared_port_type WriteFlowBase;
     /// State flow implementing select-aware fd writes.
     class WriteFlow : public WriteFlowBase
     {
@@ -494,6 +490,22 @@ protected:
         close_fd();
     }
 
+    /// Puts an fd into nonblocking mode. This has to happen before the read
+    /// flow gets to run on the executor, otherwise it might block the
+    /// executor thread in ::read.
+    /// @param fd file descriptor.
+    /// @return fd.
+    static int set_nonblocking(int fd)
+    {
+#ifdef __WINNT__
+        unsigned long par = 1;
+        ioctlsocket(fd, FIONBIO, &par);
+#else
+        ::fcntl(fd, F_SETFL, O_RDWR | O_NONBLOCK);
+#endif
+        return fd;
+    }
+
     void close_fd()
     {
         int fd = -1;
@@ -526,6 +538,8 @@ protected:
     /// True when the write flow is registered in the hub. Used to synchronize
     /// different and concurrent shutdown paths. Protected by Atomic this.
     bool isRegistered_;
+    /// True if the write flow was registered as a shared port.
+    bool isShared_;
 };
 
 #endif // FEATURE_EXECUTOR_SELECT
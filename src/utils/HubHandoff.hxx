@@ -0,0 +1,138 @@
+/** \copyright
+ * Copyright (c) 2026, OpenMRN contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file HubHandoff.hxx
+ *
+ * Forwards packets to a hub running on a different executor without locking.
+ *
+ * @author OpenMRN contributors
+ * @date 17 Oct 2026
+ */
+
+#ifndef _UTILS_HUBHANDOFF_HXX_
+#define _UTILS_HUBHANDOFF_HXX_
+
+#include <atomic>
+
+#include "executor/Executor.hxx"
+#include "utils/Hub.hxx"
+#include "utils/MpscQueue.hxx"
+
+/// A port-like object that accepts packets on any thread and sends them into
+/// a hub on the hub's own executor. The producer side costs two atomic
+/// exchanges per packet instead of taking the hub's queue lock, so that flows
+/// running on several executors do not contend with each other (or with the
+/// hub) when they feed the same hub. Packets sent from the same thread arrive
+/// in the hub in the same order.
+///
+/// All packets are forwarded to the hub at the default priority.
+///
+/// Usage: use the object as the destination of a flow that runs on a
+/// different executor than the hub; the pool() is the same as the hub's.
+/// Before deleting, wait until is_idle() returns true on the hub's executor.
+template <class HFlow>
+class HubHandoffPort : public HFlow::port_type, private Executable
+{
+public:
+    /// Buffer type of the hub.
+    typedef typename HFlow::buffer_type buffer_type;
+
+    /// Constructor. @param hub where to forward the packets to.
+    HubHandoffPort(HFlow *hub)
+        : hub_(hub)
+        , scheduled_(false)
+    {
+    }
+
+    ~HubHandoffPort()
+    {
+        HASSERT(is_idle());
+    }
+
+    /// @return the hub we are forwarding to.
+    HFlow *hub()
+    {
+        return hub_;
+    }
+
+    Pool *pool() override
+    {
+        return hub_->pool();
+    }
+
+    /// Enqueues a packet for the hub. May be called on any thread.
+    /// @param message packet to forward; ownership is transferred.
+    /// @param priority ignored.
+    void send(buffer_type *message, unsigned priority = UINT_MAX) override
+    {
+        queue_.push(message);
+        if (!scheduled_.exchange(true))
+        {
+            hub_->service()->executor()->add(this);
+        }
+    }
+
+    /// @return true if there are no packets in flight. Call this on the hub's
+    /// executor, when no more packets are being sent.
+    bool is_idle()
+    {
+        return !scheduled_.load() && queue_.empty();
+    }
+
+private:
+    /// How many packets we forward before yielding the executor.
+    static constexpr unsigned BATCH_SIZE = 16;
+
+    /// Drains the queue into the hub. Runs on the hub's executor.
+    void run() override
+    {
+        // Any push that happens after this point will schedule us again.
+        scheduled_.store(false);
+        for (unsigned i = 0; i < BATCH_SIZE; ++i)
+        {
+            QMember *m = queue_.pop();
+            if (!m)
+            {
+                return;
+            }
+            hub_->send(static_cast<buffer_type *>(m));
+        }
+        if (!scheduled_.exchange(true))
+        {
+            // Lets other work on the executor proceed.
+            hub_->service()->executor()->add(this);
+        }
+    }
+
+    /// Where to forward the packets.
+    HFlow *hub_;
+    /// Packets waiting for the hub's executor.
+    MpscQueue queue_;
+    /// True if *this is on the executor's queue (or will be shortly).
+    std::atomic<bool> scheduled_;
+};
+
+#endif // _UTILS_HUBHANDOFF_HXX_
@@ -0,0 +1,136 @@
+/** \copyright
+ * Copyright (c) 2026, OpenMRN contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file MpscQueue.hxx
+ *
+ * Lock-free intrusive queue with many producers and a single consumer.
+ *
+ * @author OpenMRN contributors
+ * @date 17 Oct 2026
+ */
+
+#ifndef _UTILS_MPSCQUEUE_HXX_
+#define _UTILS_MPSCQUEUE_HXX_
+
+#include <atomic>
+
+#include "utils/QMember.hxx"
+#include "utils/macros.h"
+
+/// Intrusive FIFO queue of QMembers that can be pushed to from any number of
+/// threads concurrently without taking a lock, and popped from by a single
+/// consumer thread. Entries pushed by the same thread come out in the order
+/// they were pushed.
+///
+/// This is the non-blocking queue by Dmitry Vyukov. A push is a single atomic
+/// exchange. A pop may transiently return nullptr while a producer is in the
+/// middle of a push; such producers have to make sure the consumer gets
+/// woken up after the push returns.
+class MpscQueue
+{
+public:
+    MpscQueue()
+        : head_(&stub_)
+        , tail_(&stub_)
+    {
+        stub_.next = nullptr;
+    }
+
+    /// Adds an entry to the end of the queue. May be called from any thread.
+    /// @param item the entry to add. Must not be in any other queue.
+    void push(QMember *item)
+    {
+        __atomic_store_n(&item->next, nullptr, __ATOMIC_RELAXED);
+        QMember *prev = head_.exchange(item, std::memory_order_acq_rel);
+        __atomic_store_n(&prev->next, item, __ATOMIC_RELEASE);
+    }
+
+    /// Removes the entry at the front of the queue. Must be called only from
+    /// the consumer thread.
+    /// @return the front entry, or nullptr if the queue is empty (or a
+    /// producer has not finished pushing yet).
+    QMember *pop()
+    {
+        QMember *tail = tail_;
+        QMember *next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+        if (tail == &stub_)
+        {
+            if (!next)
+            {
+                return nullptr;
+            }
+            tail_ = next;
+            tail = next;
+            next = __atomic_load_n(&next->next, __ATOMIC_ACQUIRE);
+        }
+        if (next)
+        {
+            tail_ = next;
+            tail->next = nullptr;
+            return tail;
+        }
+        if (tail != head_.load(std::memory_order_acquire))
+        {
+            // A producer is between the exchange and the link in push().
+            return nullptr;
+        }
+        // Tail is the last entry. Puts the stub back so that tail can be
+        // unlinked.
+        push(&stub_);
+        next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+        if (next)
+        {
+            tail_ = next;
+            tail->next = nullptr;
+            return tail;
+        }
+        return nullptr;
+    }
+
+    /// @return true if there is nothing in the queue. Exact only when called
+    /// from the consumer thread; from other threads it may be stale.
+    bool empty()
+    {
+        return head_.load(std::memory_order_acquire) == &stub_;
+    }
+
+private:
+    /// Placeholder entry that keeps the queue non-empty internally.
+    struct Stub : public QMember
+    {
+    };
+
+    /// Last entry pushed. Written by the producers.
+    std::atomic<QMember *> head_;
+    /// Next entry to pop (or the stub). Owned by the consumer.
+    QMember *tail_;
+    /// Placeholder entry.
+    Stub stub_;
+
+    DISALLOW_COPY_AND_ASSIGN(MpscQueue);
+};
+
+#endif // _UTILS_MPSCQUEUE_HXX_
@@ -607,6 +607,100 @@ private:
  */
 template<unsigned items> using QListProtected = QList<items>;
 
+/** A queue that stores pointers to the queued items in a ring buffer instead
+ * of linking them through QMember::next. This separates queue membership from
+ * ownership: the same Buffer can be in any number of QPointerRings at the
+ * same time (each holding a separate reference), which is not possible with
+ * Q or QList.
+ *
+ * The ring has a fixed capacity of SIZE entries and never allocates memory.
+ * When the ring is full, further items are linked into an intrusive overflow
+ * queue; these items must therefore be owned by the caller exclusively. A
+ * caller that wants to insert a shared item has to check has_room_locked()
+ * first, in the same critical section as the insert.
+ *
+ * Has only one priority level; the index arguments are ignored. All calls
+ * need external locking; this class is meant to be used as the QueueType of a
+ * StateFlow, which provides the locking.
+ */
+template <unsigned SIZE> class QPointerRing
+{
+public:
+    QPointerRing()
+    {
+    }
+
+    typedef ::Result Result;
+
+    /** @return true if the next insert_locked() call will put the item into
+     * the ring, i.e. the item does not need to be exclusively owned. Needs
+     * external locking. */
+    bool has_room_locked()
+    {
+        return count_ < SIZE && overflow_.empty();
+    }
+
+    /** Add an item to the back of the queue. Needs external locking.
+     * @param item to add to queue. If has_room_locked() is false, the item
+     * will be linked through its QMember::next.
+     * @param index ignored
+     */
+    void insert_locked(QMember *item, unsigned index = 0)
+    {
+        if (has_room_locked())
+        {
+            items_[(head_ + count_) % SIZE] = item;
+            ++count_;
+        }
+        else
+        {
+            overflow_.insert_locked(item);
+        }
+    }
+
+    /** Get an item from the front of the queue. Needs external locking.
+     * @return item retrieved from queue with index 0, NULL if no item
+     * available
+     */
+    Result next_locked()
+    {
+        if (!count_)
+        {
+            // Items only go to the overflow queue while the ring is not
+            // empty, so they are all newer than the ones in the ring.
+            return overflow_.next_locked();
+        }
+        QMember *ret = items_[head_];
+        head_ = (head_ + 1) % SIZE;
+        --count_;
+        return Result(ret, 0);
+    }
+
+    /// @return how many entries are enqueued right now.
+    size_t size()
+    {
+        return count_ + overflow_.pending();
+    }
+
+    /// @return true if the queue is empty.
+    bool empty()
+    {
+        return count_ == 0 && overflow_.empty();
+    }
+
+private:
+    /// Ring storage.
+    QMember *items_[SIZE];
+    /// Index of the front of the queue in items_.
+    unsigned head_ {0};
+    /// Number of entries in the ring.
+    unsigned count_ {0};
+    /// Exclusively owned items that arrived while the ring was full.
+    Q overflow_;
+
+    DISALLOW_COPY_AND_ASSIGN(QPointerRing);
+};
+
 
 #if 0
 /** A BufferQueue that adds the ability to wait on the next buffer.
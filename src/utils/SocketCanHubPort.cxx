@@ -0,0 +1,587 @@
+/** \copyright
+ * Copyright (c) 2026, OpenMRN contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file SocketCanHubPort.cxx
+ *
+ * CAN hub port for SocketCan sockets that reads and writes frames in batches.
+ *
+ * @author OpenMRN contributors
+ * @date 17 Oct 2026
+ */
+
+#include "utils/SocketCanHubPort.hxx"
+
+#if defined(__linux__)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/net_tstamp.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "openlcb/CanDefs.hxx"
+
+/// State flow reading batches of frames from the socket and forwarding them
+/// to the hub.
+class SocketCanHubPort::ReadFlow : public StateFlowBase
+{
+public:
+    /// Constructor. @param port is the parent object.
+    ReadFlow(SocketCanHubPort *port)
+        : StateFlowBase(port)
+    {
+        memset(msgs_, 0, sizeof(msgs_));
+        for (unsigned i = 0; i < BATCH_SIZE; ++i)
+        {
+            iov_[i].iov_base = &frames_[i];
+            iov_[i].iov_len = sizeof(frames_[i]);
+            msgs_[i].msg_hdr.msg_iov = &iov_[i];
+            msgs_[i].msg_hdr.msg_iovlen = 1;
+        }
+        start_flow(STATE(wait_readable));
+    }
+
+    /// Stops reading from the socket. Must be called on the main executor.
+    void shutdown()
+    {
+        if (selectHelper_.is_empty())
+        {
+            // The first state did not run yet. It will see the closed fd and
+            // notify the barrier.
+            return;
+        }
+        auto *e = service()->executor();
+        if (e->is_selected(&selectHelper_))
+        {
+            e->unselect(&selectHelper_);
+        }
+        set_terminated();
+        notify_barrier();
+    }
+
+private:
+    /// @return the parent object.
+    SocketCanHubPort *port()
+    {
+        return static_cast<SocketCanHubPort *>(service());
+    }
+
+    /// Waits for the socket to have data.
+    Action wait_readable()
+    {
+        if (port()->fd() < 0)
+        {
+            // Closed before we got to run.
+            set_terminated();
+            notify_barrier();
+            return exit();
+        }
+        selectHelper_.reset(
+            Selectable::READ, port()->fd(), Selectable::MAX_PRIO);
+        selectHelper_.set_wakeup(this);
+        service()->executor()->select(&selectHelper_);
+        return wait_and_call(STATE(read_batch));
+    }
+
+    /// Reads all the frames that are available, up to BATCH_SIZE, and sends
+    /// them to the hub.
+    Action read_batch()
+    {
+        bool want_ts = (bool)port()->timestampCallback_;
+        for (unsigned i = 0; i < BATCH_SIZE; ++i)
+        {
+            msgs_[i].msg_hdr.msg_control = want_ts ? cmsg_[i].buf : nullptr;
+            msgs_[i].msg_hdr.msg_controllen = want_ts ? sizeof(cmsg_[i]) : 0;
+            msgs_[i].msg_hdr.msg_flags = 0;
+        }
+        int n = ::recvmmsg(
+            port()->fd(), msgs_, BATCH_SIZE, MSG_DONTWAIT, nullptr);
+        if (n < 0 &&
+            (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+        {
+            return call_immediately(STATE(wait_readable));
+        }
+        if (n <= 0)
+        {
+            return read_error();
+        }
+        ++port()->stats_.readCalls_;
+        CanHubFlow *hub = port()->hub_;
+        for (int i = 0; i < n; ++i)
+        {
+            if (msgs_[i].msg_len == 0)
+            {
+                // EOF on the stand-in sockets.
+                return read_error();
+            }
+            if (msgs_[i].msg_len != sizeof(struct can_frame))
+            {
+                // Not a classic CAN frame.
+                continue;
+            }
+            ++port()->stats_.framesRead_;
+            if (want_ts)
+            {
+                report_timestamp(i);
+            }
+            auto *b = hub->alloc();
+            b->data()->skipMember_ = port()->write_port();
+            *b->data()->mutable_frame() = frames_[i];
+            hub->send(b);
+        }
+        // If the batch was full, the select returns immediately. This lets
+        // other flows run in between.
+        return call_immediately(STATE(wait_readable));
+    }
+
+    /// Finds the kernel timestamp of a received frame and calls the
+    /// timestamp callback with it. @param i is the index of the frame in the
+    /// batch.
+    void report_timestamp(unsigned i)
+    {
+        long long hw = 0;
+        long long sw = 0;
+        struct msghdr *h = &msgs_[i].msg_hdr;
+        for (struct cmsghdr *c = CMSG_FIRSTHDR(h); c; c = CMSG_NXTHDR(h, c))
+        {
+            if (c->cmsg_level != SOL_SOCKET)
+            {
+                continue;
+            }
+            if (c->cmsg_type == SCM_TIMESTAMPING)
+            {
+                // [0] is software, [2] is raw hardware.
+                struct timespec ts[3];
+                memcpy(ts, CMSG_DATA(c), sizeof(ts));
+                if (ts[2].tv_sec || ts[2].tv_nsec)
+                {
+                    hw = to_nsec(ts[2]);
+                }
+                if (ts[0].tv_sec || ts[0].tv_nsec)
+                {
+                    sw = to_nsec(ts[0]);
+                }
+            }
+            else if (c->cmsg_type == SCM_TIMESTAMPNS && !sw)
+            {
+                struct timespec ts;
+                memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+                sw = to_nsec(ts);
+            }
+        }
+        if (hw || sw)
+        {
+            port()->timestampCallback_(frames_[i], hw ? hw : sw);
+        }
+    }
+
+    /// @return the nanoseconds in a timespec. @param ts timespec.
+    static long long to_nsec(const struct timespec &ts)
+    {
+        return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    }
+
+    /// Terminates the flow upon a read error or EOF. @return next action.
+    Action read_error()
+    {
+        set_terminated();
+        port()->report_read_error();
+        notify_barrier();
+        return exit();
+    }
+
+    /// Calls into the parent's barrier notify, but makes sure to only do this
+    /// once in the lifetime of *this.
+    void notify_barrier()
+    {
+        if (barrierOwned_)
+        {
+            barrierOwned_ = false;
+            port()->barrier_.notify();
+        }
+    }
+
+    /// Control message buffer for one datagram, large enough for both
+    /// SCM_TIMESTAMPING and SCM_TIMESTAMPNS.
+    union ControlBuffer
+    {
+        /// Raw storage.
+        char buf[CMSG_SPACE(3 * sizeof(struct timespec)) +
+            CMSG_SPACE(sizeof(struct timespec))];
+        /// Forces alignment.
+        struct cmsghdr align;
+    };
+
+    /// true iff pending parent->barrier_.notify()
+    bool barrierOwned_ {true};
+    /// Helper object for waiting for the socket to become readable.
+    StateFlowSelectHelper selectHelper_ {this};
+    /// Message headers for recvmmsg.
+    struct mmsghdr msgs_[BATCH_SIZE];
+    /// One iovec per message, pointing into frames_.
+    struct iovec iov_[BATCH_SIZE];
+    /// Received frames.
+    struct can_frame frames_[BATCH_SIZE];
+    /// Received control messages (timestamps).
+    ControlBuffer cmsg_[BATCH_SIZE];
+};
+
+/// State flow collecting frames from the hub and writing them to the socket
+/// in batches. If the hub has shared delivery turned on, it shares its
+/// buffers with this flow without copying.
+class SocketCanHubPort::WriteFlow : public SharedCanHubPort
+{
+public:
+    /// Constructor. @param port is the parent object.
+    WriteFlow(SocketCanHubPort *port)
+        : SharedCanHubPort(port)
+    {
+        memset(msgs_, 0, sizeof(msgs_));
+        for (unsigned i = 0; i < BATCH_SIZE; ++i)
+        {
+            iov_[i].iov_len = sizeof(struct can_frame);
+            msgs_[i].msg_hdr.msg_iov = &iov_[i];
+            msgs_[i].msg_hdr.msg_iovlen = 1;
+        }
+    }
+
+    /// Destructor.
+    ~WriteFlow()
+    {
+        HASSERT(is_waiting());
+        HASSERT(count_ == 0);
+    }
+
+    /// Wakes up the flow if it is waiting for the socket. Must be called on
+    /// the main executor, after the fd was closed.
+    void shutdown()
+    {
+        HASSERT(port()->fd() < 0);
+        auto *e = service()->executor();
+        if (!selectHelper_.is_empty() && e->is_selected(&selectHelper_))
+        {
+            e->unselect(&selectHelper_);
+            notify();
+        }
+        timer_.ensure_triggered();
+    }
+
+    Action entry() override
+    {
+        auto *b = transfer_message();
+        if (b->data()->skipMember_ == this)
+        {
+            // Shutdown marker from unregister_write_port. Released after the
+            // pending frames are done.
+            shutdownMarker_ = b;
+            return call_immediately(STATE(flush));
+        }
+        pending_[count_++] = b;
+        if (count_ >= BATCH_SIZE)
+        {
+            return call_immediately(STATE(flush));
+        }
+        if (!queue_empty())
+        {
+            // Collects more frames before writing.
+            return exit();
+        }
+        // The hub hands over frames one by one. Lets it run once more before
+        // we decide that the batch is complete.
+        return yield_and_call(STATE(maybe_flush));
+    }
+
+private:
+    /// @return the parent object.
+    SocketCanHubPort *port()
+    {
+        return static_cast<SocketCanHubPort *>(service());
+    }
+
+    /// Continues collecting frames if more arrived during the yield, otherwise
+    /// writes the batch.
+    Action maybe_flush()
+    {
+        if (!queue_empty())
+        {
+            return exit();
+        }
+        return call_immediately(STATE(flush));
+    }
+
+    /// Writes the pending frames to the socket.
+    Action flush()
+    {
+        int fd = port()->fd();
+        if (fd < 0 || sent_ >= count_)
+        {
+            return finish();
+        }
+        unsigned num = count_ - sent_;
+        for (unsigned i = 0; i < num; ++i)
+        {
+            iov_[i].iov_base = pending_[sent_ + i]->data()->mutable_frame();
+        }
+        int r = ::sendmmsg(fd, msgs_, num, MSG_DONTWAIT);
+        if (r > 0)
+        {
+            ++port()->stats_.writeCalls_;
+            port()->stats_.framesWritten_ += r;
+            sent_ += r;
+            return again();
+        }
+        if (r < 0 &&
+            (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+        {
+            selectHelper_.reset(Selectable::WRITE, fd, Selectable::MAX_PRIO);
+            selectHelper_.set_wakeup(this);
+            service()->executor()->select(&selectHelper_);
+            return wait_and_call(STATE(flush));
+        }
+        if (r < 0 && errno == ENOBUFS)
+        {
+            // The CAN interface's transmit queue is full. Select would report
+            // the socket writable, so we poll instead.
+            return sleep_and_call(&timer_, MSEC_TO_NSEC(1), STATE(flush));
+        }
+        release_pending();
+        port()->report_write_error();
+        return finish();
+    }
+
+    /// Releases the written frames and the shutdown marker. @return next
+    /// action.
+    Action finish()
+    {
+        release_pending();
+        if (shutdownMarker_)
+        {
+            shutdownMarker_->unref();
+            shutdownMarker_ = nullptr;
+        }
+        return exit();
+    }
+
+    /// Unrefs all pending buffers.
+    void release_pending()
+    {
+        for (unsigned i = 0; i < count_; ++i)
+        {
+            pending_[i]->unref();
+        }
+        count_ = 0;
+        sent_ = 0;
+    }
+
+    /// Helper object for waiting for the socket to become writable.
+    StateFlowSelectHelper selectHelper_ {this};
+    /// Helper for waiting when the kernel is out of buffers.
+    StateFlowTimer timer_ {this};
+    /// Frames to write. We own one reference to each.
+    Buffer<CanHubData> *pending_[BATCH_SIZE];
+    /// Message headers for sendmmsg.
+    struct mmsghdr msgs_[BATCH_SIZE];
+    /// One iovec per message, pointing into the pending buffers.
+    struct iovec iov_[BATCH_SIZE];
+    /// Buffer marking the unregistration of the port.
+    Buffer<CanHubData> *shutdownMarker_ {nullptr};
+    /// Number of entries in pending_.
+    unsigned count_ {0};
+    /// Number of entries in pending_ that are already written.
+    unsigned sent_ {0};
+};
+
+SocketCanHubPort::SocketCanHubPort(
+    CanHubFlow *hub, int fd, Notifiable *on_error)
+    : FdHubPortService(hub->service()->executor(), fd)
+    , hub_(hub)
+{
+    HASSERT(fd_ >= 0);
+    ::fcntl(fd_, F_SETFL, O_RDWR | O_NONBLOCK);
+    barrier_.reset(on_error ? on_error : EmptyNotifiable::DefaultInstance());
+    barrier_.new_child();
+    writeFlow_.reset(new WriteFlow(this));
+    readFlow_.reset(new ReadFlow(this));
+    isShared_ = hub_->register_device_port(writeFlow_.get());
+    isRegistered_ = true;
+}
+
+SocketCanHubPort::~SocketCanHubPort()
+{
+    if (fd_ >= 0)
+    {
+        unregister_write_port();
+        close_fd();
+    }
+    bool completed = false;
+    while (!completed)
+    {
+        executor()->sync_run([this, &completed]() {
+            if (barrier_.is_done() && writeFlow_->is_waiting())
+            {
+                completed = true;
+            }
+        });
+    }
+}
+
+CanHubPortInterface *SocketCanHubPort::write_port()
+{
+    return writeFlow_.get();
+}
+
+bool SocketCanHubPort::set_filters(
+    const struct can_filter *filters, unsigned count)
+{
+    return ::setsockopt(fd_, SOL_CAN_RAW, CAN_RAW_FILTER, filters,
+               count * sizeof(struct can_filter)) == 0;
+}
+
+std::vector<struct can_filter> SocketCanHubPort::openlcb_filters(
+    const uint16_t *aliases, unsigned count)
+{
+    using openlcb::CanDefs;
+    // Only extended data frames.
+    static constexpr uint32_t BASE_MASK = CAN_EFF_FLAG | CAN_RTR_FLAG;
+    std::vector<struct can_filter> ret;
+    auto add = [&ret](uint32_t id, uint32_t mask) {
+        struct can_filter f;
+        f.can_id = CAN_EFF_FLAG | id;
+        f.can_mask = BASE_MASK | mask;
+        ret.push_back(f);
+    };
+    // CAN control frames (CID, RID, AMD, AME, AMR, error information).
+    add(CanDefs::CONTROL_MSG << CanDefs::FRAME_TYPE_SHIFT,
+        CanDefs::FRAME_TYPE_MASK);
+    // Global and addressed messages. The destination of addressed messages is
+    // in the payload, so these cannot be filtered further.
+    add((CanDefs::NMRANET_MSG << CanDefs::FRAME_TYPE_SHIFT) |
+            (CanDefs::GLOBAL_ADDRESSED << CanDefs::CAN_FRAME_TYPE_SHIFT),
+        CanDefs::FRAME_TYPE_MASK | CanDefs::CAN_FRAME_TYPE_MASK);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        uint32_t dst = (CanDefs::NMRANET_MSG << CanDefs::FRAME_TYPE_SHIFT) |
+            ((uint32_t)aliases[i] << CanDefs::DST_SHIFT);
+        uint32_t dst_mask = CanDefs::FRAME_TYPE_MASK | CanDefs::DST_MASK;
+        // Datagram frame types 2 and 3 differ only in the lowest bit, as do
+        // 4 and 5.
+        uint32_t dg_mask = 6 << CanDefs::CAN_FRAME_TYPE_SHIFT;
+        add(dst |
+                (CanDefs::DATAGRAM_ONE_FRAME << CanDefs::CAN_FRAME_TYPE_SHIFT),
+            dst_mask | dg_mask);
+        add(dst |
+                (CanDefs::DATAGRAM_MIDDLE_FRAME
+                    << CanDefs::CAN_FRAME_TYPE_SHIFT),
+            dst_mask | dg_mask);
+        add(dst | (CanDefs::STREAM_DATA << CanDefs::CAN_FRAME_TYPE_SHIFT),
+            dst_mask | CanDefs::CAN_FRAME_TYPE_MASK);
+    }
+    return ret;
+}
+
+bool SocketCanHubPort::enable_rx_timestamps(TimestampCallback callback)
+{
+    bool ok = false;
+    executor()->sync_run([this, &ok, &callback]() {
+        if (fd_ < 0)
+        {
+            return;
+        }
+        int flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE |
+            SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE;
+        if (::setsockopt(fd_, SOL_SOCKET, SO_TIMESTAMPING, &flags,
+                sizeof(flags)) == 0)
+        {
+            ok = true;
+        }
+        // Some socket types (e.g. AF_UNIX) only deliver timestamps with this
+        // option.
+        int one = 1;
+        if (::setsockopt(
+                fd_, SOL_SOCKET, SO_TIMESTAMPNS, &one, sizeof(one)) == 0)
+        {
+            ok = true;
+        }
+        if (ok)
+        {
+            timestampCallback_ = std::move(callback);
+        }
+    });
+    return ok;
+}
+
+void SocketCanHubPort::report_write_error()
+{
+    readFlow_->shutdown();
+    unregister_write_port();
+    close_fd();
+}
+
+void SocketCanHubPort::report_read_error()
+{
+    unregister_write_port();
+    close_fd();
+}
+
+void SocketCanHubPort::unregister_write_port()
+{
+    {
+        AtomicHolder h(this);
+        if (!isRegistered_)
+        {
+            return;
+        }
+        isRegistered_ = false;
+    }
+    hub_->unregister_device_port(writeFlow_.get(), isShared_);
+    // The marker goes behind all pending frames in the write flow's queue,
+    // and pings the barrier once those are dealt with.
+    auto *b = writeFlow_->alloc();
+    b->data()->skipMember_ = write_port();
+    b->set_done(&barrier_);
+    writeFlow_->send(b);
+}
+
+void SocketCanHubPort::close_fd()
+{
+    int fd = -1;
+    {
+        AtomicHolder h(this);
+        fd = fd_;
+        if (fd < 0)
+        {
+            return;
+        }
+        fd_ = -1;
+    }
+    executor()->add(new CallbackExecutable([this, fd]() {
+        ::close(fd);
+        readFlow_->shutdown();
+        writeFlow_->shutdown();
+    }));
+}
+
+#endif // __linux__
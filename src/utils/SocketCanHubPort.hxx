@@ -0,0 +1,168 @@
+/** \copyright
+ * Copyright (c) 2026, OpenMRN contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file SocketCanHubPort.hxx
+ *
+ * CAN hub port for SocketCan sockets that reads and writes frames in batches.
+ *
+ * @author OpenMRN contributors
+ * @date 17 Oct 2026
+ */
+
+#ifndef _UTILS_SOCKETCANHUBPORT_HXX_
+#define _UTILS_SOCKETCANHUBPORT_HXX_
+
+#if defined(__linux__)
+
+#include <functional>
+#include <sys/socket.h>
+#include <vector>
+
+#include "executor/StateFlow.hxx"
+#include "utils/Hub.hxx"
+
+/// HubPort that connects a SocketCan socket (or any datagram socket carrying
+/// one struct can_frame per datagram) to a CanHubFlow.
+///
+/// Compared to HubDeviceSelect<CanHubFlow>, which needs one read or write
+/// syscall per frame, this port uses recvmmsg and sendmmsg to move up to
+/// BATCH_SIZE frames per syscall. Outgoing frames are written directly from
+/// the hub buffers. All processing happens on the hub's executor, using
+/// ExecutorBase::select().
+///
+/// Optionally the port can request receive timestamps from the kernel
+/// (SO_TIMESTAMPING, falling back to SO_TIMESTAMPNS) and install
+/// CAN_RAW_FILTER acceptance filters in the kernel.
+class SocketCanHubPort : public FdHubPortService, private Atomic
+{
+public:
+    /// Maximum number of frames transferred in one syscall.
+    static constexpr unsigned BATCH_SIZE = 32;
+
+    /// Callback for receive timestamps. Called on the hub's executor for
+    /// every incoming frame that carries a kernel timestamp, before the frame
+    /// is sent to the hub. @param frame is the received frame. @param ts_nsec
+    /// is the kernel timestamp (CLOCK_REALTIME, nanoseconds). Hardware
+    /// timestamps are preferred if the interface supplies them.
+    typedef std::function<void(const struct can_frame &frame, long long ts_nsec)>
+        TimestampCallback;
+
+    /// Counters for the syscalls and frames. Only accessed from the hub's
+    /// executor.
+    struct Stats
+    {
+        /// Number of recvmmsg calls that returned data.
+        unsigned readCalls_ {0};
+        /// Number of frames read.
+        unsigned framesRead_ {0};
+        /// Number of sendmmsg calls that sent data.
+        unsigned writeCalls_ {0};
+        /// Number of frames written.
+        unsigned framesWritten_ {0};
+    };
+
+    /// Creates a hub port for an opened socket.
+    ///
+    /// @param hub the hub to open the port on
+    /// @param fd the socket to read/write frames from/to. Ownership is
+    /// transferred; the socket will be put into nonblocking mode.
+    /// @param on_error notifiable that will be called when a write or read
+    /// error is encountered.
+    SocketCanHubPort(CanHubFlow *hub, int fd, Notifiable *on_error = nullptr);
+
+    /// Closes the socket and waits for the flows to exit.
+    ~SocketCanHubPort();
+
+    /// @return the write flow belonging to this device.
+    CanHubPortInterface *write_port();
+
+    /// Installs kernel acceptance filters on the CAN socket. Frames not
+    /// matching any filter are dropped by the kernel. Error frames are not
+    /// affected.
+    /// @param filters array of filters.
+    /// @param count number of entries in filters. Zero drops every frame.
+    /// @return true on success, false if the socket does not support
+    /// CAN_RAW_FILTER.
+    bool set_filters(const struct can_filter *filters, unsigned count);
+
+    /// Computes the kernel filters for an OpenLCB node that only needs the
+    /// traffic relevant to a given set of local aliases: all CAN control
+    /// frames, all global and addressed messages, and the datagram and stream
+    /// frames sent to the local aliases. Not suitable for a port of a hub
+    /// that routes traffic for other nodes.
+    /// @param aliases local node aliases.
+    /// @param count number of entries in aliases.
+    /// @return filters to be passed to set_filters().
+    static std::vector<struct can_filter> openlcb_filters(
+        const uint16_t *aliases, unsigned count);
+
+    /// Enables kernel receive timestamps.
+    /// @param callback will be invoked with the timestamp of each incoming
+    /// frame.
+    /// @return true if the socket accepted the timestamping request.
+    bool enable_rx_timestamps(TimestampCallback callback);
+
+    /// @return syscall and frame counters. Must be called on the hub's
+    /// executor.
+    const Stats &stats()
+    {
+        return stats_;
+    }
+
+protected:
+    void report_write_error() override;
+    void report_read_error() override;
+
+private:
+    class ReadFlow;
+    class WriteFlow;
+
+    /// Removes the current write port from the registry of the source hub.
+    void unregister_write_port();
+
+    /// Closes the socket and shuts down the flows.
+    void close_fd();
+
+    /// Hub whose data we are forwarding.
+    CanHubFlow *hub_;
+    /// Flow reading frames from the socket.
+    std::unique_ptr<ReadFlow> readFlow_;
+    /// Flow writing frames to the socket.
+    std::unique_ptr<WriteFlow> writeFlow_;
+    /// Called for every received frame with a kernel timestamp.
+    TimestampCallback timestampCallback_;
+    /// Syscall counters.
+    Stats stats_;
+    /// True when the write flow is registered in the hub. Protected by Atomic
+    /// this.
+    bool isRegistered_ {false};
+    /// True if the write flow was registered as a shared port.
+    bool isShared_ {false};
+};
+
+#endif // __linux__
+
+#endif // _UTILS_SOCKETCANHUBPORT_HXX_
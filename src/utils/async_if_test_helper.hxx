@@ -315,6 +315,12 @@ protected:
 namespace openlcb
 {
 
+/// Makes gtest print payloads the same way as strings.
+inline void PrintTo(const Payload &p, ::std::ostream *os)
+{
+    *os << ::testing::PrintToString(p.str());
+}
+
 static const NodeID TEST_NODE_ID = 0x02010d000003ULL;
 
 class LocalIf : public If
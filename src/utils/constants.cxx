@@ -164,6 +164,17 @@ DEFAULT_CONST(directhub_port_incoming_buffer_size, 1460);
 // how many 1460-byte packets per port we parse before waiting for output to
 // drain.
 DEFAULT_CONST(directhub_port_max_incoming_packets, 2);
+// About 18 gridconnect frames per source before yielding to other sources.
+DEFAULT_CONST(directhub_admission_quantum, 512);
+// Ports of a hub that are tracked separately by the admission stage.
+DEFAULT_CONST(directhub_admission_max_sources, 16);
+// A port's read flow has one caller waiting at a time.
+DEFAULT_CONST(directhub_admission_source_backlog, 4);
+
+// The main buffer pool never returns memory to the heap.
+DEFAULT_CONST(main_buffer_pool_trim_watermark, 0);
+// No per-thread buffer caches in the main buffer pool.
+DEFAULT_CONST(main_buffer_pool_thread_cache, 0);
 
 #ifdef ESP_PLATFORM
 /// Use a stack size of 3kb for SocketListener tasks.
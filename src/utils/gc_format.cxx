@@ -34,10 +34,23 @@
 //#define LOGLEVEL VERBOSE
 
 #include <stdint.h>
+#include <string.h>
 #include "utils/logging.h"
 #include "utils/gc_format.h"
 #include "can_frame.h"
 
+#if defined(GC_FORMAT_NO_SIMD)
+// Scalar code only.
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+/// Use the SSE2 kernels.
+#define GC_FORMAT_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+/// Use the NEON kernels.
+#define GC_FORMAT_NEON 1
+#endif
+
 extern "C" {
 
 /** Build an ASCII character representation of a nibble value (uppercase hex).
@@ -78,20 +91,204 @@ static int ascii_to_nibble(const char c)
     return -1;
 }
 
+/** Converts hex characters to bytes.
+    @param src hex characters (upper or lowercase).
+    @param nchars number of characters to convert; must be even, at most 16.
+    @param dst output bytes, nchars / 2 will be written.
+    @return 0 on success, -1 if there was a non-hex character.
+*/
+static int hex_decode(const char *src, unsigned nchars, uint8_t *dst)
+{
+#if defined(GC_FORMAT_SSE2) || defined(GC_FORMAT_NEON)
+    // Pads to a full vector. '0' is a valid digit.
+    char in[16];
+    memset(in, '0', sizeof(in));
+    memcpy(in, src, nchars);
+    uint8_t out[16];
+#if defined(GC_FORMAT_SSE2)
+    __m128i c = _mm_loadu_si128((const __m128i *)in);
+    __m128i is_digit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)),
+        _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+    __m128i lower = _mm_or_si128(c, _mm_set1_epi8(0x20));
+    __m128i is_alpha =
+        _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+            _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+    if (_mm_movemask_epi8(_mm_or_si128(is_digit, is_alpha)) != 0xFFFF)
+    {
+        return -1;
+    }
+    __m128i nib = _mm_or_si128(
+        _mm_and_si128(is_digit, _mm_sub_epi8(c, _mm_set1_epi8('0'))),
+        _mm_and_si128(
+            is_alpha, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+    // Each 16-bit lane has the high nibble in the low byte and the low nibble
+    // in the high byte.
+    __m128i bytes = _mm_or_si128(
+        _mm_slli_epi16(nib, 4), _mm_srli_epi16(nib, 8));
+    bytes = _mm_and_si128(bytes, _mm_set1_epi16(0xFF));
+    _mm_storeu_si128((__m128i *)out, _mm_packus_epi16(bytes, bytes));
+#else
+    uint8x16_t c = vld1q_u8((const uint8_t *)in);
+    uint8x16_t digit = vsubq_u8(c, vdupq_n_u8('0'));
+    uint8x16_t is_digit = vcltq_u8(digit, vdupq_n_u8(10));
+    uint8x16_t alpha =
+        vsubq_u8(vorrq_u8(c, vdupq_n_u8(0x20)), vdupq_n_u8('a'));
+    uint8x16_t is_alpha = vcltq_u8(alpha, vdupq_n_u8(6));
+    if (vminvq_u8(vorrq_u8(is_digit, is_alpha)) == 0)
+    {
+        return -1;
+    }
+    uint8x16_t nib = vorrq_u8(vandq_u8(is_digit, digit),
+        vandq_u8(is_alpha, vaddq_u8(alpha, vdupq_n_u8(10))));
+    uint8x8x2_t pairs = vuzp_u8(vget_low_u8(nib), vget_high_u8(nib));
+    // pairs.val[0] has the high nibbles, pairs.val[1] the low nibbles.
+    vst1_u8(out, vorr_u8(vshl_n_u8(pairs.val[0], 4), pairs.val[1]));
+#endif
+    memcpy(dst, out, nchars / 2);
+    return 0;
+#else
+    for (unsigned i = 0; i < nchars; i += 2)
+    {
+        int nh = ascii_to_nibble(src[i]);
+        int nl = ascii_to_nibble(src[i + 1]);
+        if (nh < 0 || nl < 0)
+        {
+            return -1;
+        }
+        *dst++ = (nh << 4) | nl;
+    }
+    return 0;
+#endif
+}
 
-int gc_format_parse(const char* buf, struct can_frame* can_frame)
+/** Converts bytes to uppercase hex characters.
+    @param src bytes to convert.
+    @param nbytes number of bytes, at most 8.
+    @param dst output buffer. Exactly 2 * nbytes characters are written.
+    @return dst + 2 * nbytes.
+*/
+static char *hex_encode(const uint8_t *src, unsigned nbytes, char *dst)
+{
+#if defined(GC_FORMAT_SSE2)
+    uint8_t in[8] = {0};
+    memcpy(in, src, nbytes);
+    __m128i x = _mm_loadl_epi64((const __m128i *)in);
+    __m128i mask = _mm_set1_epi8(0x0F);
+    __m128i hi = _mm_and_si128(_mm_srli_epi16(x, 4), mask);
+    __m128i lo = _mm_and_si128(x, mask);
+    __m128i nib = _mm_unpacklo_epi8(hi, lo);
+    __m128i c = _mm_add_epi8(nib, _mm_set1_epi8('0'));
+    c = _mm_add_epi8(c,
+        _mm_and_si128(
+            _mm_cmpgt_epi8(nib, _mm_set1_epi8(9)), _mm_set1_epi8('A' - '9' - 1)));
+    if (nbytes == 8)
+    {
+        _mm_storeu_si128((__m128i *)dst, c);
+    }
+    else if (nbytes == 4)
+    {
+        _mm_storel_epi64((__m128i *)dst, c);
+    }
+    else
+    {
+        // Does not write past the characters of a short payload.
+        char out[16];
+        _mm_storeu_si128((__m128i *)out, c);
+        memcpy(dst, out, 2 * nbytes);
+    }
+    return dst + 2 * nbytes;
+#elif defined(GC_FORMAT_NEON)
+    uint8_t in[8] = {0};
+    memcpy(in, src, nbytes);
+    uint8x8_t x = vld1_u8(in);
+    uint8x8x2_t nib = vzip_u8(vshr_n_u8(x, 4), vand_u8(x, vdup_n_u8(0x0F)));
+    uint8x16_t n = vcombine_u8(nib.val[0], nib.val[1]);
+    uint8x16_t c = vaddq_u8(n, vdupq_n_u8('0'));
+    c = vaddq_u8(c,
+        vandq_u8(vcgtq_u8(n, vdupq_n_u8(9)), vdupq_n_u8('A' - '9' - 1)));
+    if (nbytes == 8)
+    {
+        vst1q_u8((uint8_t *)dst, c);
+    }
+    else if (nbytes == 4)
+    {
+        vst1_u8((uint8_t *)dst, vget_low_u8(c));
+    }
+    else
+    {
+        // Does not write past the characters of a short payload.
+        uint8_t out[16];
+        vst1q_u8(out, c);
+        memcpy(dst, out, 2 * nbytes);
+    }
+    return dst + 2 * nbytes;
+#else
+    for (unsigned i = 0; i < nbytes; ++i)
+    {
+        *dst++ = nibble_to_ascii(src[i] >> 4);
+        *dst++ = nibble_to_ascii(src[i] & 0xf);
+    }
+    return dst;
+#endif
+}
+
+const char *gc_find_delimiter(const char *begin, const char *end)
+{
+#if defined(GC_FORMAT_SSE2)
+    __m128i colon = _mm_set1_epi8(':');
+    __m128i semicolon = _mm_set1_epi8(';');
+    while (end - begin >= 16)
+    {
+        __m128i c = _mm_loadu_si128((const __m128i *)begin);
+        int m = _mm_movemask_epi8(_mm_or_si128(
+            _mm_cmpeq_epi8(c, colon), _mm_cmpeq_epi8(c, semicolon)));
+        if (m)
+        {
+            return begin + __builtin_ctz(m);
+        }
+        begin += 16;
+    }
+#elif defined(GC_FORMAT_NEON)
+    uint8x16_t colon = vdupq_n_u8(':');
+    uint8x16_t semicolon = vdupq_n_u8(';');
+    while (end - begin >= 16)
+    {
+        uint8x16_t c = vld1q_u8((const uint8_t *)begin);
+        uint8x16_t m = vorrq_u8(vceqq_u8(c, colon), vceqq_u8(c, semicolon));
+        if (vmaxvq_u8(m))
+        {
+            break;
+        }
+        begin += 16;
+    }
+#endif
+    while (begin < end && *begin != ':' && *begin != ';')
+    {
+        ++begin;
+    }
+    return begin;
+}
+
+/** Parses a GridConnect packet with known length.
+    @param buf is the packet, the leading ':' may or may not be present.
+    @param end points to the terminating ';' or \0.
+    @param can_frame is the output frame.
+    @return 0 in case of success, -1 if there was a packet format error.
+*/
+static int parse_frame(
+    const char *buf, const char *end, struct can_frame *can_frame)
 {
     CLR_CAN_FRAME_ERR(*can_frame);
-    if (*buf == ':')
+    if (buf < end && *buf == ':')
     {
         // skip leading :
         ++buf;
     }
-    if (*buf == 'X')
+    if (buf < end && *buf == 'X')
     {
         SET_CAN_FRAME_EFF(*can_frame);
     }
-    else if (*buf == 'S') 
+    else if (buf < end && *buf == 'S')
     {
         CLR_CAN_FRAME_EFF(*can_frame);
     } else
@@ -102,23 +299,32 @@ int gc_format_parse(const char* buf, struct can_frame* can_frame)
     }
     buf++;
     uint32_t id = 0;
+    uint8_t id_bytes[4];
+    if (end - buf > 8 && (buf[8] == 'N' || buf[8] == 'R') &&
+        hex_decode(buf, 8, id_bytes) == 0)
+    {
+        // Fast path for the usual 29-bit identifiers.
+        id = ((uint32_t)id_bytes[0] << 24) | ((uint32_t)id_bytes[1] << 16) |
+            ((uint32_t)id_bytes[2] << 8) | id_bytes[3];
+        buf += 8;
+    }
     while (1)
     {
-        int nibble = ascii_to_nibble(*buf);
+        int nibble = buf < end ? ascii_to_nibble(*buf) : -1;
         if (nibble >= 0)
         {
             id <<= 4;
             id |= nibble;
             ++buf;
         }
-        else if (*buf == 'N')
+        else if (buf < end && *buf == 'N')
         {
             // end of ID, frame is coming.
             CLR_CAN_FRAME_RTR(*can_frame);
             ++buf;
             break;
         }
-        else if (*buf == 'R')
+        else if (buf < end && *buf == 'R')
         {
             // end of ID, remote frame is coming.
             SET_CAN_FRAME_RTR(*can_frame);
@@ -140,31 +346,66 @@ int gc_format_parse(const char* buf, struct can_frame* can_frame)
     { 
         SET_CAN_FRAME_ID(*can_frame, id);
     }
-    int index = 0;
-    while ((*buf != 0) && (*buf != ';'))
+    unsigned len = end - buf;
+    if ((len & 1) || len > 16 || hex_decode(buf, len, can_frame->data) < 0)
     {
-        int nh = ascii_to_nibble(*buf++);
-        int nl = ascii_to_nibble(*buf++);
-        if (nh < 0 || nl < 0)
-        {
-            SET_CAN_FRAME_ERR(*can_frame);
-            return -1;
-        }
-        can_frame->data[index++] = (nh << 4) | nl;
-    } // while parsing data
-    can_frame->can_dlc = index;
+        SET_CAN_FRAME_ERR(*can_frame);
+        return -1;
+    }
+    can_frame->can_dlc = len / 2;
     CLR_CAN_FRAME_ERR(*can_frame);
     return 0;
 }
 
-/// Helper function for appending to a buffer ONCE.
-///
-/// @param dst buffer to append data to
-/// @param value one character to append to.
-///
-static void output_single(char*& dst, char value)
+int gc_format_parse(const char* buf, struct can_frame* can_frame)
 {
-    *dst++ = value;
+    return parse_frame(buf, buf + strcspn(buf, ";"), can_frame);
+}
+
+unsigned gc_format_parse_batch(const char *buf, size_t len,
+    struct can_frame *frames, unsigned max_frames, size_t *consumed)
+{
+    const char *p = buf;
+    const char *end = buf + len;
+    unsigned count = 0;
+    while (count < max_frames)
+    {
+        const char *start = (const char *)memchr(p, ':', end - p);
+        if (!start)
+        {
+            // Only garbage left.
+            p = end;
+            break;
+        }
+        const char *d = gc_find_delimiter(start + 1, end);
+        if (d == end)
+        {
+            // Incomplete frame.
+            p = start;
+            break;
+        }
+        p = d;
+        if (*d == ':')
+        {
+            // Restarts the frame here.
+            continue;
+        }
+        ++p;
+        if (d - start > 32)
+        {
+            // Too long to be a valid frame.
+            continue;
+        }
+        if (parse_frame(start + 1, d, frames + count) == 0)
+        {
+            ++count;
+        }
+    }
+    if (consumed)
+    {
+        *consumed = p - buf;
+    }
+    return count;
 }
 
 /// Helper function for appending to a buffer TWICE. Used in the implementation
@@ -203,17 +444,38 @@ char* gc_format_generate(const struct can_frame* can_frame, char* buf, int doubl
         LOG(VERBOSE, "GC generate: incoming frame ERR.");
         return buf;
     }
-    void (*output)(char*& dst, char value);
-    if (double_format)
-    {
-        output = output_double;
-        output(buf, '!');
-    }
-    else
+    unsigned dlc = can_frame->can_dlc > 8 ? 8 : can_frame->can_dlc;
+    if (!double_format)
     {
-        output = output_single;
-        output(buf, ':');
+        // Fast path.
+        *buf++ = ':';
+        if (IS_CAN_FRAME_EFF(*can_frame))
+        {
+            uint32_t id = GET_CAN_FRAME_ID_EFF(*can_frame);
+            uint8_t id_bytes[4] = {(uint8_t)(id >> 24), (uint8_t)(id >> 16),
+                (uint8_t)(id >> 8), (uint8_t)id};
+            *buf++ = 'X';
+            buf = hex_encode(id_bytes, 4, buf);
+        }
+        else
+        {
+            uint32_t id = GET_CAN_FRAME_ID(*can_frame);
+            *buf++ = 'S';
+            *buf++ = nibble_to_ascii(id >> 8);
+            *buf++ = nibble_to_ascii(id >> 4);
+            *buf++ = nibble_to_ascii(id);
+        }
+        *buf++ = IS_CAN_FRAME_RTR(*can_frame) ? 'R' : 'N';
+        buf = hex_encode(can_frame->data, dlc, buf);
+        *buf++ = ';';
+        if (config_gc_generate_newlines() == CONSTANT_TRUE)
+        {
+            *buf++ = '\n';
+        }
+        return buf;
     }
+    void (*output)(char*& dst, char value) = output_double;
+    output(buf, '!');
     uint32_t id;
     int offset;
     if (IS_CAN_FRAME_EFF(*can_frame))
@@ -241,7 +503,7 @@ char* gc_format_generate(const struct can_frame* can_frame, char* buf, int doubl
     {
         output(buf, 'N');
     }
-    for (offset = 0; offset < can_frame->can_dlc; ++offset)
+    for (offset = 0; offset < (int)dlc; ++offset)
     {
         output(buf, nibble_to_ascii(can_frame->data[offset] >> 4));
         output(buf, nibble_to_ascii(can_frame->data[offset] & 0xf));
@@ -34,6 +34,8 @@
 #ifndef _UTILS_GC_FORMAT_H_
 #define _UTILS_GC_FORMAT_H_
 
+#include <stddef.h>
+
 #include "utils/constants.hxx"
 
 #ifdef __cplusplus
@@ -79,6 +81,35 @@ int gc_format_parse(const char* buf, struct can_frame* can_frame);
 */
 char* gc_format_generate(const struct can_frame* can_frame, char* buf, int double_format);
 
+/** Parses all complete GridConnect packets from a buffer of stream data (for
+    example the result of a read from a socket).
+
+    Characters outside of packets are skipped. Packets that fail to parse are
+    dropped. Parsing stops at the first incomplete packet at the end of the
+    buffer; the caller should present this incomplete packet again with the
+    subsequent data.
+
+    @param buf is the stream data.
+    @param len is the number of bytes in buf.
+    @param frames is the output array of CAN frames.
+    @param max_frames is the number of entries in frames.
+    @param consumed if not NULL, will be set to the number of bytes of buf
+    that were processed.
+
+    @return the number of frames filled in.
+*/
+unsigned gc_format_parse_batch(const char *buf, size_t len,
+    struct can_frame *frames, unsigned max_frames, size_t *consumed);
+
+/** Finds the next GridConnect packet delimiter (':' or ';').
+
+    @param begin is the first character to look at.
+    @param end is one past the last character to look at.
+
+    @return pointer to the first delimiter, or end if there is none.
+*/
+const char *gc_find_delimiter(const char *begin, const char *end);
+
 #ifdef __cplusplus
 }
 #endif
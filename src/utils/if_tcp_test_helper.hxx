@@ -30,7 +30,7 @@ public:
             LOG(INFO,
                 "[sent] 0x%012" PRIx64 " -> %012" PRIx64 " MTI %03x payload %s",
                 actual.src.id, actual.dst.id, actual.mti,
-                string_to_hex(actual.payload).c_str());
+                string_to_hex(actual.payload.str()).c_str());
         }
         send(*b->data(), priority);
         b->unref();